@@ -1,5 +1,5 @@
 #-------------------------------------------------------------------------------
-# Copyright (c) 2020-2022, Arm Limited. All rights reserved.
+# Copyright (c) 2020-2023, Arm Limited. All rights reserved.
 # Copyright (c) 2022 Cypress Semiconductor Corporation (an Infineon company)
 # or an affiliate of Cypress Semiconductor Corporation. All rights reserved.
 #
@@ -46,6 +46,11 @@ install(FILES       ${CMAKE_BINARY_DIR}/generated/interface/include/config_impl.
 
 install(FILES       ${INTERFACE_INC_DIR}/tfm_psa_call_pack.h
         DESTINATION ${INSTALL_INTERFACE_INC_DIR})
+
+if (CONFIG_TFM_CONNECTION_BASED_SERVICE_API)
+    install(FILES       ${INTERFACE_INC_DIR}/tfm_psa_conn_pool.h
+            DESTINATION ${INSTALL_INTERFACE_INC_DIR})
+endif()
 install(FILES       ${CMAKE_BINARY_DIR}/generated/interface/include/psa/framework_feature.h
         DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
 
@@ -53,6 +58,7 @@ if (TFM_PARTITION_NS_AGENT_MAILBOX)
     install(FILES       ${INTERFACE_INC_DIR}/multi_core/tfm_multi_core_api.h
                         ${INTERFACE_INC_DIR}/multi_core/tfm_ns_mailbox.h
                         ${INTERFACE_INC_DIR}/multi_core/tfm_mailbox.h
+                        ${INTERFACE_INC_DIR}/multi_core/tfm_mailbox_ring.h
                         ${INTERFACE_INC_DIR}/multi_core/tfm_ns_mailbox_test.h
                         ${CMAKE_BINARY_DIR}/generated/interface/include/tfm_mailbox_config.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
@@ -85,6 +91,7 @@ if (TFM_PARTITION_CRYPTO)
                         ${INTERFACE_INC_DIR}/psa/crypto_values.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR}/psa)
     install(FILES       ${INTERFACE_INC_DIR}/tfm_crypto_defs.h
+                        ${CMAKE_BINARY_DIR}/generated/interface/include/tfm_crypto_client_config.h
             DESTINATION ${INSTALL_INTERFACE_INC_DIR})
 endif()
 
@@ -121,6 +128,7 @@ if (TFM_PARTITION_NS_AGENT_MAILBOX)
                         ${INTERFACE_SRC_DIR}/multi_core/tfm_multi_core_ns_api.c
                         ${INTERFACE_SRC_DIR}/multi_core/tfm_multi_core_psa_ns_api.c
                         ${INTERFACE_SRC_DIR}/multi_core/tfm_ns_mailbox_thread.c
+                        ${INTERFACE_SRC_DIR}/multi_core/tfm_ns_mailbox_ring.c
             DESTINATION ${INSTALL_INTERFACE_SRC_DIR}/multi_core)
 endif()
 
@@ -133,6 +141,11 @@ if (TFM_PARTITION_NS_AGENT_TZ)
     endif()
 endif()
 
+if (CONFIG_TFM_CONNECTION_BASED_SERVICE_API)
+    install(FILES       ${INTERFACE_SRC_DIR}/tfm_psa_conn_pool.c
+            DESTINATION ${INSTALL_INTERFACE_SRC_DIR})
+endif()
+
 if (CONFIG_TFM_USE_TRUSTZONE)
     install(FILES       ${INTERFACE_SRC_DIR}/tfm_ns_interface.c.example
             DESTINATION ${INSTALL_INTERFACE_SRC_DIR})
@@ -64,6 +64,11 @@ set(PROJECT_CONFIG_HEADER_FILE          "${CMAKE_SOURCE_DIR}/config/config_base.
 ############################ Platform ##########################################
 
 set(NUM_MAILBOX_QUEUE_SLOT              1           CACHE BOOL      "Number of mailbox queue slots")
+set(TFM_MULTI_CORE_MAILBOX_RING         OFF         CACHE BOOL      "Whether to use the lock-free ring buffers as mailbox transport. NUM_MAILBOX_QUEUE_SLOT is then the ring depth and should be a power of 2")
+set(NUM_MAILBOX_NOTIFY_COALESCE         0           CACHE STRING    "Maximum number of NSPE mailbox requests coalesced into a single notification to SPE. 0 to notify SPE of each request")
+set(MAILBOX_INLINE_PAYLOAD_SIZE         0           CACHE STRING    "Size in bytes of the payload area in each mailbox queue slot. psa_call() vectors fitting in it are copied into the slot instead of passed by pointers. 0 to disable")
+set(MAILBOX_NS_BUF_CACHE_CLIENTS        0           CACHE STRING    "Number of non-secure clients whose recently validated buffers are cached by SPE memory access check. 0 to disable")
+set(MAILBOX_NS_BUF_CACHE_ENTRIES        4           CACHE STRING    "Number of non-secure buffers cached per client")
 set(TFM_PLAT_SPECIFIC_MULTI_CORE_COMM   OFF         CACHE BOOL      "Whether to use a platform specific inter-core communication instead of mailbox in dual-cpu topology")
 
 set(DEBUG_AUTHENTICATION                CHIP_DEFAULT CACHE STRING   "Debug authentication setting. [CHIP_DEFAULT, NONE, NS_ONLY, FULL")
@@ -110,6 +115,8 @@ set(TFM_PARTITION_INTERNAL_TRUSTED_STORAGE OFF      CACHE BOOL      "Enable Inte
 
 set(TFM_PARTITION_CRYPTO                OFF         CACHE BOOL      "Enable Crypto partition")
 set(CRYPTO_TFM_BUILTIN_KEYS_DRIVER      ON          CACHE BOOL      "Whether to allow crypto service to store builtin keys. Without this, ALL builtin keys must be stored in a platform-specific location")
+set(CRYPTO_KEY_CACHE_NUM                0           CACHE STRING    "Number of persistent key records cached from ITS by the Crypto service. 0 to disable")
+set(TFM_CRYPTO_COALESCE_BUF_SIZE        0           CACHE STRING    "Size in bytes of the buffer in client hash and MAC operations. Operations whose input fits in it are sent to the Crypto service as a single request. 0 to disable")
 
 set(TFM_PARTITION_INITIAL_ATTESTATION   OFF         CACHE BOOL      "Enable Initial Attestation partition")
 set(SYMMETRIC_INITIAL_ATTESTATION       OFF         CACHE BOOL      "Use symmetric crypto for inital attestation")
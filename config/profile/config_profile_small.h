@@ -145,6 +145,15 @@
 /* The maximal number of secure services that are connected or requested at the same time */
 #define CONFIG_TFM_CONN_HANDLE_MAX_NUM         3
 
+/* The number of non-secure contexts for NS client extension (TFM_NS_MANAGE_NSID) */
+#define CONFIG_TFM_NS_CTX_NUM                  1
+
+/* The number of NS threads holding a context for NS client extension */
+#define CONFIG_TFM_NS_THREAD_NUM               8
+
+/* Map the shared boot data into partitions instead of copying it */
+#define CONFIG_TFM_BOOT_DATA_ZERO_COPY         0
+
 /* Disable the doorbell APIs */
 #define CONFIG_TFM_DOORBELL_API                0
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2022 Cypress Semiconductor Corporation. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
@@ -33,6 +33,10 @@ extern "C" {
 #define MAILBOX_PSA_CONNECT                 (0x3)
 #define MAILBOX_PSA_CALL                    (0x4)
 #define MAILBOX_PSA_CLOSE                   (0x5)
+#define MAILBOX_PSA_CALL_INLINE             (0x6) /* psa_call() with its
+                                                   * vectors in the inline
+                                                   * payload of the slot
+                                                   */
 
 /* Return code of mailbox APIs */
 #define MAILBOX_SUCCESS                     (0)
@@ -89,6 +93,32 @@ struct mailbox_msg_t {
                                             */
 };
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/*
+ * Inline payload of a psa_call() sent as MAILBOX_PSA_CALL_INLINE.
+ * The data of the vectors is packed one after another in data[], input vectors
+ * first. Each output vector takes the space of its whole buffer size.
+ */
+struct mailbox_payload_t {
+    uint32_t size[PSA_MAX_IOVEC];           /* Sizes of the input vectors
+                                             * followed by the sizes of the
+                                             * output vectors. SPE updates the
+                                             * latter with the actual sizes in
+                                             * reply.
+                                             */
+    uint32_t nr_out_replied;                /* Number of output vectors written
+                                             * back by SPE. 0 if the call
+                                             * failed before reaching the
+                                             * service.
+                                             */
+    uint8_t  data[MAILBOX_INLINE_PAYLOAD_SIZE];
+};
+#endif
+
+#ifdef TFM_MULTI_CORE_MAILBOX_RING
+#include "tfm_mailbox_ring.h"
+#endif
+
 /*
  * Mailbox reply structure in non-secure memory
  * to hold the PSA client call return result from SPE
@@ -114,12 +144,43 @@ struct mailbox_reply_t {
 
 /* A single slot structure in NSPE mailbox queue */
 struct ns_mailbox_slot_t {
-    struct mailbox_msg_t   msg;
-    struct mailbox_reply_t reply;
+    struct mailbox_msg_t     msg;
+    struct mailbox_reply_t   reply;
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    struct mailbox_payload_t payload;
+#endif
 };
 
 typedef uint32_t   mailbox_queue_status_t;
 
+/* Statistics of the notifications sent to the peer */
+struct mailbox_notify_stats_t {
+    uint32_t nr_msgs;                       /* Number of the messages sent */
+    uint32_t nr_notify;                     /* Number of the notifications
+                                             * sent
+                                             */
+    uint32_t nr_coalesced;                  /* Number of the messages sent
+                                             * since the last notification
+                                             */
+};
+
+#ifdef TFM_MULTI_CORE_MAILBOX_RING
+/*
+ * NSPE mailbox queue made of the request and completion rings.
+ * The replies of the outstanding requests are kept in NSPE private memory.
+ */
+struct ns_mailbox_queue_t {
+    struct mailbox_req_ring_t req_ring;
+    struct mailbox_cpl_ring_t cpl_ring;
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    uint32_t                  inline_threshold; /* See the same field below */
+    struct mailbox_payload_t  payload[MAILBOX_RING_DEPTH];
+                                                /* Inline payload indexed by
+                                                 * the request token
+                                                 */
+#endif
+};
+#else /* TFM_MULTI_CORE_MAILBOX_RING */
 /* NSPE mailbox queue */
 struct ns_mailbox_queue_t {
     mailbox_queue_status_t   empty_slots;       /* Bitmask of empty slots */
@@ -147,7 +208,18 @@ struct ns_mailbox_queue_t {
 #endif
 
     bool                     is_full;           /* Queue if full */
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    uint32_t                 inline_threshold;  /* Maximum total size of the
+                                                 * vectors which NSPE sends as
+                                                 * inline payload. Set by
+                                                 * tfm_ns_mailbox_init(). The
+                                                 * platform may lower it in
+                                                 * tfm_ns_mailbox_hal_init().
+                                                 */
+#endif
 };
+#endif /* TFM_MULTI_CORE_MAILBOX_RING */
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Single-producer/single-consumer ring buffers shared by NSPE and SPE when
+ * TFM_MULTI_CORE_MAILBOX_RING is selected.
+ *
+ * NSPE produces PSA client call requests into the request ring and SPE
+ * consumes them. SPE produces the results into the completion ring and NSPE
+ * consumes them. Each index is written by one side only, so no lock is shared
+ * between the cores. Each side still has to serialize its own producers or
+ * consumers locally.
+ *
+ * The indexes are free-running. The number of entries in a ring is
+ * (head - tail), which also works when the indexes wrap around.
+ *
+ * This file is included by tfm_mailbox.h, after struct mailbox_msg_t.
+ *
+ * MAILBOX_RING_BARRIER() orders the accesses to the entries and to the
+ * indexes. It defaults to a DMB. Define it before including this file to build
+ * the ring elsewhere, such as in a host simulation.
+ */
+
+#ifndef __TFM_MAILBOX_RING_H__
+#define __TFM_MAILBOX_RING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tfm_mailbox_config.h"
+
+#ifndef MAILBOX_RING_BARRIER
+#include "cmsis_compiler.h"
+#define MAILBOX_RING_BARRIER()              __DMB()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (NUM_MAILBOX_QUEUE_SLOT & (NUM_MAILBOX_QUEUE_SLOT - 1)) != 0
+#error "Error: NUM_MAILBOX_QUEUE_SLOT should be a power of 2 for mailbox ring"
+#endif
+
+#define MAILBOX_RING_DEPTH                  NUM_MAILBOX_QUEUE_SLOT
+#define MAILBOX_RING_IDX_MASK               (MAILBOX_RING_DEPTH - 1)
+
+/* An entry of the request ring */
+struct mailbox_ring_req_t {
+    struct mailbox_msg_t msg;
+    uint32_t             token;     /* Chosen by NSPE and returned in the
+                                     * completion entry as it is
+                                     */
+};
+
+/* An entry of the completion ring */
+struct mailbox_ring_cpl_t {
+    int32_t              return_val;
+    uint32_t             token;     /* Token of the completed request */
+};
+
+/* Request ring, from NSPE to SPE */
+struct mailbox_req_ring_t {
+    volatile uint32_t         head;     /* Only written by NSPE */
+    volatile uint32_t         tail;     /* Only written by SPE */
+    volatile uint32_t         is_consumer_busy;
+                                        /* Only written by SPE. Set while SPE
+                                         * drains the ring, so that NSPE can
+                                         * skip notifying SPE of new requests.
+                                         */
+    struct mailbox_ring_req_t entries[MAILBOX_RING_DEPTH];
+};
+
+/* Completion ring, from SPE to NSPE */
+struct mailbox_cpl_ring_t {
+    volatile uint32_t         head;     /* Only written by SPE */
+    volatile uint32_t         tail;     /* Only written by NSPE */
+    struct mailbox_ring_cpl_t entries[MAILBOX_RING_DEPTH];
+};
+
+/*
+ * The number of entries in a ring. The indexes written by the peer are not
+ * trusted, so a value larger than the depth is reported as corrupted.
+ */
+static inline bool mailbox_ring_count(uint32_t head, uint32_t tail,
+                                      uint32_t *count)
+{
+    *count = head - tail;
+
+    return *count <= MAILBOX_RING_DEPTH;
+}
+
+/**
+ * \brief Produce a request into the request ring.
+ *
+ * \param[in] ring              The request ring
+ * \param[in] msg               The mailbox message of the request
+ * \param[in] token             The token of the request
+ *
+ * \retval true                 The request is in the ring.
+ * \retval false                The ring is full.
+ */
+static inline bool mailbox_req_ring_put(struct mailbox_req_ring_t *ring,
+                                        const struct mailbox_msg_t *msg,
+                                        uint32_t token)
+{
+    uint32_t head = ring->head;
+    uint32_t count;
+    struct mailbox_ring_req_t *entry;
+
+    if (!mailbox_ring_count(head, ring->tail, &count) ||
+        (count == MAILBOX_RING_DEPTH)) {
+        return false;
+    }
+
+    entry = &ring->entries[head & MAILBOX_RING_IDX_MASK];
+    memcpy(&entry->msg, msg, sizeof(entry->msg));
+    entry->token = token;
+
+    /* The entry must be visible before the new head */
+    MAILBOX_RING_BARRIER();
+    ring->head = head + 1;
+
+    return true;
+}
+
+/**
+ * \brief Consume a request from the request ring.
+ *
+ * \param[in]  ring             The request ring
+ * \param[out] msg              Buffer for the mailbox message. The message is
+ *                              copied so that the producer cannot modify it
+ *                              afterwards.
+ * \param[out] token            The token of the request
+ *
+ * \retval true                 A request is copied into \p msg and \p token.
+ * \retval false                The ring is empty or corrupted.
+ */
+static inline bool mailbox_req_ring_get(struct mailbox_req_ring_t *ring,
+                                        struct mailbox_msg_t *msg,
+                                        uint32_t *token)
+{
+    uint32_t tail = ring->tail;
+    uint32_t count;
+    const struct mailbox_ring_req_t *entry;
+
+    if (!mailbox_ring_count(ring->head, tail, &count) || (count == 0)) {
+        return false;
+    }
+
+    /* Read the entry only after the head which published it */
+    MAILBOX_RING_BARRIER();
+    entry = &ring->entries[tail & MAILBOX_RING_IDX_MASK];
+    memcpy(msg, &entry->msg, sizeof(*msg));
+    *token = entry->token;
+
+    /* The entry must be read before it is given back to the producer */
+    MAILBOX_RING_BARRIER();
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+/**
+ * \brief Mark whether SPE is draining the request ring.
+ *
+ * \param[in] ring              The request ring
+ * \param[in] is_busy           True before SPE starts draining the ring.
+ *                              False after SPE has drained it. SPE should
+ *                              check \ref mailbox_req_ring_is_empty afterwards
+ *                              since requests may have been put in between.
+ */
+static inline void mailbox_req_ring_set_consumer_busy(
+                                            struct mailbox_req_ring_t *ring,
+                                            bool is_busy)
+{
+    ring->is_consumer_busy = is_busy ? 1 : 0;
+}
+
+/**
+ * \brief Check whether SPE is draining the request ring.
+ *        NSPE calls it after putting a request.
+ *
+ * \param[in] ring              The request ring
+ *
+ * \retval true                 SPE will see the request without notification.
+ * \retval false                SPE should be notified of the request.
+ */
+static inline bool mailbox_req_ring_is_consumer_busy(
+                                            struct mailbox_req_ring_t *ring)
+{
+    /*
+     * The new head must be visible before the flag is read. Paired with the
+     * barrier in mailbox_req_ring_is_empty(), either NSPE sees SPE idle or SPE
+     * sees the new request.
+     */
+    MAILBOX_RING_BARRIER();
+
+    return ring->is_consumer_busy != 0;
+}
+
+/**
+ * \brief Check whether the request ring is empty.
+ *
+ * \param[in] ring              The request ring
+ *
+ * \retval true                 The ring is empty or corrupted.
+ * \retval false                There are requests in the ring.
+ */
+static inline bool mailbox_req_ring_is_empty(struct mailbox_req_ring_t *ring)
+{
+    uint32_t count;
+
+    /* The cleared busy flag must be visible before the head is read */
+    MAILBOX_RING_BARRIER();
+
+    if (!mailbox_ring_count(ring->head, ring->tail, &count)) {
+        return true;
+    }
+
+    return count == 0;
+}
+
+/**
+ * \brief Produce a completion into the completion ring.
+ *
+ * \param[in] ring              The completion ring
+ * \param[in] token             The token of the completed request
+ * \param[in] return_val        The PSA client call result
+ *
+ * \retval true                 The completion is in the ring.
+ * \retval false                The ring is full or corrupted.
+ */
+static inline bool mailbox_cpl_ring_put(struct mailbox_cpl_ring_t *ring,
+                                        uint32_t token, int32_t return_val)
+{
+    uint32_t head = ring->head;
+    uint32_t count;
+    struct mailbox_ring_cpl_t *entry;
+
+    if (!mailbox_ring_count(head, ring->tail, &count) ||
+        (count == MAILBOX_RING_DEPTH)) {
+        return false;
+    }
+
+    entry = &ring->entries[head & MAILBOX_RING_IDX_MASK];
+    entry->return_val = return_val;
+    entry->token = token;
+
+    /* The entry must be visible before the new head */
+    MAILBOX_RING_BARRIER();
+    ring->head = head + 1;
+
+    return true;
+}
+
+/**
+ * \brief Consume a completion from the completion ring.
+ *
+ * \param[in]  ring             The completion ring
+ * \param[out] cpl              Buffer for the completion
+ *
+ * \retval true                 A completion is copied into \p cpl.
+ * \retval false                The ring is empty or corrupted.
+ */
+static inline bool mailbox_cpl_ring_get(struct mailbox_cpl_ring_t *ring,
+                                        struct mailbox_ring_cpl_t *cpl)
+{
+    uint32_t tail = ring->tail;
+    uint32_t count;
+
+    if (!mailbox_ring_count(ring->head, tail, &count) || (count == 0)) {
+        return false;
+    }
+
+    /* Read the entry only after the head which published it */
+    MAILBOX_RING_BARRIER();
+    memcpy(cpl, &ring->entries[tail & MAILBOX_RING_IDX_MASK], sizeof(*cpl));
+
+    /* The entry must be read before it is given back to the producer */
+    MAILBOX_RING_BARRIER();
+    ring->tail = tail + 1;
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_MAILBOX_RING_H__ */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -12,6 +12,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "tfm_mailbox.h"
 
@@ -23,6 +24,11 @@ extern "C" {
 #error "NUM_MAILBOX_QUEUE_SLOT should be set to 1 for NS bare metal environment"
 #endif
 
+#if defined(TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT) && \
+    !defined(TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD)
+#error "TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT requires NS mailbox thread model"
+#endif
+
 /**
  * \brief NSPE mailbox initialization
  *
@@ -53,7 +59,21 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
                                    int32_t client_id,
                                    int32_t *reply);
 
-#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD
+/**
+ * \brief Get the statistics of the notifications sent to SPE.
+ *        The average number of requests per notification is
+ *        nr_msgs / nr_notify.
+ *
+ * \param[out] stats            The buffer to be written with
+ *                              \ref mailbox_notify_stats_t.
+ *
+ * \retval MAILBOX_SUCCESS      Operation succeeded.
+ * \retval Other return code    Operation failed with an error code.
+ */
+int32_t tfm_ns_mailbox_get_notify_stats(struct mailbox_notify_stats_t *stats);
+
+#if defined(TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD) && \
+    !defined(TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT)
 /**
  * \brief Handling PSA client calls in a dedicated NS mailbox thread.
  *        This function constructs NS mailbox messages, transmits them to SPE
@@ -223,6 +243,36 @@ int32_t tfm_ns_mailbox_os_mq_send(void *mq_handle, const void *msg_ptr);
  */
 int32_t tfm_ns_mailbox_os_mq_receive(void *mq_handle, void *msg_ptr);
 
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+/**
+ * \brief Create and initialize a semaphore. The semaphore is initially not
+ *        available.
+ *
+ * \return Returns handle of the semaphore created, or NULL in case of error
+ */
+void *tfm_ns_mailbox_os_sem_create(void);
+
+/**
+ * \brief Wait until a semaphore is available and take it.
+ *
+ * \param[in] sem_handle      The handle of semaphore
+ *
+ * \return \ref MAILBOX_SUCCESS if the semaphore is taken, or other return
+ *         code in case of error
+ */
+int32_t tfm_ns_mailbox_os_sem_wait(void *sem_handle);
+
+/**
+ * \brief Make a semaphore available, in a mailbox IRQ handler.
+ *
+ * \note The underlying NS OS specific function called inside this function
+ *       should be able to work in an IRQ handler.
+ *
+ * \param[in] sem_handle      The handle of semaphore
+ */
+void tfm_ns_mailbox_os_sem_post_isr(void *sem_handle);
+#endif /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
+
 /**
  * \brief Go through mailbox messages already replied by SPE mailbox and
  *        wake up the owner tasks of replied mailbox messages.
@@ -286,6 +336,7 @@ static inline int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
 #define tfm_ns_mailbox_os_spin_unlock() do {} while (0)
 #endif /* TFM_MULTI_CORE_NS_OS */
 
+#ifndef TFM_MULTI_CORE_MAILBOX_RING
 /* The following inline functions configure non-secure mailbox queue status */
 static inline void clear_queue_slot_empty(struct ns_mailbox_queue_t *queue_ptr,
                                           uint8_t idx)
@@ -309,6 +360,143 @@ static inline void clear_queue_slot_all_replied(
 {
     queue_ptr->replied_slots &= ~status;
 }
+#endif /* TFM_MULTI_CORE_MAILBOX_RING */
+
+/*
+ * Account a new request and decide whether SPE should be notified of it.
+ * It should be called in the same critical section which submits the request.
+ * If SPE is still handling the mailbox, it will see the request without a
+ * notification. See NUM_MAILBOX_NOTIFY_COALESCE.
+ */
+static inline bool ns_mailbox_req_need_notify(
+                                        struct mailbox_notify_stats_t *stats,
+                                        bool is_peer_busy)
+{
+    stats->nr_msgs++;
+    stats->nr_coalesced++;
+
+#if NUM_MAILBOX_NOTIFY_COALESCE > 1
+    if (is_peer_busy && (stats->nr_coalesced < NUM_MAILBOX_NOTIFY_COALESCE)) {
+        return false;
+    }
+#else
+    (void)is_peer_busy;
+#endif
+
+    stats->nr_coalesced = 0;
+    stats->nr_notify++;
+
+    return true;
+}
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/*
+ * Check whether the vectors of a psa_call() fit in the inline payload.
+ * threshold is the negotiated inline_threshold of the queue.
+ */
+static inline bool ns_mailbox_inline_payload_fits(
+                                    const struct psa_client_params_t *params,
+                                    uint32_t threshold)
+{
+    const psa_invec *in_vec = params->psa_call_params.in_vec;
+    const psa_outvec *out_vec = params->psa_call_params.out_vec;
+    size_t in_len = params->psa_call_params.in_len;
+    size_t out_len = params->psa_call_params.out_len;
+    size_t total = 0;
+    size_t i;
+
+    if ((in_len > PSA_MAX_IOVEC) || (out_len > PSA_MAX_IOVEC - in_len) ||
+        ((in_len > 0) && !in_vec) || ((out_len > 0) && !out_vec)) {
+        return false;
+    }
+
+    for (i = 0; i < in_len; i++) {
+        if (in_vec[i].len > threshold - total) {
+            return false;
+        }
+        total += in_vec[i].len;
+    }
+
+    for (i = 0; i < out_len; i++) {
+        if (out_vec[i].len > threshold - total) {
+            return false;
+        }
+        total += out_vec[i].len;
+    }
+
+    return true;
+}
+
+/*
+ * Copy the vectors of a psa_call() into the inline payload.
+ * The vectors should have been checked by ns_mailbox_inline_payload_fits().
+ */
+static inline void ns_mailbox_pack_inline_payload(
+                                    struct mailbox_payload_t *payload,
+                                    const struct psa_client_params_t *params)
+{
+    const psa_invec *in_vec = params->psa_call_params.in_vec;
+    const psa_outvec *out_vec = params->psa_call_params.out_vec;
+    size_t in_len = params->psa_call_params.in_len;
+    size_t out_len = params->psa_call_params.out_len;
+    size_t offset = 0;
+    size_t i;
+
+    for (i = 0; i < in_len; i++) {
+        if (in_vec[i].len > 0) {
+            memcpy(&payload->data[offset], in_vec[i].base, in_vec[i].len);
+        }
+        payload->size[i] = (uint32_t)in_vec[i].len;
+        offset += in_vec[i].len;
+    }
+
+    for (i = 0; i < out_len; i++) {
+        payload->size[in_len + i] = (uint32_t)out_vec[i].len;
+    }
+
+    payload->nr_out_replied = 0;
+}
+
+/*
+ * Copy the output vectors replied by SPE back to the client and update their
+ * sizes. The layout is recalculated from the client vectors, so SPE can only
+ * shrink an output vector.
+ */
+static inline void ns_mailbox_unpack_inline_payload(
+                                    const struct mailbox_payload_t *payload,
+                                    const struct psa_client_params_t *params)
+{
+    const psa_invec *in_vec = params->psa_call_params.in_vec;
+    psa_outvec *out_vec = params->psa_call_params.out_vec;
+    size_t in_len = params->psa_call_params.in_len;
+    size_t out_len = params->psa_call_params.out_len;
+    size_t offset = 0;
+    size_t len;
+    size_t i;
+
+    if (payload->nr_out_replied != out_len) {
+        return;
+    }
+
+    for (i = 0; i < in_len; i++) {
+        offset += in_vec[i].len;
+    }
+
+    for (i = 0; i < out_len; i++) {
+        len = payload->size[in_len + i];
+        if (len > out_vec[i].len) {
+            len = out_vec[i].len;
+        }
+
+        if (len > 0) {
+            memcpy(out_vec[i].base, &payload->data[offset], len);
+        }
+
+        offset += out_vec[i].len;
+        out_vec[i].len = len;
+    }
+}
+#endif /* MAILBOX_INLINE_PAYLOAD_SIZE > 0 */
 
 #ifdef __cplusplus
 }
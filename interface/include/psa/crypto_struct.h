@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -44,9 +44,31 @@ extern "C" {
  * exposed to the NS client.
  */
 
+/*
+ * Size of the buffer in a hash or MAC operation which keeps the input of the
+ * client, so that setup, update and finish are sent to the Crypto service as
+ * a single request when the whole input fits. 0 disables it. The value is
+ * exported from the SPE build in tfm_crypto_client_config.h.
+ */
+#include "tfm_crypto_client_config.h"
+
+#ifndef TFM_CRYPTO_COALESCE_BUF_SIZE
+#define TFM_CRYPTO_COALESCE_BUF_SIZE 0
+#endif
+
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > UINT16_MAX
+#error "TFM_CRYPTO_COALESCE_BUF_SIZE is too large"
+#endif
+
 struct psa_hash_operation_s
 {
     uint32_t handle;
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    psa_algorithm_t alg;
+    uint16_t coalesced_len;
+    uint8_t coalesce_state;
+    uint8_t coalesced[TFM_CRYPTO_COALESCE_BUF_SIZE];
+#endif
 };
 
 #define PSA_HASH_OPERATION_INIT {0}
@@ -59,6 +81,13 @@ static inline struct psa_hash_operation_s psa_hash_operation_init(void)
 struct psa_mac_operation_s
 {
     uint32_t handle;
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    psa_key_id_t key;
+    psa_algorithm_t alg;
+    uint16_t coalesced_len;
+    uint8_t coalesce_state;
+    uint8_t coalesced[TFM_CRYPTO_COALESCE_BUF_SIZE];
+#endif
 };
 
 #define PSA_MAC_OPERATION_INIT {0}
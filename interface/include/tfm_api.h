@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -40,6 +40,18 @@ extern "C" {
 /* The mask used for timeout values */
 #define PSA_TIMEOUT_MASK        PSA_BLOCK
 
+/*
+ * TF-M specific message type to reset the state of an established connection.
+ * A client sends it through psa_call() with no vectors on a connection-based
+ * handle. It is only delivered to the RoT Services which set
+ * "connection_reset" to "enable" in their manifest, SPM returns
+ * PSA_ERROR_NOT_SUPPORTED for the others. The RoT Service frees the state
+ * referenced by the rhandle and replies PSA_SUCCESS, after which the
+ * connection can be reused as a fresh one. If the reset fails, the client
+ * should close the connection instead.
+ */
+#define TFM_IPC_RESET           (-3)
+
 /* FixMe: sort out DEBUG compile option and limit return value options
  * on external interfaces */
 enum tfm_status_e
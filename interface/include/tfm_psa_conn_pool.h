@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_PSA_CONN_POOL_H__
+#define __TFM_PSA_CONN_POOL_H__
+
+#include <stdint.h>
+#include "psa/client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A connection tracked by the pool */
+struct tfm_conn_pool_entry_t {
+    uint32_t     sid;           /* RoT Service ID of the connection         */
+    uint32_t     version;       /* Requested version of the RoT Service     */
+    psa_handle_t handle;        /* Connection handle. PSA_NULL_HANDLE if the
+                                 * entry is empty
+                                 */
+    uint32_t     in_use;        /* Whether the connection is held by client */
+};
+
+/* Connection pool */
+struct tfm_conn_pool_t {
+    struct tfm_conn_pool_entry_t *entries;  /* Entries provided by the user */
+    uint32_t num_entries;                   /* Number of entries            */
+    uint32_t hits;          /* Connections reused from the idle connections */
+    uint32_t misses;        /* Connections established by psa_connect()     */
+};
+
+/**
+ * \brief Initialize a connection pool
+ *
+ * \details The pool keeps idle connections to connection-based RoT Services
+ *          for each (SID, version) pair, so that repeated
+ *          psa_connect()/psa_close() cycles are replaced by reusing an idle
+ *          connection. A released connection is reset by a
+ *          \ref TFM_IPC_RESET message before it is put back into the pool.
+ *
+ *          A pool is not protected against concurrent access. Each NS thread
+ *          should use its own pool, or the caller should serialize the
+ *          accesses to a shared pool.
+ *
+ * \param[out] pool         The pool to initialize
+ * \param[in]  entries      Storage of the pool entries
+ * \param[in]  num_entries  Number of the entries in \p entries
+ */
+void tfm_conn_pool_init(struct tfm_conn_pool_t *pool,
+                        struct tfm_conn_pool_entry_t *entries,
+                        uint32_t num_entries);
+
+/**
+ * \brief Get a connection to a RoT Service from the pool
+ *
+ * \details An idle connection with the same SID and version is reused if
+ *          there is any. Otherwise a new connection is established by
+ *          psa_connect(), and it is tracked by the pool if there is an empty
+ *          entry.
+ *
+ * \param[in] pool          The pool
+ * \param[in] sid           RoT Service identity
+ * \param[in] version       The version of the RoT Service
+ *
+ * \return The return value of psa_connect() if a new connection is needed,
+ *         otherwise the handle of the reused connection.
+ */
+psa_handle_t tfm_conn_pool_connect(struct tfm_conn_pool_t *pool,
+                                   uint32_t sid, uint32_t version);
+
+/**
+ * \brief Give a connection back to the pool
+ *
+ * \details The connection is reset and kept idle for a later
+ *          \ref tfm_conn_pool_connect. It is closed instead if it is not
+ *          tracked by the pool, or if the RoT Service does not enable
+ *          "connection_reset" in its manifest or fails the reset.
+ *
+ * \param[in] pool          The pool
+ * \param[in] handle        A handle returned by \ref tfm_conn_pool_connect
+ */
+void tfm_conn_pool_close(struct tfm_conn_pool_t *pool, psa_handle_t handle);
+
+/**
+ * \brief Close all the idle connections in the pool
+ *
+ * \param[in] pool          The pool
+ */
+void tfm_conn_pool_flush(struct tfm_conn_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TFM_PSA_CONN_POOL_H__ */
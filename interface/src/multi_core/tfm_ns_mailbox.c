@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -15,6 +15,14 @@
 /* The pointer to NSPE mailbox queue */
 static struct ns_mailbox_queue_t *mailbox_queue_ptr = NULL;
 
+/* Protected by NSPE mailbox critical section */
+static struct mailbox_notify_stats_t notify_stats;
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/* Inline payload threshold negotiated in tfm_ns_mailbox_init() */
+static uint32_t inline_threshold;
+#endif
+
 static int32_t mailbox_wait_reply(uint8_t idx);
 
 static inline void set_queue_slot_empty(uint8_t idx)
@@ -70,25 +78,24 @@ static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
     uint8_t idx;
     mailbox_queue_status_t status;
 
+    /*
+     * The slot is found and taken under the same lock. Otherwise two threads
+     * may find the same empty slot.
+     */
     tfm_ns_mailbox_os_spin_lock();
-    status = queue->empty_slots;
-    tfm_ns_mailbox_os_spin_unlock();
 
-    if (!status) {
-        /* No empty slot */
-        return NUM_MAILBOX_QUEUE_SLOT;
-    }
+    status = queue->empty_slots;
 
     for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
         if (status & (1 << idx)) {
+            clear_queue_slot_empty(queue, idx);
             break;
         }
     }
 
-    tfm_ns_mailbox_os_spin_lock();
-    clear_queue_slot_empty(queue, idx);
     tfm_ns_mailbox_os_spin_unlock();
 
+    /* NUM_MAILBOX_QUEUE_SLOT if there is no empty slot */
     return idx;
 }
 
@@ -107,6 +114,7 @@ static int32_t mailbox_tx_client_req(uint32_t call_type,
     uint8_t idx;
     struct mailbox_msg_t *msg_ptr;
     const void *task_handle;
+    bool is_notify;
 
     idx = acquire_empty_slot(mailbox_queue_ptr);
     if (idx >= NUM_MAILBOX_QUEUE_SLOT) {
@@ -124,6 +132,13 @@ static int32_t mailbox_tx_client_req(uint32_t call_type,
     memcpy(&msg_ptr->params, params, sizeof(msg_ptr->params));
     msg_ptr->client_id = client_id;
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    if (call_type == MAILBOX_PSA_CALL_INLINE) {
+        ns_mailbox_pack_inline_payload(&mailbox_queue_ptr->queue[idx].payload,
+                                       params);
+    }
+#endif
+
     /*
      * Fetch the current task handle. The task will be woken up according the
      * handle value set in the owner field.
@@ -132,10 +147,18 @@ static int32_t mailbox_tx_client_req(uint32_t call_type,
     set_msg_owner(idx, task_handle);
 
     tfm_ns_mailbox_hal_enter_critical();
+    /*
+     * SPE keeps handling until no slot is pending. If some slots are still
+     * pending, SPE will also take this one.
+     */
+    is_notify = ns_mailbox_req_need_notify(&notify_stats,
+                                           mailbox_queue_ptr->pend_slots != 0);
     set_queue_slot_pend(mailbox_queue_ptr, idx);
     tfm_ns_mailbox_hal_exit_critical();
 
-    tfm_ns_mailbox_hal_notify_peer();
+    if (is_notify) {
+        tfm_ns_mailbox_hal_notify_peer();
+    }
 
     *slot_idx = idx;
 
@@ -182,6 +205,14 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
         return MAILBOX_QUEUE_FULL;
     }
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* Small vectors are copied into the slot so SPE needs no pointer check */
+    if ((call_type == MAILBOX_PSA_CALL) &&
+        ns_mailbox_inline_payload_fits(params, inline_threshold)) {
+        call_type = MAILBOX_PSA_CALL_INLINE;
+    }
+#endif
+
     /* It requires SVCall if NS mailbox is put in privileged mode. */
     ret = mailbox_tx_client_req(call_type, params, client_id, &slot_idx);
     if (ret != MAILBOX_SUCCESS) {
@@ -190,6 +221,15 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
 
     mailbox_wait_reply(slot_idx);
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* The slot is still owned until the reply is received below */
+    if (call_type == MAILBOX_PSA_CALL_INLINE) {
+        ns_mailbox_unpack_inline_payload(
+                                &mailbox_queue_ptr->queue[slot_idx].payload,
+                                params);
+    }
+#endif
+
     /* It requires SVCall if NS mailbox is put in privileged mode. */
     ret = mailbox_rx_client_reply(slot_idx, &reply_buf);
     if (ret == MAILBOX_SUCCESS) {
@@ -204,6 +244,19 @@ exit:
     return ret;
 }
 
+int32_t tfm_ns_mailbox_get_notify_stats(struct mailbox_notify_stats_t *stats)
+{
+    if (!stats) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    tfm_ns_mailbox_hal_enter_critical();
+    memcpy(stats, &notify_stats, sizeof(*stats));
+    tfm_ns_mailbox_hal_exit_critical();
+
+    return MAILBOX_SUCCESS;
+}
+
 #ifdef TFM_MULTI_CORE_NS_OS
 int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
 {
@@ -323,6 +376,7 @@ int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
      */
 
     memset(queue, 0, sizeof(*queue));
+    memset(&notify_stats, 0, sizeof(notify_stats));
 
     /* Initialize empty bitmask */
     queue->empty_slots =
@@ -330,6 +384,10 @@ int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
     queue->empty_slots +=
             (mailbox_queue_status_t)(1UL << (NUM_MAILBOX_QUEUE_SLOT - 1));
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    queue->inline_threshold = MAILBOX_INLINE_PAYLOAD_SIZE;
+#endif
+
     mailbox_queue_ptr = queue;
 
     /* Platform specific initialization. */
@@ -338,6 +396,14 @@ int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
         return ret;
     }
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* The platform can only lower the threshold */
+    inline_threshold = queue->inline_threshold;
+    if (inline_threshold > MAILBOX_INLINE_PAYLOAD_SIZE) {
+        inline_threshold = MAILBOX_INLINE_PAYLOAD_SIZE;
+    }
+#endif
+
     ret = tfm_ns_mailbox_os_lock_init();
 
 #ifdef TFM_MULTI_CORE_TEST
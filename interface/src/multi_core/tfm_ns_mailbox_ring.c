@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * NSPE mailbox over the lock-free request and completion rings.
+ * It replaces tfm_ns_mailbox.c when TFM_MULTI_CORE_MAILBOX_RING is selected.
+ */
+
+#include <string.h>
+
+#include "tfm_ns_mailbox.h"
+
+#ifndef TFM_MULTI_CORE_MAILBOX_RING
+#error "TFM_MULTI_CORE_MAILBOX_RING should be selected to use mailbox ring"
+#endif
+
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_THREAD
+#error "NS mailbox thread is not supported by mailbox ring"
+#endif
+
+/* NSPE private context of an outstanding request, indexed by its token */
+struct ns_mailbox_ring_ctx_t {
+    int32_t    return_val;
+    const void *owner;          /* Handle of owner task */
+    bool       is_pending;      /* The token is in use */
+    bool       is_woken;        /* The reply is received and the owner task
+                                 * has been or should be woken up
+                                 */
+};
+
+/* The pointer to NSPE mailbox queue */
+static struct ns_mailbox_queue_t *mailbox_queue_ptr = NULL;
+
+static struct ns_mailbox_ring_ctx_t req_ctx[MAILBOX_RING_DEPTH];
+
+/* Stack of the tokens not in use */
+static uint32_t free_tokens[MAILBOX_RING_DEPTH];
+static uint32_t nr_free_tokens;
+
+/* Protected by NSPE mailbox spin lock */
+static struct mailbox_notify_stats_t notify_stats;
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/* Inline payload threshold negotiated in tfm_ns_mailbox_init() */
+static uint32_t inline_threshold;
+#endif
+
+static int32_t mailbox_tx_client_req(uint32_t call_type,
+                                     const struct psa_client_params_t *params,
+                                     int32_t client_id,
+                                     uint32_t *token)
+{
+    struct mailbox_msg_t msg;
+    const void *task_handle;
+    uint32_t idx;
+    bool is_queued = false;
+    bool is_notify = false;
+
+    msg.call_type = call_type;
+    memcpy(&msg.params, params, sizeof(msg.params));
+    msg.client_id = client_id;
+
+    /*
+     * Fetch the current task handle. The task will be woken up according the
+     * handle value set in the owner field.
+     */
+    task_handle = tfm_ns_mailbox_os_get_task_handle();
+
+    tfm_ns_mailbox_os_spin_lock();
+
+    if (nr_free_tokens == 0) {
+        tfm_ns_mailbox_os_spin_unlock();
+        return MAILBOX_QUEUE_FULL;
+    }
+
+    nr_free_tokens--;
+    idx = free_tokens[nr_free_tokens];
+
+    req_ctx[idx].owner = task_handle;
+    req_ctx[idx].is_woken = false;
+    req_ctx[idx].is_pending = true;
+
+    tfm_ns_mailbox_os_spin_unlock();
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* The payload indexed by the token is owned until the reply is received */
+    if (call_type == MAILBOX_PSA_CALL_INLINE) {
+        ns_mailbox_pack_inline_payload(&mailbox_queue_ptr->payload[idx],
+                                       params);
+    }
+#endif
+
+    /*
+     * NS tasks are the producers of the request ring. They are serialized
+     * locally and the ring itself needs no lock shared with SPE.
+     */
+    tfm_ns_mailbox_os_spin_lock();
+
+    /* There are as many tokens as ring entries, so it cannot be full */
+    is_queued = mailbox_req_ring_put(&mailbox_queue_ptr->req_ring, &msg, idx);
+    if (!is_queued) {
+        req_ctx[idx].is_pending = false;
+        free_tokens[nr_free_tokens] = idx;
+        nr_free_tokens++;
+    } else {
+        /* SPE keeps draining the ring until it is empty */
+        is_notify = ns_mailbox_req_need_notify(&notify_stats,
+                                mailbox_req_ring_is_consumer_busy(
+                                                &mailbox_queue_ptr->req_ring));
+    }
+
+    tfm_ns_mailbox_os_spin_unlock();
+
+    if (!is_queued) {
+        return MAILBOX_QUEUE_FULL;
+    }
+
+    if (is_notify) {
+        tfm_ns_mailbox_hal_notify_peer();
+    }
+
+    *token = idx;
+
+    return MAILBOX_SUCCESS;
+}
+
+static int32_t mailbox_rx_client_reply(uint32_t token, int32_t *reply)
+{
+    *reply = req_ctx[token].return_val;
+
+    tfm_ns_mailbox_os_spin_lock();
+
+    req_ctx[token].owner = NULL;
+    req_ctx[token].is_woken = false;
+    req_ctx[token].is_pending = false;
+    free_tokens[nr_free_tokens] = token;
+    nr_free_tokens++;
+
+    tfm_ns_mailbox_os_spin_unlock();
+
+    return MAILBOX_SUCCESS;
+}
+
+/*
+ * Consume all the completions from SPE and wake up the owner tasks.
+ * It is the only consumer of the completion ring.
+ */
+static int32_t mailbox_rx_completions(void)
+{
+    struct mailbox_ring_cpl_t cpl;
+    struct ns_mailbox_ring_ctx_t *ctx;
+    int32_t ret = MAILBOX_NO_PEND_EVENT;
+
+    while (mailbox_cpl_ring_get(&mailbox_queue_ptr->cpl_ring, &cpl)) {
+        /* Drop the completions which do not match an outstanding request */
+        if (cpl.token >= MAILBOX_RING_DEPTH) {
+            continue;
+        }
+
+        ctx = &req_ctx[cpl.token];
+        if (!ctx->is_pending || ctx->is_woken) {
+            continue;
+        }
+
+        /*
+         * The context is private to NSPE. The waiting task reads it under the
+         * local spin lock, so no lock shared with SPE is needed here.
+         */
+        ctx->return_val = cpl.return_val;
+        ctx->is_woken = true;
+
+        tfm_ns_mailbox_os_wake_task_isr(ctx->owner);
+
+        ret = MAILBOX_SUCCESS;
+    }
+
+    return ret;
+}
+
+static inline bool mailbox_wait_reply_signal(uint32_t token)
+{
+    bool is_set = false;
+
+    tfm_ns_mailbox_os_spin_lock();
+
+    if (req_ctx[token].is_woken) {
+        is_set = true;
+    }
+
+    tfm_ns_mailbox_os_spin_unlock();
+
+    return is_set;
+}
+
+static int32_t mailbox_wait_reply(uint32_t token)
+{
+    while (1) {
+        tfm_ns_mailbox_os_wait_reply();
+
+#ifndef TFM_MULTI_CORE_NS_OS
+        /* There is no mailbox IRQ handler in NS bare metal environment */
+        (void)mailbox_rx_completions();
+#endif
+
+        /*
+         * Check the woken-up flag to make sure that the current thread is
+         * woken up by reply event, rather than other events.
+         */
+        if (mailbox_wait_reply_signal(token)) {
+            break;
+        }
+    }
+
+    return MAILBOX_SUCCESS;
+}
+
+int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
+                                   const struct psa_client_params_t *params,
+                                   int32_t client_id,
+                                   int32_t *reply)
+{
+    uint32_t token = MAILBOX_RING_DEPTH;
+    int32_t reply_buf = 0x0;
+    int32_t ret;
+
+    if (!mailbox_queue_ptr) {
+        return MAILBOX_INIT_ERROR;
+    }
+
+    if (!params || !reply) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    if (tfm_ns_mailbox_os_lock_acquire() != MAILBOX_SUCCESS) {
+        return MAILBOX_QUEUE_FULL;
+    }
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* Small vectors are copied into the queue so SPE needs no pointer check */
+    if ((call_type == MAILBOX_PSA_CALL) &&
+        ns_mailbox_inline_payload_fits(params, inline_threshold)) {
+        call_type = MAILBOX_PSA_CALL_INLINE;
+    }
+#endif
+
+    ret = mailbox_tx_client_req(call_type, params, client_id, &token);
+    if (ret != MAILBOX_SUCCESS) {
+        goto exit;
+    }
+
+    mailbox_wait_reply(token);
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    if (call_type == MAILBOX_PSA_CALL_INLINE) {
+        ns_mailbox_unpack_inline_payload(&mailbox_queue_ptr->payload[token],
+                                         params);
+    }
+#endif
+
+    ret = mailbox_rx_client_reply(token, &reply_buf);
+    if (ret == MAILBOX_SUCCESS) {
+        *reply = reply_buf;
+    }
+
+exit:
+    if (tfm_ns_mailbox_os_lock_release() != MAILBOX_SUCCESS) {
+        return MAILBOX_GENERIC_ERROR;
+    }
+
+    return ret;
+}
+
+int32_t tfm_ns_mailbox_get_notify_stats(struct mailbox_notify_stats_t *stats)
+{
+    if (!stats) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    tfm_ns_mailbox_os_spin_lock();
+    memcpy(stats, &notify_stats, sizeof(*stats));
+    tfm_ns_mailbox_os_spin_unlock();
+
+    return MAILBOX_SUCCESS;
+}
+
+#ifdef TFM_MULTI_CORE_NS_OS
+int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
+{
+    if (!mailbox_queue_ptr) {
+        return MAILBOX_INIT_ERROR;
+    }
+
+    return mailbox_rx_completions();
+}
+#endif /* TFM_MULTI_CORE_NS_OS */
+
+int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
+{
+    uint32_t idx;
+    int32_t ret;
+
+    if (!queue) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    /*
+     * Further verification of mailbox queue address may be required according
+     * to non-secure memory assignment.
+     */
+
+    memset(queue, 0, sizeof(*queue));
+    memset(req_ctx, 0, sizeof(req_ctx));
+    memset(&notify_stats, 0, sizeof(notify_stats));
+
+    for (idx = 0; idx < MAILBOX_RING_DEPTH; idx++) {
+        free_tokens[idx] = MAILBOX_RING_DEPTH - 1 - idx;
+    }
+    nr_free_tokens = MAILBOX_RING_DEPTH;
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    queue->inline_threshold = MAILBOX_INLINE_PAYLOAD_SIZE;
+#endif
+
+    mailbox_queue_ptr = queue;
+
+    /* Platform specific initialization. */
+    ret = tfm_ns_mailbox_hal_init(queue);
+    if (ret != MAILBOX_SUCCESS) {
+        return ret;
+    }
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /* The platform can only lower the threshold */
+    inline_threshold = queue->inline_threshold;
+    if (inline_threshold > MAILBOX_INLINE_PAYLOAD_SIZE) {
+        inline_threshold = MAILBOX_INLINE_PAYLOAD_SIZE;
+    }
+#endif
+
+    return tfm_ns_mailbox_os_lock_init();
+}
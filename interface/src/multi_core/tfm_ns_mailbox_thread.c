@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2020-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -9,6 +9,15 @@
 
 #include "tfm_ns_mailbox.h"
 
+/*
+ * MAILBOX_THREAD_BARRIER() makes the queue full flag visible before the thread
+ * sleeps. It defaults to a DSB. Define it to build the NSPE mailbox elsewhere,
+ * such as in a host simulation.
+ */
+#ifndef MAILBOX_THREAD_BARRIER
+#define MAILBOX_THREAD_BARRIER()            __DSB()
+#endif
+
 /* Thread woken up flag */
 #define NOT_WOKEN        0x0
 #define WOKEN_UP        0x5C
@@ -41,20 +50,110 @@ struct ns_mailbox_req_t {
                                                    */
 };
 
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+/* The reply states of the slots, shared with the reply IRQ handler */
+#define SLOT_WAIT_REPLY                     0x0
+#define SLOT_REPLIED                        0x1
+#define SLOT_ABANDONED                      0x2
+
+/*
+ * Semaphores made available by the reply IRQ handler, one per slot. A slot and
+ * its semaphore belong to the client thread which claimed the slot, until it
+ * has taken the semaphore.
+ */
+static void *slot_sem[NUM_MAILBOX_QUEUE_SLOT];
+
+/*
+ * The reply state of each slot. A client thread which fails to take the
+ * semaphore abandons its slot, and the slot is released by the reply IRQ
+ * handler when SPE replies to it. Only changed in NSPE mailbox critical
+ * section once the message is sent.
+ */
+static uint8_t slot_state[NUM_MAILBOX_QUEUE_SLOT];
+#else
 /* Message queue handle */
 static void *msgq_handle = NULL;
 
 /* The handle of the dedicated NS mailbox thread. */
 static const void *ns_mailbox_thread_handle = NULL;
+#endif
 
 /* The pointer to NSPE mailbox queue */
 static struct ns_mailbox_queue_t *mailbox_queue_ptr = NULL;
 
+/* Protected by NSPE mailbox critical section */
+static struct mailbox_notify_stats_t notify_stats;
+
 static inline void set_queue_slot_all_empty(mailbox_queue_status_t completed)
 {
     mailbox_queue_ptr->empty_slots |= completed;
 }
 
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+/*
+ * The lock taken in tfm_ns_mailbox_client_call() admits at most
+ * NUM_MAILBOX_QUEUE_SLOT client threads. Therefore an empty slot is found
+ * here, unless an abandoned slot is still waiting for its reply.
+ * The empty slots are also released by the reply IRQ handler, so they are
+ * only accessed in NSPE mailbox critical section.
+ */
+static uint8_t claim_empty_slot(struct ns_mailbox_queue_t *queue)
+{
+    uint8_t idx;
+
+    tfm_ns_mailbox_hal_enter_critical();
+
+    for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+        if (queue->empty_slots & (1UL << idx)) {
+            clear_queue_slot_empty(queue, idx);
+            slot_state[idx] = SLOT_WAIT_REPLY;
+            break;
+        }
+    }
+
+    tfm_ns_mailbox_hal_exit_critical();
+
+    return idx;
+}
+
+static inline void release_slot(uint8_t idx)
+{
+    tfm_ns_mailbox_hal_enter_critical();
+    set_queue_slot_all_empty(1UL << idx);
+    tfm_ns_mailbox_hal_exit_critical();
+}
+
+/*
+ * Give up waiting for the reply in a slot. The reply may have arrived since
+ * the wait failed, and then the semaphore is available and the slot can be
+ * released as usual. Otherwise, the reply is dropped and the slot is released
+ * by the reply IRQ handler when SPE replies.
+ */
+static int32_t abandon_slot(uint8_t idx)
+{
+    bool is_replied;
+
+    tfm_ns_mailbox_hal_enter_critical();
+
+    is_replied = (slot_state[idx] == SLOT_REPLIED);
+    if (!is_replied) {
+        slot_state[idx] = SLOT_ABANDONED;
+        /* The reply buffer of the client thread is no longer valid */
+        mailbox_queue_ptr->queue[idx].reply.reply = NULL;
+    }
+
+    tfm_ns_mailbox_hal_exit_critical();
+
+    if (!is_replied ||
+        (tfm_ns_mailbox_os_sem_wait(slot_sem[idx]) != MAILBOX_SUCCESS)) {
+        return MAILBOX_GENERIC_ERROR;
+    }
+
+    release_slot(idx);
+
+    return MAILBOX_SUCCESS;
+}
+#else /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
 static inline void set_queue_slot_woken(uint8_t idx)
 {
     if (idx < NUM_MAILBOX_QUEUE_SLOT) {
@@ -78,8 +177,8 @@ static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
 
         /* No empty slot */
         queue->is_full = true;
-        /* DSB to make sure the thread sleeps after the flag is set */
-        __DSB();
+        /* Make sure the thread sleeps after the flag is set */
+        MAILBOX_THREAD_BARRIER();
 
         /* Wait for an empty slot released by a completed mailbox message */
         tfm_ns_mailbox_os_wait_reply();
@@ -98,18 +197,15 @@ static uint8_t acquire_empty_slot(struct ns_mailbox_queue_t *queue)
 
     return idx;
 }
+#endif /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
 
-static int32_t mailbox_tx_client_call_msg(const struct ns_mailbox_req_t *req,
-                                          uint8_t *slot_idx)
+/* Fill the mailbox message in the slot already acquired and send it to SPE */
+static void mailbox_tx_client_call_msg(const struct ns_mailbox_req_t *req,
+                                       uint8_t idx)
 {
     struct mailbox_msg_t *msg_ptr;
     struct mailbox_reply_t *reply_ptr;
-    uint8_t idx = NUM_MAILBOX_QUEUE_SLOT;
-
-    idx = acquire_empty_slot(mailbox_queue_ptr);
-    if (idx == NUM_MAILBOX_QUEUE_SLOT) {
-        return MAILBOX_QUEUE_FULL;
-    }
+    bool is_notify;
 
 #ifdef TFM_MULTI_CORE_TEST
     tfm_ns_mailbox_tx_stats_update();
@@ -133,16 +229,18 @@ static int32_t mailbox_tx_client_call_msg(const struct ns_mailbox_req_t *req,
      */
 
     tfm_ns_mailbox_hal_enter_critical();
+    /*
+     * SPE keeps handling until no slot is pending. If some slots are still
+     * pending, SPE will also take this one.
+     */
+    is_notify = ns_mailbox_req_need_notify(&notify_stats,
+                                           mailbox_queue_ptr->pend_slots != 0);
     set_queue_slot_pend(mailbox_queue_ptr, idx);
     tfm_ns_mailbox_hal_exit_critical();
 
-    tfm_ns_mailbox_hal_notify_peer();
-
-    if (slot_idx) {
-        *slot_idx = idx;
+    if (is_notify) {
+        tfm_ns_mailbox_hal_notify_peer();
     }
-
-    return MAILBOX_SUCCESS;
 }
 
 static inline void ns_mailbox_set_reply_isr(uint8_t idx)
@@ -154,6 +252,59 @@ static inline void ns_mailbox_set_reply_isr(uint8_t idx)
     }
 }
 
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
+                                   const struct psa_client_params_t *params,
+                                   int32_t client_id,
+                                   int32_t *reply)
+{
+    struct ns_mailbox_req_t req;
+    uint8_t idx;
+    int32_t ret;
+
+    if (!mailbox_queue_ptr) {
+        return MAILBOX_INIT_ERROR;
+    }
+
+    if (!params || !reply) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    req.call_type = call_type;
+    req.params_ptr = params;
+    req.reply = reply;
+    req.woken_flag = NULL;
+    req.owner = NULL;
+    req.client_id = client_id;
+
+    if (tfm_ns_mailbox_os_lock_acquire() != MAILBOX_SUCCESS) {
+        return MAILBOX_QUEUE_FULL;
+    }
+
+    idx = claim_empty_slot(mailbox_queue_ptr);
+    if (idx == NUM_MAILBOX_QUEUE_SLOT) {
+        ret = MAILBOX_QUEUE_FULL;
+        goto exit;
+    }
+
+    mailbox_tx_client_call_msg(&req, idx);
+
+    /* The reply is written back before the semaphore is made available */
+    ret = tfm_ns_mailbox_os_sem_wait(slot_sem[idx]);
+    if (ret == MAILBOX_SUCCESS) {
+        release_slot(idx);
+    } else {
+        ret = abandon_slot(idx);
+    }
+
+exit:
+    if (tfm_ns_mailbox_os_lock_release() != MAILBOX_SUCCESS) {
+        return MAILBOX_GENERIC_ERROR;
+    }
+
+    return ret;
+}
+#else /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
 static int32_t mailbox_wait_reply(const struct ns_mailbox_req_t *req)
 {
     while (1) {
@@ -205,10 +356,26 @@ int32_t tfm_ns_mailbox_client_call(uint32_t call_type,
 
     return ret;
 }
+#endif /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
+
+int32_t tfm_ns_mailbox_get_notify_stats(struct mailbox_notify_stats_t *stats)
+{
+    if (!stats) {
+        return MAILBOX_INVAL_PARAMS;
+    }
+
+    tfm_ns_mailbox_hal_enter_critical();
+    memcpy(stats, &notify_stats, sizeof(*stats));
+    tfm_ns_mailbox_hal_exit_critical();
+
+    return MAILBOX_SUCCESS;
+}
 
+#ifndef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
 void tfm_ns_mailbox_thread_runner(void *args)
 {
     struct ns_mailbox_req_t req;
+    uint8_t idx;
     int32_t ret;
 
     (void)args;
@@ -230,15 +397,26 @@ void tfm_ns_mailbox_thread_runner(void *args)
             continue;
         }
 
-        mailbox_tx_client_call_msg(&req, NULL);
+        idx = acquire_empty_slot(mailbox_queue_ptr);
+        if (idx == NUM_MAILBOX_QUEUE_SLOT) {
+            continue;
+        }
+
+        mailbox_tx_client_call_msg(&req, idx);
     }
 }
+#endif /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
 
 int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
 {
     uint8_t idx;
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+    bool is_abandoned;
+#else
     const void *task_handle;
-    mailbox_queue_status_t replied_status, complete_slots = 0x0;
+    mailbox_queue_status_t complete_slots = 0x0;
+#endif
+    mailbox_queue_status_t replied_status;
 
     if (!mailbox_queue_ptr) {
         return MAILBOX_INIT_ERROR;
@@ -270,6 +448,25 @@ int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
          * returned inside mailbox_rx_client_reply(). ns_mailbox_set_reply_isr()
          * is defined as dummy function.
          */
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+        tfm_ns_mailbox_hal_enter_critical_isr();
+
+        is_abandoned = (slot_state[idx] == SLOT_ABANDONED);
+        if (is_abandoned) {
+            /* Nobody waits for the reply, the slot is released here */
+            set_queue_slot_all_empty(0x1UL << idx);
+        } else {
+            ns_mailbox_set_reply_isr(idx);
+            slot_state[idx] = SLOT_REPLIED;
+        }
+
+        tfm_ns_mailbox_hal_exit_critical_isr();
+
+        /* The owner releases the slot after it takes the semaphore */
+        if (!is_abandoned) {
+            tfm_ns_mailbox_os_sem_post_isr(slot_sem[idx]);
+        }
+#else
         ns_mailbox_set_reply_isr(idx);
 
         /* Wake up the owner of this mailbox message */
@@ -281,6 +478,7 @@ int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
         }
 
         complete_slots |= (1UL << idx);
+#endif
 
         replied_status &= ~(0x1UL << idx);
         if (!replied_status) {
@@ -288,6 +486,7 @@ int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
         }
     }
 
+#ifndef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
     set_queue_slot_all_empty(complete_slots);
 
     /*
@@ -299,10 +498,26 @@ int32_t tfm_ns_mailbox_wake_reply_owner_isr(void)
             tfm_ns_mailbox_os_wake_task_isr(ns_mailbox_thread_handle);
         }
     }
+#endif
 
     return MAILBOX_SUCCESS;
 }
 
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+static inline int32_t mailbox_req_queue_init(uint8_t queue_depth)
+{
+    uint8_t idx;
+
+    for (idx = 0; idx < queue_depth; idx++) {
+        slot_sem[idx] = tfm_ns_mailbox_os_sem_create();
+        if (!slot_sem[idx]) {
+            return MAILBOX_GENERIC_ERROR;
+        }
+    }
+
+    return tfm_ns_mailbox_os_lock_init();
+}
+#else
 static inline int32_t mailbox_req_queue_init(uint8_t queue_depth)
 {
     msgq_handle = tfm_ns_mailbox_os_mq_create(sizeof(struct ns_mailbox_req_t),
@@ -313,6 +528,7 @@ static inline int32_t mailbox_req_queue_init(uint8_t queue_depth)
 
     return MAILBOX_SUCCESS;
 }
+#endif
 
 int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
 {
@@ -328,6 +544,7 @@ int32_t tfm_ns_mailbox_init(struct ns_mailbox_queue_t *queue)
      */
 
     memset(queue, 0, sizeof(*queue));
+    memset(&notify_stats, 0, sizeof(notify_stats));
 
     /* Initialize empty bitmask */
     queue->empty_slots =
@@ -1,10 +1,13 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
+#include <stdbool.h>
+#include <string.h>
+
 #include "tfm_crypto_defs.h"
 #include "psa/crypto.h"
 #include "psa/client.h"
@@ -19,6 +22,46 @@
              in_vec, IOVEC_LEN(in_vec),        \
              (psa_outvec *)NULL, 0)
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+/*
+ * A hash or MAC operation is only set up in the Crypto service once its input
+ * no longer fits in the buffer of the operation. If the whole input fits,
+ * finish is sent as a single-part request carrying the algorithm, the key and
+ * the input, so the operation takes one request instead of three.
+ * The errors of setup, other than an invalid algorithm, are reported by the
+ * call which sends the request.
+ */
+#define TFM_CRYPTO_COALESCE_NONE        0   /* Not coalescing */
+#define TFM_CRYPTO_COALESCE_HASH        1
+#define TFM_CRYPTO_COALESCE_MAC_SIGN    2
+#define TFM_CRYPTO_COALESCE_MAC_VERIFY  3
+
+/* Keep the input in the buffer of an operation if it fits */
+static bool tfm_crypto_coalesce_input(uint8_t *buf, uint16_t *buf_len,
+                                      const uint8_t *input,
+                                      size_t input_length)
+{
+    if (input_length > (size_t)(TFM_CRYPTO_COALESCE_BUF_SIZE - *buf_len)) {
+        return false;
+    }
+
+    if (input_length > 0) {
+        (void)memcpy(&buf[*buf_len], input, input_length);
+        *buf_len += (uint16_t)input_length;
+    }
+
+    return true;
+}
+
+static void tfm_crypto_coalesce_reset(uint8_t *buf, uint16_t *buf_len,
+                                      uint8_t *state)
+{
+    (void)memset(buf, 0, *buf_len);
+    *buf_len = 0;
+    *state = TFM_CRYPTO_COALESCE_NONE;
+}
+#endif /* TFM_CRYPTO_COALESCE_BUF_SIZE > 0 */
+
 psa_status_t psa_crypto_init(void)
 {
     /* Service init is performed during TFM boot up,
@@ -361,8 +404,8 @@ psa_status_t psa_cipher_finish(psa_cipher_operation_t *operation,
     return status;
 }
 
-psa_status_t psa_hash_setup(psa_hash_operation_t *operation,
-                            psa_algorithm_t alg)
+static psa_status_t hash_setup_request(psa_hash_operation_t *operation,
+                                       psa_algorithm_t alg)
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_HASH_SETUP_SID,
@@ -380,9 +423,9 @@ psa_status_t psa_hash_setup(psa_hash_operation_t *operation,
     return API_DISPATCH(in_vec, out_vec);
 }
 
-psa_status_t psa_hash_update(psa_hash_operation_t *operation,
-                             const uint8_t *input,
-                             size_t input_length)
+static psa_status_t hash_update_request(psa_hash_operation_t *operation,
+                                        const uint8_t *input,
+                                        size_t input_length)
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_HASH_UPDATE_SID,
@@ -397,6 +440,70 @@ psa_status_t psa_hash_update(psa_hash_operation_t *operation,
     return API_DISPATCH_NO_OUTVEC(in_vec);
 }
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+/* Set up the operation in the service and send the coalesced input to it */
+static psa_status_t hash_coalesce_flush(psa_hash_operation_t *operation)
+{
+    psa_status_t status;
+
+    status = hash_setup_request(operation, operation->alg);
+    if ((status == PSA_SUCCESS) && (operation->coalesced_len > 0)) {
+        status = hash_update_request(operation, operation->coalesced,
+                                     operation->coalesced_len);
+    }
+
+    tfm_crypto_coalesce_reset(operation->coalesced,
+                              &operation->coalesced_len,
+                              &operation->coalesce_state);
+
+    return status;
+}
+#endif /* TFM_CRYPTO_COALESCE_BUF_SIZE > 0 */
+
+psa_status_t psa_hash_setup(psa_hash_operation_t *operation,
+                            psa_algorithm_t alg)
+{
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* Let the service report the errors which can be found at setup */
+    if ((operation->handle == 0) && PSA_ALG_IS_HASH(alg)) {
+        operation->alg = alg;
+        operation->coalesced_len = 0;
+        operation->coalesce_state = TFM_CRYPTO_COALESCE_HASH;
+        return PSA_SUCCESS;
+    }
+#endif
+
+    return hash_setup_request(operation, alg);
+}
+
+psa_status_t psa_hash_update(psa_hash_operation_t *operation,
+                             const uint8_t *input,
+                             size_t input_length)
+{
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    psa_status_t status;
+
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        if (tfm_crypto_coalesce_input(operation->coalesced,
+                                      &operation->coalesced_len,
+                                      input, input_length)) {
+            return PSA_SUCCESS;
+        }
+
+        status = hash_coalesce_flush(operation);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+#endif
+
+    return hash_update_request(operation, input, input_length);
+}
+
 psa_status_t psa_hash_finish(psa_hash_operation_t *operation,
                              uint8_t *hash,
                              size_t hash_size,
@@ -405,9 +512,30 @@ psa_status_t psa_hash_finish(psa_hash_operation_t *operation,
     psa_status_t status;
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_HASH_FINISH_SID,
-        .op_handle = operation->handle,
     };
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        status = psa_hash_compute(operation->alg, operation->coalesced,
+                                  operation->coalesced_len, hash, hash_size,
+                                  hash_length);
+        /* Single-part functions may be disabled in the service */
+        if (status != PSA_ERROR_NOT_SUPPORTED) {
+            tfm_crypto_coalesce_reset(operation->coalesced,
+                                      &operation->coalesced_len,
+                                      &operation->coalesce_state);
+            return status;
+        }
+
+        status = hash_coalesce_flush(operation);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+#endif
+
+    iov.op_handle = operation->handle;
+
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
@@ -429,8 +557,28 @@ psa_status_t psa_hash_verify(psa_hash_operation_t *operation,
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_HASH_VERIFY_SID,
-        .op_handle = operation->handle,
     };
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    psa_status_t status;
+
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        status = psa_hash_compare(operation->alg, operation->coalesced,
+                                  operation->coalesced_len, hash, hash_length);
+        if (status != PSA_ERROR_NOT_SUPPORTED) {
+            tfm_crypto_coalesce_reset(operation->coalesced,
+                                      &operation->coalesced_len,
+                                      &operation->coalesce_state);
+            return status;
+        }
+
+        status = hash_coalesce_flush(operation);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+#endif
+
+    iov.op_handle = operation->handle;
 
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
@@ -450,6 +598,16 @@ psa_status_t psa_hash_abort(psa_hash_operation_t *operation)
         .op_handle = operation->handle,
     };
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        /* Nothing has been set up in the service yet */
+        tfm_crypto_coalesce_reset(operation->coalesced,
+                                  &operation->coalesced_len,
+                                  &operation->coalesce_state);
+        return PSA_SUCCESS;
+    }
+#endif
+
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
@@ -472,6 +630,23 @@ psa_status_t psa_hash_clone(const psa_hash_operation_t *source_operation,
         return PSA_ERROR_BAD_STATE;
     }
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (target_operation &&
+        (target_operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE)) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    /* The state of a coalescing operation is all in the client */
+    if (source_operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        if (target_operation == NULL) {
+            return PSA_ERROR_INVALID_ARGUMENT;
+        }
+        (void)memcpy(target_operation, source_operation,
+                     sizeof(*target_operation));
+        return PSA_SUCCESS;
+    }
+#endif
+
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
         {.base = &(target_operation->handle),
@@ -534,9 +709,9 @@ psa_status_t psa_hash_compare(psa_algorithm_t alg,
     return API_DISPATCH_NO_OUTVEC(in_vec);
 }
 
-psa_status_t psa_mac_sign_setup(psa_mac_operation_t *operation,
-                                psa_key_id_t key,
-                                psa_algorithm_t alg)
+static psa_status_t mac_sign_setup_request(psa_mac_operation_t *operation,
+                                           psa_key_id_t key,
+                                           psa_algorithm_t alg)
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_MAC_SIGN_SETUP_SID,
@@ -555,9 +730,9 @@ psa_status_t psa_mac_sign_setup(psa_mac_operation_t *operation,
     return API_DISPATCH(in_vec, out_vec);
 }
 
-psa_status_t psa_mac_verify_setup(psa_mac_operation_t *operation,
-                                  psa_key_id_t key,
-                                  psa_algorithm_t alg)
+static psa_status_t mac_verify_setup_request(psa_mac_operation_t *operation,
+                                             psa_key_id_t key,
+                                             psa_algorithm_t alg)
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_MAC_VERIFY_SETUP_SID,
@@ -576,9 +751,9 @@ psa_status_t psa_mac_verify_setup(psa_mac_operation_t *operation,
     return API_DISPATCH(in_vec, out_vec);
 }
 
-psa_status_t psa_mac_update(psa_mac_operation_t *operation,
-                            const uint8_t *input,
-                            size_t input_length)
+static psa_status_t mac_update_request(psa_mac_operation_t *operation,
+                                       const uint8_t *input,
+                                       size_t input_length)
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_MAC_UPDATE_SID,
@@ -593,6 +768,116 @@ psa_status_t psa_mac_update(psa_mac_operation_t *operation,
     return API_DISPATCH_NO_OUTVEC(in_vec);
 }
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+/* Set up the operation in the service and send the coalesced input to it */
+static psa_status_t mac_coalesce_flush(psa_mac_operation_t *operation)
+{
+    psa_status_t status;
+
+    if (operation->coalesce_state == TFM_CRYPTO_COALESCE_MAC_SIGN) {
+        status = mac_sign_setup_request(operation, operation->key,
+                                        operation->alg);
+    } else {
+        status = mac_verify_setup_request(operation, operation->key,
+                                          operation->alg);
+    }
+
+    if ((status == PSA_SUCCESS) && (operation->coalesced_len > 0)) {
+        status = mac_update_request(operation, operation->coalesced,
+                                    operation->coalesced_len);
+    }
+
+    tfm_crypto_coalesce_reset(operation->coalesced,
+                              &operation->coalesced_len,
+                              &operation->coalesce_state);
+
+    return status;
+}
+
+/*
+ * Start coalescing the input if the setup can be deferred. The key is only
+ * bound to the operation when the first request is sent, so destroying the
+ * key after setup makes the following update or finish fail.
+ */
+static bool mac_coalesce_setup(psa_mac_operation_t *operation,
+                               psa_key_id_t key,
+                               psa_algorithm_t alg,
+                               uint8_t state)
+{
+    /* Let the service report the errors which can be found at setup */
+    if ((operation->handle != 0) || !PSA_ALG_IS_MAC(alg)) {
+        return false;
+    }
+
+    operation->key = key;
+    operation->alg = alg;
+    operation->coalesced_len = 0;
+    operation->coalesce_state = state;
+
+    return true;
+}
+#endif /* TFM_CRYPTO_COALESCE_BUF_SIZE > 0 */
+
+psa_status_t psa_mac_sign_setup(psa_mac_operation_t *operation,
+                                psa_key_id_t key,
+                                psa_algorithm_t alg)
+{
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (mac_coalesce_setup(operation, key, alg,
+                           TFM_CRYPTO_COALESCE_MAC_SIGN)) {
+        return PSA_SUCCESS;
+    }
+#endif
+
+    return mac_sign_setup_request(operation, key, alg);
+}
+
+psa_status_t psa_mac_verify_setup(psa_mac_operation_t *operation,
+                                  psa_key_id_t key,
+                                  psa_algorithm_t alg)
+{
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (mac_coalesce_setup(operation, key, alg,
+                           TFM_CRYPTO_COALESCE_MAC_VERIFY)) {
+        return PSA_SUCCESS;
+    }
+#endif
+
+    return mac_verify_setup_request(operation, key, alg);
+}
+
+psa_status_t psa_mac_update(psa_mac_operation_t *operation,
+                            const uint8_t *input,
+                            size_t input_length)
+{
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    psa_status_t status;
+
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        if (tfm_crypto_coalesce_input(operation->coalesced,
+                                      &operation->coalesced_len,
+                                      input, input_length)) {
+            return PSA_SUCCESS;
+        }
+
+        status = mac_coalesce_flush(operation);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+#endif
+
+    return mac_update_request(operation, input, input_length);
+}
+
 psa_status_t psa_mac_sign_finish(psa_mac_operation_t *operation,
                                  uint8_t *mac,
                                  size_t mac_size,
@@ -601,9 +886,35 @@ psa_status_t psa_mac_sign_finish(psa_mac_operation_t *operation,
     psa_status_t status;
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_MAC_SIGN_FINISH_SID,
-        .op_handle = operation->handle,
     };
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state == TFM_CRYPTO_COALESCE_MAC_VERIFY) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (operation->coalesce_state == TFM_CRYPTO_COALESCE_MAC_SIGN) {
+        status = psa_mac_compute(operation->key, operation->alg,
+                                 operation->coalesced,
+                                 operation->coalesced_len,
+                                 mac, mac_size, mac_length);
+        /* Single-part functions may be disabled in the service */
+        if (status != PSA_ERROR_NOT_SUPPORTED) {
+            tfm_crypto_coalesce_reset(operation->coalesced,
+                                      &operation->coalesced_len,
+                                      &operation->coalesce_state);
+            return status;
+        }
+
+        status = mac_coalesce_flush(operation);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+#endif
+
+    iov.op_handle = operation->handle;
+
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
@@ -625,8 +936,34 @@ psa_status_t psa_mac_verify_finish(psa_mac_operation_t *operation,
 {
     struct tfm_crypto_pack_iovec iov = {
         .function_id = TFM_CRYPTO_MAC_VERIFY_FINISH_SID,
-        .op_handle = operation->handle,
     };
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    psa_status_t status;
+
+    if (operation->coalesce_state == TFM_CRYPTO_COALESCE_MAC_SIGN) {
+        return PSA_ERROR_BAD_STATE;
+    }
+
+    if (operation->coalesce_state == TFM_CRYPTO_COALESCE_MAC_VERIFY) {
+        status = psa_mac_verify(operation->key, operation->alg,
+                                operation->coalesced,
+                                operation->coalesced_len,
+                                mac, mac_length);
+        if (status != PSA_ERROR_NOT_SUPPORTED) {
+            tfm_crypto_coalesce_reset(operation->coalesced,
+                                      &operation->coalesced_len,
+                                      &operation->coalesce_state);
+            return status;
+        }
+
+        status = mac_coalesce_flush(operation);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+    }
+#endif
+
+    iov.op_handle = operation->handle;
 
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
@@ -646,6 +983,16 @@ psa_status_t psa_mac_abort(psa_mac_operation_t *operation)
         .op_handle = operation->handle,
     };
 
+#if TFM_CRYPTO_COALESCE_BUF_SIZE > 0
+    if (operation->coalesce_state != TFM_CRYPTO_COALESCE_NONE) {
+        /* Nothing has been set up in the service yet */
+        tfm_crypto_coalesce_reset(operation->coalesced,
+                                  &operation->coalesced_len,
+                                  &operation->coalesce_state);
+        return PSA_SUCCESS;
+    }
+#endif
+
     psa_invec in_vec[] = {
         {.base = &iov, .len = sizeof(struct tfm_crypto_pack_iovec)},
     };
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "psa/client.h"
+#include "tfm_api.h"
+#include "tfm_psa_conn_pool.h"
+
+void tfm_conn_pool_init(struct tfm_conn_pool_t *pool,
+                        struct tfm_conn_pool_entry_t *entries,
+                        uint32_t num_entries)
+{
+    uint32_t i;
+
+    for (i = 0; i < num_entries; i++) {
+        entries[i].handle = PSA_NULL_HANDLE;
+        entries[i].in_use = 0;
+    }
+
+    pool->entries = entries;
+    pool->num_entries = num_entries;
+    pool->hits = 0;
+    pool->misses = 0;
+}
+
+psa_handle_t tfm_conn_pool_connect(struct tfm_conn_pool_t *pool,
+                                   uint32_t sid, uint32_t version)
+{
+    struct tfm_conn_pool_entry_t *empty = NULL;
+    struct tfm_conn_pool_entry_t *entry;
+    psa_handle_t handle;
+    uint32_t i;
+
+    for (i = 0; i < pool->num_entries; i++) {
+        entry = &pool->entries[i];
+
+        if (entry->handle == PSA_NULL_HANDLE) {
+            if (!empty) {
+                empty = entry;
+            }
+            continue;
+        }
+
+        if (!entry->in_use && (entry->sid == sid) &&
+            (entry->version == version)) {
+            entry->in_use = 1;
+            pool->hits++;
+            return entry->handle;
+        }
+    }
+
+    pool->misses++;
+    handle = psa_connect(sid, version);
+
+    /* Track the new connection if there is room, it is closed otherwise */
+    if (PSA_HANDLE_IS_VALID(handle) && empty) {
+        empty->sid = sid;
+        empty->version = version;
+        empty->handle = handle;
+        empty->in_use = 1;
+    }
+
+    return handle;
+}
+
+void tfm_conn_pool_close(struct tfm_conn_pool_t *pool, psa_handle_t handle)
+{
+    struct tfm_conn_pool_entry_t *entry = NULL;
+    uint32_t i;
+
+    for (i = 0; i < pool->num_entries; i++) {
+        if (pool->entries[i].in_use && (pool->entries[i].handle == handle)) {
+            entry = &pool->entries[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        psa_close(handle);
+        return;
+    }
+
+    /*
+     * The connection is reused as a fresh one only if the service reset it.
+     * SPM rejects the reset of the services which do not handle it without
+     * involving the service, so they are closed and connected again.
+     */
+    if (psa_call(handle, TFM_IPC_RESET, NULL, 0, NULL, 0) != PSA_SUCCESS) {
+        entry->handle = PSA_NULL_HANDLE;
+        psa_close(handle);
+    }
+
+    entry->in_use = 0;
+}
+
+void tfm_conn_pool_flush(struct tfm_conn_pool_t *pool)
+{
+    struct tfm_conn_pool_entry_t *entry;
+    uint32_t i;
+
+    for (i = 0; i < pool->num_entries; i++) {
+        entry = &pool->entries[i];
+
+        if ((entry->handle != PSA_NULL_HANDLE) && !entry->in_use) {
+            psa_close(entry->handle);
+            entry->handle = PSA_NULL_HANDLE;
+        }
+    }
+}
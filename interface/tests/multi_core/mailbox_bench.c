@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host benchmark of the mailbox. NS client threads send PSA client calls
+ * through the NSPE and SPE mailboxes of the simulated platform, check each
+ * result, then report the throughput, the latency and the notification
+ * statistics of both sides.
+ *
+ * Usage: mailbox_bench [nr_clients] [nr_calls_per_client]
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mailbox_sim.h"
+#include "tfm_ns_mailbox.h"
+#include "tfm_spe_mailbox.h"
+
+#define BENCH_DEFAULT_CLIENTS               4
+#define BENCH_DEFAULT_CALLS                 10000
+#define BENCH_MAX_CLIENTS                   64
+
+/* Every BENCH_VERSION_INTERVAL-th call is a psa_version() */
+#define BENCH_VERSION_INTERVAL              16
+
+/* Sizes of the vectors alternate to cover both inline and pointer calls */
+#define BENCH_SMALL_VEC_SIZE                16
+#define BENCH_LARGE_VEC_SIZE                256
+
+struct bench_client_t {
+    pthread_t thread;
+    int32_t   client_id;
+    uint32_t  nr_calls;
+    uint32_t  nr_errors;
+    uint64_t  total_ns;
+    uint64_t  max_ns;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void fill_pattern(uint8_t *buf, size_t size, uint32_t seed)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = (uint8_t)(seed + i * 7);
+    }
+}
+
+static bool bench_version(struct bench_client_t *client)
+{
+    struct psa_client_params_t params;
+    int32_t reply = 0;
+
+    memset(&params, 0, sizeof(params));
+    params.psa_version_params.sid = SIM_SERVICE_SID;
+
+    return (tfm_ns_mailbox_client_call(MAILBOX_PSA_VERSION, &params,
+                                       client->client_id, &reply) ==
+            MAILBOX_SUCCESS) &&
+           (reply == SIM_SERVICE_VERSION);
+}
+
+static bool bench_call(struct bench_client_t *client, uint32_t seq)
+{
+    uint8_t in_buf[BENCH_LARGE_VEC_SIZE];
+    uint8_t out_buf[BENCH_LARGE_VEC_SIZE];
+    size_t size = (seq & 0x1) ? BENCH_LARGE_VEC_SIZE : BENCH_SMALL_VEC_SIZE;
+    psa_invec in_vec[] = {{in_buf, size}};
+    psa_outvec out_vec[] = {{out_buf, size}};
+    struct psa_client_params_t params;
+    int32_t type = (int32_t)(seq & 0xFF);
+    int32_t reply = 0;
+
+    fill_pattern(in_buf, size, seq ^ (uint32_t)client->client_id);
+    memset(out_buf, 0, sizeof(out_buf));
+
+    memset(&params, 0, sizeof(params));
+    params.psa_call_params.handle = SIM_SERVICE_HANDLE;
+    params.psa_call_params.type = type;
+    params.psa_call_params.in_vec = in_vec;
+    params.psa_call_params.in_len = 1;
+    params.psa_call_params.out_vec = out_vec;
+    params.psa_call_params.out_len = 1;
+
+    if (tfm_ns_mailbox_client_call(MAILBOX_PSA_CALL, &params,
+                                   client->client_id, &reply) !=
+        MAILBOX_SUCCESS) {
+        return false;
+    }
+
+    return (reply == SIM_SERVICE_RESULT(type, size)) &&
+           (out_vec[0].len == size) &&
+           (memcmp(in_buf, out_buf, size) == 0);
+}
+
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+/*
+ * A client which gives up waiting for its reply abandons its slot. The slot
+ * must be released when the late reply arrives, otherwise the benchmark runs
+ * short of slots.
+ */
+static bool bench_abandon(void)
+{
+    struct psa_client_params_t params;
+    int32_t reply = 0;
+    int32_t ret;
+
+    memset(&params, 0, sizeof(params));
+    params.psa_call_params.handle = SIM_SERVICE_HANDLE;
+    params.psa_call_params.type = SIM_SERVICE_SLOW_TYPE;
+
+    sim_set_reply_timeout_ms(SIM_SERVICE_SLOW_MS / 3);
+    ret = tfm_ns_mailbox_client_call(MAILBOX_PSA_CALL, &params, -1, &reply);
+    sim_set_reply_timeout_ms(0);
+
+    /* Wait for the late reply */
+    usleep(SIM_SERVICE_SLOW_MS * 2 * 1000);
+
+    /* The late reply is dropped */
+    return (ret != MAILBOX_SUCCESS) && (reply == 0);
+}
+#endif
+
+static void *client_runner(void *arg)
+{
+    struct bench_client_t *client = (struct bench_client_t *)arg;
+    uint64_t start, elapsed;
+    uint32_t seq;
+    bool is_ok;
+
+    for (seq = 0; seq < client->nr_calls; seq++) {
+        start = now_ns();
+
+        if ((seq % BENCH_VERSION_INTERVAL) == 0) {
+            is_ok = bench_version(client);
+        } else {
+            is_ok = bench_call(client, seq);
+        }
+
+        elapsed = now_ns() - start;
+        client->total_ns += elapsed;
+        if (elapsed > client->max_ns) {
+            client->max_ns = elapsed;
+        }
+
+        if (!is_ok) {
+            client->nr_errors++;
+        }
+    }
+
+    return NULL;
+}
+
+static void print_notify_stats(const char *name,
+                               const struct mailbox_notify_stats_t *stats)
+{
+    printf("%s: %u messages, %u notifications",
+           name, (unsigned int)stats->nr_msgs, (unsigned int)stats->nr_notify);
+    if (stats->nr_notify > 0) {
+        printf(", %.2f messages per notification",
+               (double)stats->nr_msgs / stats->nr_notify);
+    }
+    printf("\r\n");
+}
+
+int main(int argc, char *argv[])
+{
+    static struct bench_client_t clients[BENCH_MAX_CLIENTS];
+    struct mailbox_notify_stats_t ns_stats, spe_stats;
+    uint32_t nr_clients = BENCH_DEFAULT_CLIENTS;
+    uint32_t nr_calls = BENCH_DEFAULT_CALLS;
+    uint32_t i, nr_errors = 0;
+    uint64_t start, elapsed, total_ns = 0, max_ns = 0;
+    double total_calls;
+
+    if (argc > 1) {
+        nr_clients = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        nr_calls = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+    if ((nr_clients == 0) || (nr_clients > BENCH_MAX_CLIENTS) ||
+        (nr_calls == 0)) {
+        printf("Usage: %s [nr_clients (1-%d)] [nr_calls_per_client]\r\n",
+               argv[0], BENCH_MAX_CLIENTS);
+        return EXIT_FAILURE;
+    }
+
+    printf("Mailbox benchmark, %u slots, %u clients, %u calls per client\r\n",
+           (unsigned int)NUM_MAILBOX_QUEUE_SLOT, (unsigned int)nr_clients,
+           (unsigned int)nr_calls);
+
+    if (sim_start() != MAILBOX_SUCCESS) {
+        printf("FAIL: Cannot start the simulation\r\n");
+        return EXIT_FAILURE;
+    }
+
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+    if (!bench_abandon()) {
+        printf("FAIL: Abandoned call is replied\r\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    start = now_ns();
+
+    for (i = 0; i < nr_clients; i++) {
+        clients[i].client_id = -(int32_t)(i + 1);
+        clients[i].nr_calls = nr_calls;
+        if (pthread_create(&clients[i].thread, NULL, client_runner,
+                           &clients[i]) != 0) {
+            printf("FAIL: Cannot create client threads\r\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; i < nr_clients; i++) {
+        pthread_join(clients[i].thread, NULL);
+        nr_errors += clients[i].nr_errors;
+        total_ns += clients[i].total_ns;
+        if (clients[i].max_ns > max_ns) {
+            max_ns = clients[i].max_ns;
+        }
+    }
+
+    elapsed = now_ns() - start;
+
+    (void)tfm_ns_mailbox_get_notify_stats(&ns_stats);
+    tfm_mailbox_get_notify_stats(&spe_stats);
+
+    sim_stop();
+
+    total_calls = (double)nr_clients * nr_calls;
+    printf("%.0f calls/s, latency average %.2f us, max %.2f us\r\n",
+           total_calls * 1e9 / (double)elapsed,
+           (double)total_ns / total_calls / 1e3, (double)max_ns / 1e3);
+    print_notify_stats("NSPE requests", &ns_stats);
+    print_notify_stats("SPE replies", &spe_stats);
+
+    if (nr_errors > 0) {
+        printf("FAIL: %u calls returned a wrong result\r\n",
+               (unsigned int)nr_errors);
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: Mailbox benchmark\r\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host stress test of the mailbox ring. NSPE and SPE are simulated by threads
+ * sharing the rings in ordinary memory, which pass a large number of requests
+ * and completions through rings of NUM_MAILBOX_QUEUE_SLOT entries.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAILBOX_RING_BARRIER()              __sync_synchronize()
+
+#include "tfm_mailbox.h"
+
+#ifndef TFM_MULTI_CORE_MAILBOX_RING
+#error "TFM_MULTI_CORE_MAILBOX_RING should be selected to test mailbox ring"
+#endif
+
+#ifndef MAILBOX_RING_TEST_ITERATIONS
+#define MAILBOX_RING_TEST_ITERATIONS        1000000
+#endif
+
+/* The time a thread waits for a notification before the test fails */
+#define NOTIFY_TIMEOUT_SEC                  5
+
+static struct mailbox_req_ring_t req_ring;
+static struct mailbox_cpl_ring_t cpl_ring;
+
+/* Set when a thread finds an error, to stop the others */
+static volatile bool is_failed;
+
+#define TEST_FAIL(...)                                          \
+    do {                                                        \
+        printf("FAIL: " __VA_ARGS__);                           \
+        printf("\r\n");                                         \
+        is_failed = true;                                       \
+    } while (0)
+
+static void rings_reset(void)
+{
+    memset(&req_ring, 0, sizeof(req_ring));
+    memset(&cpl_ring, 0, sizeof(cpl_ring));
+    is_failed = false;
+}
+
+/* Fill every field of a message from the sequence number of the request */
+static void msg_fill(struct mailbox_msg_t *msg, uint32_t seq)
+{
+    memset(msg, 0, sizeof(*msg));
+    msg->call_type = seq;
+    msg->params.psa_call_params.handle = (psa_handle_t)(seq ^ 0x5A5A5A5A);
+    msg->params.psa_call_params.type = (int32_t)(seq * 3);
+    msg->params.psa_call_params.in_len = seq & 0x3;
+    msg->params.psa_call_params.out_len = (seq >> 2) & 0x3;
+    msg->client_id = -(int32_t)(seq & 0x7FFFFFFF) - 1;
+}
+
+static bool msg_check(const struct mailbox_msg_t *msg, uint32_t seq)
+{
+    struct mailbox_msg_t expected;
+
+    msg_fill(&expected, seq);
+
+    return (msg->call_type == expected.call_type) &&
+           (msg->params.psa_call_params.handle ==
+            expected.params.psa_call_params.handle) &&
+           (msg->params.psa_call_params.type ==
+            expected.params.psa_call_params.type) &&
+           (msg->params.psa_call_params.in_len ==
+            expected.params.psa_call_params.in_len) &&
+           (msg->params.psa_call_params.out_len ==
+            expected.params.psa_call_params.out_len) &&
+           (msg->client_id == expected.client_id);
+}
+
+static void check_count(uint32_t head, uint32_t tail)
+{
+    uint32_t count;
+
+    if (!mailbox_ring_count(head, tail, &count)) {
+        TEST_FAIL("%u entries in a ring of %u", (unsigned int)count,
+                  (unsigned int)MAILBOX_RING_DEPTH);
+    }
+}
+
+static void *req_producer(void *arg)
+{
+    struct mailbox_msg_t msg;
+    uint32_t seq = 0;
+
+    (void)arg;
+
+    while ((seq < MAILBOX_RING_TEST_ITERATIONS) && !is_failed) {
+        msg_fill(&msg, seq);
+        if (!mailbox_req_ring_put(&req_ring, &msg, seq)) {
+            check_count(req_ring.head, req_ring.tail);
+            sched_yield();
+            continue;
+        }
+        seq++;
+    }
+
+    return NULL;
+}
+
+static void *req_consumer(void *arg)
+{
+    struct mailbox_msg_t msg;
+    uint32_t token;
+    uint32_t seq = 0;
+
+    (void)arg;
+
+    while ((seq < MAILBOX_RING_TEST_ITERATIONS) && !is_failed) {
+        if (!mailbox_req_ring_get(&req_ring, &msg, &token)) {
+            check_count(req_ring.head, req_ring.tail);
+            sched_yield();
+            continue;
+        }
+
+        if ((token != seq) || !msg_check(&msg, seq)) {
+            TEST_FAIL("Request %u received as token %u", (unsigned int)seq,
+                      (unsigned int)token);
+            break;
+        }
+        seq++;
+    }
+
+    return NULL;
+}
+
+/* SPE side of the round trip. Each request is completed as it is consumed. */
+static void *spe_agent(void *arg)
+{
+    struct mailbox_msg_t msg;
+    uint32_t token;
+    uint32_t seq = 0;
+
+    (void)arg;
+
+    while ((seq < MAILBOX_RING_TEST_ITERATIONS) && !is_failed) {
+        if (!mailbox_req_ring_get(&req_ring, &msg, &token)) {
+            sched_yield();
+            continue;
+        }
+
+        if ((token != seq) || !msg_check(&msg, seq)) {
+            TEST_FAIL("Request %u received as token %u", (unsigned int)seq,
+                      (unsigned int)token);
+            break;
+        }
+
+        while (!mailbox_cpl_ring_put(&cpl_ring, token, (int32_t)~token)) {
+            if (is_failed) {
+                return NULL;
+            }
+            check_count(cpl_ring.head, cpl_ring.tail);
+            sched_yield();
+        }
+        seq++;
+    }
+
+    return NULL;
+}
+
+/* NSPE side of the round trip. It both submits and collects. */
+static void *nspe_client(void *arg)
+{
+    struct mailbox_msg_t msg;
+    struct mailbox_ring_cpl_t cpl;
+    uint32_t sent = 0, done = 0;
+
+    (void)arg;
+
+    while ((done < MAILBOX_RING_TEST_ITERATIONS) && !is_failed) {
+        if (sent < MAILBOX_RING_TEST_ITERATIONS) {
+            msg_fill(&msg, sent);
+            if (mailbox_req_ring_put(&req_ring, &msg, sent)) {
+                sent++;
+            }
+        }
+
+        if (!mailbox_cpl_ring_get(&cpl_ring, &cpl)) {
+            check_count(cpl_ring.head, cpl_ring.tail);
+            sched_yield();
+            continue;
+        }
+
+        if ((cpl.token != done) || (cpl.return_val != (int32_t)~done)) {
+            TEST_FAIL("Completion %u received as token %u", (unsigned int)done,
+                      (unsigned int)cpl.token);
+            break;
+        }
+        done++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Notification handshake. NSPE only notifies SPE when SPE is not draining the
+ * request ring. A request missed by both sides would leave SPE waiting for a
+ * notification forever.
+ */
+static sem_t spe_notify;
+static volatile uint32_t nr_notify;
+
+static bool wait_notify(sem_t *sem)
+{
+    struct timespec ts;
+    int ret;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += NOTIFY_TIMEOUT_SEC;
+
+    do {
+        ret = sem_timedwait(sem, &ts);
+    } while ((ret != 0) && (errno == EINTR));
+
+    return ret == 0;
+}
+
+static void *notified_spe_agent(void *arg)
+{
+    struct mailbox_msg_t msg;
+    uint32_t token;
+    uint32_t seq = 0;
+
+    (void)arg;
+
+    while ((seq < MAILBOX_RING_TEST_ITERATIONS) && !is_failed) {
+        if (!wait_notify(&spe_notify)) {
+            TEST_FAIL("Request %u lost a notification", (unsigned int)seq);
+            break;
+        }
+
+        do {
+            mailbox_req_ring_set_consumer_busy(&req_ring, true);
+
+            while (mailbox_req_ring_get(&req_ring, &msg, &token)) {
+                if ((token != seq) || !msg_check(&msg, seq)) {
+                    TEST_FAIL("Request %u received as token %u",
+                              (unsigned int)seq, (unsigned int)token);
+                    return NULL;
+                }
+                seq++;
+            }
+
+            mailbox_req_ring_set_consumer_busy(&req_ring, false);
+        } while (!mailbox_req_ring_is_empty(&req_ring));
+    }
+
+    return NULL;
+}
+
+static void *notifying_producer(void *arg)
+{
+    struct mailbox_msg_t msg;
+    uint32_t seq = 0;
+
+    (void)arg;
+
+    while ((seq < MAILBOX_RING_TEST_ITERATIONS) && !is_failed) {
+        msg_fill(&msg, seq);
+        if (!mailbox_req_ring_put(&req_ring, &msg, seq)) {
+            sched_yield();
+            continue;
+        }
+        seq++;
+
+        if (!mailbox_req_ring_is_consumer_busy(&req_ring)) {
+            nr_notify++;
+            sem_post(&spe_notify);
+        }
+    }
+
+    return NULL;
+}
+
+static bool run_pair(void *(*first)(void *), void *(*second)(void *))
+{
+    pthread_t threads[2];
+
+    if ((pthread_create(&threads[0], NULL, first, NULL) != 0) ||
+        (pthread_create(&threads[1], NULL, second, NULL) != 0)) {
+        printf("FAIL: Cannot create test threads\r\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    return !is_failed;
+}
+
+/* Indexes written by the peer are not trusted */
+static bool test_corrupted_index(void)
+{
+    struct mailbox_msg_t msg;
+    struct mailbox_ring_cpl_t cpl;
+    uint32_t token;
+
+    rings_reset();
+    msg_fill(&msg, 0);
+
+    req_ring.head = 0x10;
+    req_ring.tail = req_ring.head - MAILBOX_RING_DEPTH - 1;
+    if (mailbox_req_ring_get(&req_ring, &msg, &token) ||
+        mailbox_req_ring_put(&req_ring, &msg, 0) ||
+        !mailbox_req_ring_is_empty(&req_ring)) {
+        TEST_FAIL("Corrupted request ring is used");
+    }
+
+    cpl_ring.tail = 0xFFFFFFF0;
+    cpl_ring.head = cpl_ring.tail + MAILBOX_RING_DEPTH + 1;
+    if (mailbox_cpl_ring_get(&cpl_ring, &cpl) ||
+        mailbox_cpl_ring_put(&cpl_ring, 0, 0)) {
+        TEST_FAIL("Corrupted completion ring is used");
+    }
+
+    return !is_failed;
+}
+
+/* The free-running indexes wrap around */
+static bool test_index_wrap(void)
+{
+    rings_reset();
+    req_ring.head = req_ring.tail = 0U - (MAILBOX_RING_TEST_ITERATIONS / 2);
+
+    return run_pair(req_producer, req_consumer);
+}
+
+static bool test_req_ring(void)
+{
+    rings_reset();
+
+    return run_pair(req_producer, req_consumer);
+}
+
+static bool test_round_trip(void)
+{
+    rings_reset();
+
+    return run_pair(nspe_client, spe_agent);
+}
+
+static bool test_consumer_busy(void)
+{
+    bool ret;
+
+    rings_reset();
+    nr_notify = 0;
+    sem_init(&spe_notify, 0, 0);
+
+    ret = run_pair(notifying_producer, notified_spe_agent);
+
+    sem_destroy(&spe_notify);
+    printf("    %u notifications for %u requests\r\n", (unsigned int)nr_notify,
+           (unsigned int)MAILBOX_RING_TEST_ITERATIONS);
+
+    return ret;
+}
+
+static const struct {
+    const char *name;
+    bool (*func)(void);
+} tests[] = {
+    {"Corrupted index",     test_corrupted_index},
+    {"Request ring",        test_req_ring},
+    {"Index wrap around",   test_index_wrap},
+    {"Round trip",          test_round_trip},
+    {"Consumer busy flag",  test_consumer_busy},
+};
+
+int main(void)
+{
+    uint32_t i;
+    bool is_passed = true;
+
+    printf("Mailbox ring stress test, depth %u, %u requests\r\n",
+           (unsigned int)MAILBOX_RING_DEPTH,
+           (unsigned int)MAILBOX_RING_TEST_ITERATIONS);
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        if (tests[i].func()) {
+            printf("PASS: %s\r\n", tests[i].name);
+        } else {
+            printf("FAIL: %s\r\n", tests[i].name);
+            is_passed = false;
+        }
+    }
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Simulated platform of the mailbox host benchmark. It implements the NSPE
+ * mailbox HAL and OS wrapper and the SPE mailbox HAL. The SPE mailbox delivers
+ * the requests to the simulated SPM via TF-M RPC.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "mailbox_sim.h"
+#include "tfm_multi_core.h"
+#include "tfm_ns_mailbox.h"
+#include "tfm_rpc.h"
+#include "tfm_spe_mailbox.h"
+
+/* The NSPE mailbox queue in the memory shared by both cores */
+static struct ns_mailbox_queue_t ns_queue;
+
+/*
+ * Both the interrupt masks and the inter-core lock are replaced by a single
+ * recursive lock, so that the order of taking them cannot deadlock.
+ */
+static pthread_mutex_t core_lock;
+
+/* The NS spin lock between NS threads */
+static pthread_mutex_t ns_spin_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The mailbox interrupts of both cores */
+static sem_t spe_mailbox_irq;
+static sem_t ns_mailbox_irq;
+
+/* Limits the NS threads calling the mailbox to the number of queue slots */
+static sem_t ns_slot_sem;
+
+static volatile bool is_stopping;
+static pthread_t spe_agent_thread;
+static pthread_t ns_irq_thread;
+
+/* The NS task handle is the semaphore the task sleeps on */
+struct sim_task_t {
+    bool  is_init;
+    sem_t reply_sem;
+};
+
+static __thread struct sim_task_t ns_task;
+
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+/* The slot semaphores of the NSPE mailbox */
+static sem_t slot_sems[NUM_MAILBOX_QUEUE_SLOT];
+static uint32_t nr_slot_sems;
+
+/* 0 if a client waits for its reply until the simulation fails */
+static volatile uint32_t reply_timeout_ms;
+#endif
+
+/* Wait for a semaphore for at most timeout_ms. Return false on timeout. */
+static bool sim_timed_wait(sem_t *sem, uint32_t timeout_ms)
+{
+    struct timespec ts;
+    int ret;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    do {
+        ret = sem_timedwait(sem, &ts);
+    } while ((ret != 0) && (errno == EINTR));
+
+    return ret == 0;
+}
+
+static void sim_wait(sem_t *sem, const char *event)
+{
+    if (!sim_timed_wait(sem, SIM_TIMEOUT_SEC * 1000)) {
+        SIM_FATAL("No %s in %d seconds", event, SIM_TIMEOUT_SEC);
+    }
+}
+
+void sim_spe_lock(void)
+{
+    pthread_mutex_lock(&core_lock);
+}
+
+void sim_spe_unlock(void)
+{
+    pthread_mutex_unlock(&core_lock);
+}
+
+/* NSPE mailbox HAL */
+int32_t tfm_ns_mailbox_hal_init(struct ns_mailbox_queue_t *queue)
+{
+    (void)queue;
+
+    return MAILBOX_SUCCESS;
+}
+
+int32_t tfm_ns_mailbox_hal_notify_peer(void)
+{
+    sem_post(&spe_mailbox_irq);
+
+    return MAILBOX_SUCCESS;
+}
+
+void tfm_ns_mailbox_hal_enter_critical(void)
+{
+    pthread_mutex_lock(&core_lock);
+}
+
+void tfm_ns_mailbox_hal_exit_critical(void)
+{
+    pthread_mutex_unlock(&core_lock);
+}
+
+void tfm_ns_mailbox_hal_enter_critical_isr(void)
+{
+    pthread_mutex_lock(&core_lock);
+}
+
+void tfm_ns_mailbox_hal_exit_critical_isr(void)
+{
+    pthread_mutex_unlock(&core_lock);
+}
+
+/* NSPE mailbox OS wrapper */
+int32_t tfm_ns_mailbox_os_lock_init(void)
+{
+    if (sem_init(&ns_slot_sem, 0, NUM_MAILBOX_QUEUE_SLOT) != 0) {
+        return MAILBOX_GENERIC_ERROR;
+    }
+
+    return MAILBOX_SUCCESS;
+}
+
+int32_t tfm_ns_mailbox_os_lock_acquire(void)
+{
+    sim_wait(&ns_slot_sem, "free mailbox slot");
+
+    return MAILBOX_SUCCESS;
+}
+
+int32_t tfm_ns_mailbox_os_lock_release(void)
+{
+    sem_post(&ns_slot_sem);
+
+    return MAILBOX_SUCCESS;
+}
+
+const void *tfm_ns_mailbox_os_get_task_handle(void)
+{
+    if (!ns_task.is_init) {
+        sem_init(&ns_task.reply_sem, 0, 0);
+        ns_task.is_init = true;
+    }
+
+    return &ns_task;
+}
+
+void tfm_ns_mailbox_os_wait_reply(void)
+{
+    sim_wait(&ns_task.reply_sem, "mailbox reply");
+}
+
+void tfm_ns_mailbox_os_wake_task_isr(const void *task_handle)
+{
+    struct sim_task_t *task = (struct sim_task_t *)task_handle;
+
+    if (task) {
+        sem_post(&task->reply_sem);
+    }
+}
+
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+void *tfm_ns_mailbox_os_sem_create(void)
+{
+    sem_t *sem;
+
+    if (nr_slot_sems >= NUM_MAILBOX_QUEUE_SLOT) {
+        return NULL;
+    }
+
+    sem = &slot_sems[nr_slot_sems];
+    if (sem_init(sem, 0, 0) != 0) {
+        return NULL;
+    }
+    nr_slot_sems++;
+
+    return sem;
+}
+
+int32_t tfm_ns_mailbox_os_sem_wait(void *sem_handle)
+{
+    uint32_t timeout_ms = reply_timeout_ms;
+
+    if (timeout_ms == 0) {
+        sim_wait((sem_t *)sem_handle, "mailbox reply");
+        return MAILBOX_SUCCESS;
+    }
+
+    if (!sim_timed_wait((sem_t *)sem_handle, timeout_ms)) {
+        return MAILBOX_GENERIC_ERROR;
+    }
+
+    return MAILBOX_SUCCESS;
+}
+
+void tfm_ns_mailbox_os_sem_post_isr(void *sem_handle)
+{
+    sem_post((sem_t *)sem_handle);
+}
+
+void sim_set_reply_timeout_ms(uint32_t timeout_ms)
+{
+    reply_timeout_ms = timeout_ms;
+}
+#endif /* TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT */
+
+void tfm_ns_mailbox_os_spin_lock(void)
+{
+    pthread_mutex_lock(&ns_spin_lock);
+}
+
+void tfm_ns_mailbox_os_spin_unlock(void)
+{
+    pthread_mutex_unlock(&ns_spin_lock);
+}
+
+/* SPE mailbox HAL */
+int32_t tfm_mailbox_hal_init(struct secure_mailbox_queue_t *s_queue)
+{
+    s_queue->ns_queue = &ns_queue;
+
+    return MAILBOX_SUCCESS;
+}
+
+int32_t tfm_mailbox_hal_notify_peer(void)
+{
+    sem_post(&ns_mailbox_irq);
+
+    return MAILBOX_SUCCESS;
+}
+
+void tfm_mailbox_hal_enter_critical(void)
+{
+    pthread_mutex_lock(&core_lock);
+}
+
+void tfm_mailbox_hal_exit_critical(void)
+{
+    pthread_mutex_unlock(&core_lock);
+}
+
+static void *spe_agent_runner(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        sem_wait(&spe_mailbox_irq);
+        if (is_stopping) {
+            break;
+        }
+        tfm_rpc_client_call_handler();
+    }
+
+    return NULL;
+}
+
+static void *ns_irq_runner(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        sem_wait(&ns_mailbox_irq);
+        if (is_stopping) {
+            break;
+        }
+        (void)tfm_ns_mailbox_wake_reply_owner_isr();
+    }
+
+    return NULL;
+}
+
+int32_t sim_start(void)
+{
+    pthread_mutexattr_t attr;
+    int32_t ret;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&core_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    sem_init(&spe_mailbox_irq, 0, 0);
+    sem_init(&ns_mailbox_irq, 0, 0);
+    is_stopping = false;
+
+    ret = tfm_ns_mailbox_init(&ns_queue);
+    if (ret != MAILBOX_SUCCESS) {
+        return ret;
+    }
+
+    ret = tfm_inter_core_comm_init();
+    if (ret != MAILBOX_SUCCESS) {
+        return ret;
+    }
+
+    if ((sim_spm_start() != 0) ||
+        (pthread_create(&spe_agent_thread, NULL, spe_agent_runner,
+                        NULL) != 0) ||
+        (pthread_create(&ns_irq_thread, NULL, ns_irq_runner, NULL) != 0)) {
+        return MAILBOX_GENERIC_ERROR;
+    }
+
+    return MAILBOX_SUCCESS;
+}
+
+void sim_stop(void)
+{
+    is_stopping = true;
+
+    sem_post(&spe_mailbox_irq);
+    sem_post(&ns_mailbox_irq);
+
+    pthread_join(spe_agent_thread, NULL);
+    pthread_join(ns_irq_thread, NULL);
+
+    sim_spm_stop();
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpc_loopback.h"
+
+static struct rpc_loopback_msg_t *msg_queue[RPC_LOOPBACK_QUEUE_SIZE];
+static uint32_t nr_queued_msgs;
+
+static struct rpc_loopback_stats_t loopback_stats;
+
+static void loopback_submit(struct rpc_loopback_msg_t *msg,
+                            struct tfm_rpc_req_t *req)
+{
+    req->call_type = msg->call_type;
+    req->params = msg->params;
+    req->caller_data = msg;
+    req->client_id = msg->client_id;
+
+    tfm_rpc_req_submit(req);
+}
+
+/* RPC handle_req() callback */
+static void loopback_handle_req(void)
+{
+    struct tfm_rpc_req_t *req;
+    uint32_t i;
+
+    for (i = 0; i < nr_queued_msgs; i++) {
+        /* A full request pool is dispatched before the next message */
+        req = tfm_rpc_req_alloc();
+        if (!req) {
+            tfm_rpc_req_dispatch();
+            loopback_stats.nr_dispatch++;
+            req = tfm_rpc_req_alloc();
+        }
+
+        loopback_submit(msg_queue[i], req);
+    }
+
+    nr_queued_msgs = 0;
+
+    tfm_rpc_req_dispatch();
+    loopback_stats.nr_dispatch++;
+}
+
+static void loopback_write_reply(const void *owner, int32_t ret,
+                                 bool is_direct)
+{
+    struct rpc_loopback_msg_t *msg = (struct rpc_loopback_msg_t *)owner;
+
+    if (msg->is_replied) {
+        printf("FAIL: Message replied twice\r\n");
+        exit(EXIT_FAILURE);
+    }
+
+    msg->reply = ret;
+    msg->is_direct = is_direct;
+    msg->reply_seq = loopback_stats.nr_replies++;
+    msg->is_replied = true;
+
+    loopback_stats.nr_unnotified++;
+}
+
+/* RPC reply() callback */
+static void loopback_reply(const void *owner, int32_t ret)
+{
+    loopback_write_reply(owner, ret, false);
+}
+
+/* RPC reply_direct() callback */
+static void loopback_reply_direct(const void *owner, int32_t ret)
+{
+    loopback_write_reply(owner, ret, true);
+}
+
+/* RPC notify() callback */
+static void loopback_notify(void)
+{
+    loopback_stats.nr_notify++;
+    loopback_stats.nr_unnotified = 0;
+}
+
+static const struct tfm_rpc_ops_t loopback_batched_ops = {
+    .handle_req   = loopback_handle_req,
+    .reply        = loopback_reply,
+    .reply_direct = loopback_reply_direct,
+    .notify       = loopback_notify,
+};
+
+static const struct tfm_rpc_ops_t loopback_ops = {
+    .handle_req   = loopback_handle_req,
+    .reply        = loopback_reply,
+};
+
+int32_t rpc_loopback_init(bool is_batched)
+{
+    nr_queued_msgs = 0;
+    memset(&loopback_stats, 0, sizeof(loopback_stats));
+
+    return tfm_rpc_register_ops(is_batched ? &loopback_batched_ops :
+                                             &loopback_ops);
+}
+
+void rpc_loopback_deinit(void)
+{
+    tfm_rpc_unregister_ops();
+    nr_queued_msgs = 0;
+    memset(&loopback_stats, 0, sizeof(loopback_stats));
+}
+
+void rpc_loopback_send(struct rpc_loopback_msg_t *msg)
+{
+    if (nr_queued_msgs >= RPC_LOOPBACK_QUEUE_SIZE) {
+        printf("FAIL: More than %d messages queued\r\n",
+               RPC_LOOPBACK_QUEUE_SIZE);
+        exit(EXIT_FAILURE);
+    }
+
+    msg->is_replied = false;
+    msg_queue[nr_queued_msgs++] = msg;
+}
+
+void rpc_loopback_get_stats(struct rpc_loopback_stats_t *stats)
+{
+    *stats = loopback_stats;
+}
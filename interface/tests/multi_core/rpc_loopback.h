@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host loopback transport of TF-M RPC. The messages are passed in memory
+ * without an inter-core mailbox. The caller queues them, then runs
+ * tfm_rpc_client_call_handler() as the mailbox interrupt does on a target.
+ * The transport is not thread safe.
+ */
+
+#ifndef __RPC_LOOPBACK_H__
+#define __RPC_LOOPBACK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tfm_rpc.h"
+
+/* The maximum number of messages queued before they are handled */
+#define RPC_LOOPBACK_QUEUE_SIZE             32
+
+struct rpc_loopback_msg_t {
+    uint32_t                    call_type;  /* TFM_RPC_PSA_* */
+    struct client_call_params_t params;
+    int32_t                     client_id;
+
+    /* Written by the transport when the message is replied */
+    bool                        is_replied;
+    bool                        is_direct;  /* Replied via reply_direct() */
+    int32_t                     reply;
+    uint32_t                    reply_seq;  /* Order of the reply */
+};
+
+struct rpc_loopback_stats_t {
+    uint32_t nr_replies;
+    uint32_t nr_unnotified;     /* Replies written since the last notify() */
+    uint32_t nr_notify;
+    uint32_t nr_dispatch;       /* Calls of tfm_rpc_req_dispatch() */
+};
+
+/*
+ * Register the loopback operations with TF-M RPC. If is_batched is false,
+ * the optional reply_direct() and notify() operations are not provided.
+ */
+int32_t rpc_loopback_init(bool is_batched);
+
+/* Unregister the loopback operations and clear the statistics */
+void rpc_loopback_deinit(void);
+
+/* Queue a message to be handled by the next handle_req() */
+void rpc_loopback_send(struct rpc_loopback_msg_t *msg);
+
+void rpc_loopback_get_stats(struct rpc_loopback_stats_t *stats);
+
+#endif /* __RPC_LOOPBACK_H__ */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host test of the TF-M RPC request pool and scheduler. The requests are
+ * passed by the loopback transport to the simulated SPM, whose partition is
+ * run by the test itself so that the order of the replies is deterministic.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpc_loopback.h"
+#include "spm_sim.h"
+
+#define TEST_VEC_SIZE                       16
+
+/* The type of a request which no transport delivers */
+#define TEST_INVALID_CALL_TYPE              0x7F
+
+static bool is_failed;
+
+#define TEST_CHECK(cond, ...)                                   \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            printf("FAIL: " __VA_ARGS__);                       \
+            printf("\r\n");                                     \
+            is_failed = true;                                   \
+        }                                                       \
+    } while (0)
+
+struct test_call_t {
+    struct rpc_loopback_msg_t msg;
+    psa_invec                 in_vec[1];
+    psa_outvec                out_vec[1];
+    uint8_t                   in_buf[TEST_VEC_SIZE];
+    uint8_t                   out_buf[TEST_VEC_SIZE];
+};
+
+static void test_version(struct rpc_loopback_msg_t *msg, uint32_t call_type,
+                         uint32_t sid)
+{
+    memset(msg, 0, sizeof(*msg));
+    msg->call_type = call_type;
+    msg->params.sid = sid;
+    msg->client_id = -1;
+}
+
+static void test_call(struct test_call_t *call, psa_handle_t handle,
+                      int32_t type)
+{
+    memset(call, 0, sizeof(*call));
+    memset(call->in_buf, type, sizeof(call->in_buf));
+
+    call->in_vec[0].base = call->in_buf;
+    call->in_vec[0].len = sizeof(call->in_buf);
+    call->out_vec[0].base = call->out_buf;
+    call->out_vec[0].len = sizeof(call->out_buf);
+
+    call->msg.call_type = TFM_RPC_PSA_CALL;
+    call->msg.params.handle = handle;
+    call->msg.params.type = type;
+    call->msg.params.in_vec = call->in_vec;
+    call->msg.params.in_len = 1;
+    call->msg.params.out_vec = call->out_vec;
+    call->msg.params.out_len = 1;
+    call->msg.client_id = -1;
+}
+
+static bool test_call_done(const struct test_call_t *call)
+{
+    return call->msg.is_replied && !call->msg.is_direct &&
+           (call->msg.reply ==
+            SIM_SERVICE_RESULT(call->msg.params.type, TEST_VEC_SIZE)) &&
+           (call->out_vec[0].len == TEST_VEC_SIZE) &&
+           (memcmp(call->in_buf, call->out_buf, TEST_VEC_SIZE) == 0);
+}
+
+static void serve_all(void)
+{
+    while (sim_spm_serve()) {
+    }
+}
+
+/*
+ * The requests are dispatched by the priority of the requested service, in
+ * the submission order for equal priority. The requests which cannot reach a
+ * service go first, and are replied directly with a single notification.
+ */
+static bool test_priority_order(void)
+{
+    struct test_call_t normal_call, high_call, bad_call;
+    struct rpc_loopback_msg_t version, unknown;
+    struct rpc_loopback_stats_t stats;
+
+    test_call(&normal_call, SIM_SERVICE_HANDLE, 1);
+    test_call(&high_call, SIM_HIGH_SERVICE_HANDLE, 2);
+    test_version(&version, TFM_RPC_PSA_VERSION, SIM_SERVICE_SID);
+    test_call(&bad_call, (psa_handle_t)0x40000099, 3);
+    test_version(&unknown, TEST_INVALID_CALL_TYPE, 0);
+
+    rpc_loopback_send(&normal_call.msg);
+    rpc_loopback_send(&high_call.msg);
+    rpc_loopback_send(&version);
+    rpc_loopback_send(&bad_call.msg);
+    rpc_loopback_send(&unknown);
+
+    tfm_rpc_client_call_handler();
+
+    rpc_loopback_get_stats(&stats);
+    TEST_CHECK(stats.nr_replies == 3, "%u direct replies",
+               (unsigned int)stats.nr_replies);
+    TEST_CHECK(stats.nr_notify == 1, "%u notifications for direct replies",
+               (unsigned int)stats.nr_notify);
+    TEST_CHECK(bad_call.msg.is_direct && (bad_call.msg.reply_seq == 0) &&
+               (bad_call.msg.reply == PSA_ERROR_PROGRAMMER_ERROR),
+               "Invalid handle not rejected first");
+    TEST_CHECK(unknown.is_direct && (unknown.reply_seq == 1) &&
+               (unknown.reply == PSA_ERROR_NOT_SUPPORTED),
+               "Unknown call type not rejected in order");
+    TEST_CHECK(version.is_direct && (version.reply_seq == 2) &&
+               (version.reply == SIM_SERVICE_VERSION),
+               "Version not replied after the higher priority requests");
+    TEST_CHECK(!normal_call.msg.is_replied && !high_call.msg.is_replied,
+               "Call replied before the service runs");
+
+    /* The partition serves the calls in the order they were dispatched */
+    serve_all();
+
+    rpc_loopback_get_stats(&stats);
+    TEST_CHECK(test_call_done(&high_call) && (high_call.msg.reply_seq == 3),
+               "High priority call not dispatched first");
+    TEST_CHECK(test_call_done(&normal_call) &&
+               (normal_call.msg.reply_seq == 4),
+               "Normal priority call not dispatched last");
+    TEST_CHECK((stats.nr_notify == 3) && (stats.nr_unnotified == 0),
+               "%u notifications, %u replies not notified",
+               (unsigned int)stats.nr_notify,
+               (unsigned int)stats.nr_unnotified);
+
+    return !is_failed;
+}
+
+/* More requests than the pool holds are dispatched in several rounds */
+static bool test_pool_full(void)
+{
+    static struct test_call_t calls[3 * TFM_RPC_REQ_POOL_SIZE + 1];
+    struct rpc_loopback_stats_t stats;
+    uint32_t i, nr_calls = sizeof(calls) / sizeof(calls[0]);
+
+    for (i = 0; i < nr_calls; i++) {
+        test_call(&calls[i], (i & 0x1) ? SIM_HIGH_SERVICE_HANDLE :
+                                         SIM_SERVICE_HANDLE, (int32_t)i);
+        rpc_loopback_send(&calls[i].msg);
+    }
+
+    tfm_rpc_client_call_handler();
+    serve_all();
+
+    rpc_loopback_get_stats(&stats);
+    TEST_CHECK(stats.nr_dispatch == 4, "%u dispatch rounds for %u requests",
+               (unsigned int)stats.nr_dispatch, (unsigned int)nr_calls);
+    TEST_CHECK(stats.nr_replies == nr_calls, "%u replies for %u requests",
+               (unsigned int)stats.nr_replies, (unsigned int)nr_calls);
+
+    for (i = 0; i < nr_calls; i++) {
+        TEST_CHECK(test_call_done(&calls[i]), "Call %u failed",
+                   (unsigned int)i);
+    }
+
+    return !is_failed;
+}
+
+/* Without the optional operations every result is returned via reply() */
+static bool test_basic_ops(void)
+{
+    struct test_call_t call;
+    struct rpc_loopback_msg_t version;
+    struct rpc_loopback_stats_t stats;
+
+    test_call(&call, SIM_SERVICE_HANDLE, 5);
+    test_version(&version, TFM_RPC_PSA_FRAMEWORK_VERSION, 0);
+
+    rpc_loopback_send(&call.msg);
+    rpc_loopback_send(&version);
+
+    tfm_rpc_client_call_handler();
+    serve_all();
+
+    rpc_loopback_get_stats(&stats);
+    TEST_CHECK(version.is_replied && !version.is_direct &&
+               (version.reply == (int32_t)PSA_FRAMEWORK_VERSION),
+               "Framework version not replied via reply()");
+    TEST_CHECK(test_call_done(&call), "Call failed");
+    TEST_CHECK(stats.nr_notify == 0, "%u notifications without notify()",
+               (unsigned int)stats.nr_notify);
+
+    return !is_failed;
+}
+
+static const struct {
+    const char *name;
+    bool (*func)(void);
+    bool is_batched;
+} tests[] = {
+    {"Priority order",      test_priority_order,    true},
+    {"Request pool full",   test_pool_full,         true},
+    {"Basic operations",    test_basic_ops,         false},
+};
+
+int main(void)
+{
+    uint32_t i;
+    bool is_passed = true;
+
+    printf("TF-M RPC loopback test, request pool of %u\r\n",
+           (unsigned int)TFM_RPC_REQ_POOL_SIZE);
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        is_failed = false;
+
+        if (rpc_loopback_init(tests[i].is_batched) != TFM_RPC_SUCCESS) {
+            printf("FAIL: Cannot register the loopback operations\r\n");
+            return EXIT_FAILURE;
+        }
+
+        if (tests[i].func()) {
+            printf("PASS: %s\r\n", tests[i].name);
+        } else {
+            printf("FAIL: %s\r\n", tests[i].name);
+            is_passed = false;
+        }
+
+        rpc_loopback_deinit();
+    }
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Host replacement of the CMSIS compiler definitions used by the mailbox */
+
+#ifndef __SIM_CMSIS_COMPILER_H__
+#define __SIM_CMSIS_COMPILER_H__
+
+#define __STATIC_INLINE                     static inline
+#define __ALIGNED(x)                        __attribute__((aligned(x)))
+#define __DMB()                             __sync_synchronize()
+#define __DSB()                             __sync_synchronize()
+
+#endif /* __SIM_CMSIS_COMPILER_H__ */
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host replacement of the SPE critical section. It takes the SPE local lock of
+ * the simulation instead of masking interrupts.
+ */
+
+#ifndef __SIM_CRITICAL_SECTION_H__
+#define __SIM_CRITICAL_SECTION_H__
+
+#include "mailbox_sim.h"
+
+struct critical_section_t {
+    int state;
+};
+
+#define CRITICAL_SECTION_STATIC_INIT   {.state = 0,}
+#define CRITICAL_SECTION_ENTER(cs)     do { (void)(cs); sim_spe_lock(); } while (0)
+#define CRITICAL_SECTION_LEAVE(cs)     sim_spe_unlock()
+
+#endif /* __SIM_CRITICAL_SECTION_H__ */
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Host replacement of the SPM client API handlers called by TF-M RPC */
+
+#ifndef __SIM_PSA_API_H__
+#define __SIM_PSA_API_H__
+
+#include <stdint.h>
+
+#include "psa/client.h"
+
+uint32_t tfm_spm_client_psa_framework_version(void);
+
+uint32_t tfm_spm_client_psa_version(uint32_t sid);
+
+psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
+                                     uint32_t ctrl_param,
+                                     const psa_invec *inptr,
+                                     psa_outvec *outptr);
+
+#endif /* __SIM_PSA_API_H__ */
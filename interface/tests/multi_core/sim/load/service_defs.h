@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* The service load information is not used by the mailbox on host */
+
+#ifndef __SIM_SERVICE_DEFS_H__
+#define __SIM_SERVICE_DEFS_H__
+
+#endif /* __SIM_SERVICE_DEFS_H__ */
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host simulation of a dual-core platform for the mailbox. NSPE and SPE run in
+ * threads of one process and share the mailbox queue in ordinary memory:
+ *
+ * - The NS client threads call tfm_ns_mailbox_client_call().
+ * - The SPE mailbox agent thread calls tfm_rpc_client_call_handler() when NSPE
+ *   notifies it, which delivers the requests to the simulated SPM via TF-M RPC.
+ * - The SPE partition thread of the simulated SPM runs the simulated service
+ *   and replies to the requests.
+ * - The NS mailbox IRQ thread wakes up the clients when SPE notifies NSPE.
+ *
+ * The interrupt masks of both cores are replaced by locks.
+ */
+
+#ifndef __MAILBOX_SIM_H__
+#define __MAILBOX_SIM_H__
+
+#include <stdint.h>
+
+#include "spm_sim.h"
+
+/* The SPE local critical section */
+void sim_spe_lock(void);
+void sim_spe_unlock(void);
+
+/* Initialize both mailboxes and start the simulated cores */
+int32_t sim_start(void);
+
+/* Stop the simulated cores */
+void sim_stop(void);
+
+#ifdef TFM_MULTI_CORE_NS_OS_MAILBOX_DIRECT
+/*
+ * Set the time a NS client waits for its reply before the client call fails.
+ * 0 restores the default, in which the simulation fails instead.
+ */
+void sim_set_reply_timeout_ms(uint32_t timeout_ms);
+#endif
+
+#endif /* __MAILBOX_SIM_H__ */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host replacement of the SPM definitions used by the mailbox and TF-M RPC.
+ * Only the owner partition of a service is kept, for the priority of the
+ * requests, and only the fields of a connection which TF-M RPC accesses.
+ */
+
+#ifndef __SIM_SPM_IPC_H__
+#define __SIM_SPM_IPC_H__
+
+#include <stdint.h>
+
+#include "psa/client.h"
+#include "psa/service.h"
+#include "load/partition_defs.h"
+
+struct partition_t {
+    const struct partition_load_info_t *p_ldinf;
+};
+
+struct service_t {
+    const void         *p_ldinf;
+    struct partition_t *partition;
+};
+
+struct conn_handle_t {
+    psa_msg_t  msg;
+    struct {
+        void   *owner;
+    } ack_evnt;
+    const void *caller_data;
+};
+
+struct service_t *tfm_spm_get_service_by_sid(uint32_t sid);
+
+struct service_t *tfm_spm_get_service_by_handle(psa_handle_t handle);
+
+#endif /* __SIM_SPM_IPC_H__ */
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host simulation of the part of SPM behind TF-M RPC. Version queries are
+ * answered at once. A psa_call() is checked, then queued to the simulated
+ * partition, which completes it via tfm_rpc_client_call_reply() as SPM does
+ * when a service replies.
+ */
+
+#ifndef __SPM_SIM_H__
+#define __SPM_SIM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "psa/client.h"
+
+/* The time a simulated core waits for an event before the simulation fails */
+#define SIM_TIMEOUT_SEC                     10
+
+#define SIM_FATAL(...)                                          \
+    do {                                                        \
+        printf("FAIL: " __VA_ARGS__);                           \
+        printf("\r\n");                                         \
+        exit(EXIT_FAILURE);                                     \
+    } while (0)
+
+/* The simulated services. The high one is in a higher priority partition. */
+#define SIM_SERVICE_SID                     0x0000F000
+#define SIM_SERVICE_HANDLE                  ((psa_handle_t)0x40000001)
+#define SIM_HIGH_SERVICE_SID                0x0000F001
+#define SIM_HIGH_SERVICE_HANDLE             ((psa_handle_t)0x40000002)
+#define SIM_SERVICE_VERSION                 1
+
+/*
+ * The simulated services reply to a psa_call() of this type after
+ * SIM_SERVICE_SLOW_MS, to let the client give up waiting.
+ */
+#define SIM_SERVICE_SLOW_TYPE               0x1000
+#define SIM_SERVICE_SLOW_MS                 300
+
+/* The result of a psa_call() to a simulated service */
+#define SIM_SERVICE_RESULT(type, in_size)   ((int32_t)(type) + (int32_t)(in_size))
+
+/* The maximum number of psa_call() pending in the simulated partition */
+#define SIM_MAX_PENDING_CALLS               64
+
+/*
+ * Complete the oldest psa_call() pending in the calling thread. Return false
+ * if none is pending.
+ */
+bool sim_spm_serve(void);
+
+/* Start a thread simulating the partition, which serves the calls queued */
+int32_t sim_spm_start(void);
+
+/* Stop the partition thread */
+void sim_spm_stop(void);
+
+#endif /* __SPM_SIM_H__ */
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Nothing of the architecture is used by the mailbox on host */
+
+#ifndef __SIM_TFM_ARCH_H__
+#define __SIM_TFM_ARCH_H__
+
+#endif /* __SIM_TFM_ARCH_H__ */
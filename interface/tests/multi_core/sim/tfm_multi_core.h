@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Host replacement of the multi-core SPM functions used by the mailbox */
+
+#ifndef __SIM_TFM_MULTI_CORE_H__
+#define __SIM_TFM_MULTI_CORE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+void tfm_multi_core_set_ns_local_region(const void *p, size_t s);
+
+void tfm_multi_core_set_ns_client(int32_t client_id);
+
+int32_t tfm_inter_core_comm_init(void);
+
+#endif /* __SIM_TFM_MULTI_CORE_H__ */
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Nothing of the SPM threads is used by the mailbox on host */
+
+#ifndef __SIM_THREAD_H__
+#define __SIM_THREAD_H__
+
+#endif /* __SIM_THREAD_H__ */
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Host replacement of the SPM utilities used by the mailbox */
+
+#ifndef __SIM_UTILITIES_H__
+#define __SIM_UTILITIES_H__
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPM_ASSERT(cond)                    assert(cond)
+
+#define spm_memcpy(dst, src, size)          memcpy(dst, src, size)
+#define spm_memset(s, c, n)                 memset(s, c, n)
+
+#define tfm_core_panic()                    abort()
+
+#endif /* __SIM_UTILITIES_H__ */
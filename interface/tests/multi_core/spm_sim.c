@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Simulated SPM behind TF-M RPC. It implements the SPM client API handlers
+ * and the service lookups which TF-M RPC calls, and a partition which
+ * provides the simulated services.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ffm/psa_api.h"
+#include "spm_ipc.h"
+#include "spm_sim.h"
+#include "tfm_multi_core.h"
+#include "tfm_psa_call_pack.h"
+#include "tfm_rpc.h"
+
+/* A psa_call() queued to the simulated partition */
+struct sim_call_t {
+    struct conn_handle_t conn;
+    const psa_invec      *in_vec;
+    size_t               in_len;
+    psa_outvec           *out_vec;
+    size_t               out_len;
+};
+
+/* The calls pending in the partition, served in order from head to tail */
+static struct sim_call_t pending_calls[SIM_MAX_PENDING_CALLS];
+static uint32_t pending_head, pending_tail;
+static pthread_mutex_t pending_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pending_cond = PTHREAD_COND_INITIALIZER;
+
+static volatile bool is_stopping;
+static pthread_t partition_thread;
+
+/* The non-secure client set by the transport for the request dispatched */
+static int32_t sim_ns_client_id;
+
+static const struct partition_load_info_t sim_partition_ldinf = {
+    .flags = PARTITION_PRI_NORMAL,
+};
+
+static struct partition_t sim_partition = {
+    .p_ldinf = &sim_partition_ldinf,
+};
+
+static const struct partition_load_info_t sim_high_partition_ldinf = {
+    .flags = PARTITION_PRI_HIGH,
+};
+
+static struct partition_t sim_high_partition = {
+    .p_ldinf = &sim_high_partition_ldinf,
+};
+
+static struct service_t sim_service = {
+    .partition = &sim_partition,
+};
+
+static struct service_t sim_high_service = {
+    .partition = &sim_high_partition,
+};
+
+struct service_t *tfm_spm_get_service_by_sid(uint32_t sid)
+{
+    switch (sid) {
+    case SIM_SERVICE_SID:
+        return &sim_service;
+    case SIM_HIGH_SERVICE_SID:
+        return &sim_high_service;
+    default:
+        return NULL;
+    }
+}
+
+struct service_t *tfm_spm_get_service_by_handle(psa_handle_t handle)
+{
+    switch (handle) {
+    case SIM_SERVICE_HANDLE:
+        return &sim_service;
+    case SIM_HIGH_SERVICE_HANDLE:
+        return &sim_high_service;
+    default:
+        return NULL;
+    }
+}
+
+void tfm_multi_core_set_ns_local_region(const void *p, size_t s)
+{
+    (void)p;
+    (void)s;
+}
+
+void tfm_multi_core_set_ns_client(int32_t client_id)
+{
+    sim_ns_client_id = client_id;
+}
+
+uint32_t tfm_spm_client_psa_framework_version(void)
+{
+    return PSA_FRAMEWORK_VERSION;
+}
+
+uint32_t tfm_spm_client_psa_version(uint32_t sid)
+{
+    return tfm_spm_get_service_by_sid(sid) ? SIM_SERVICE_VERSION :
+                                             PSA_VERSION_NONE;
+}
+
+/*
+ * The call is queued to the partition, as SPM queues the message to the
+ * service. The caller data of the transport is attached to the connection by
+ * TF-M RPC, and passed back to the transport when the partition replies.
+ */
+psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
+                                     uint32_t ctrl_param,
+                                     const psa_invec *inptr,
+                                     psa_outvec *outptr)
+{
+    struct sim_call_t *call;
+    size_t in_len = PARAM_UNPACK_IN_LEN(ctrl_param);
+    size_t out_len = PARAM_UNPACK_OUT_LEN(ctrl_param);
+
+    if (!tfm_spm_get_service_by_handle(handle) ||
+        (in_len > PSA_MAX_IOVEC) || (out_len > PSA_MAX_IOVEC - in_len)) {
+        return PSA_ERROR_PROGRAMMER_ERROR;
+    }
+
+    pthread_mutex_lock(&pending_lock);
+
+    if (pending_tail - pending_head >= SIM_MAX_PENDING_CALLS) {
+        SIM_FATAL("More than %d calls pending", SIM_MAX_PENDING_CALLS);
+    }
+
+    call = &pending_calls[pending_tail % SIM_MAX_PENDING_CALLS];
+    memset(call, 0, sizeof(*call));
+    call->conn.msg.type = PARAM_UNPACK_TYPE(ctrl_param);
+    call->conn.msg.handle = handle;
+    call->conn.msg.client_id = sim_ns_client_id;
+    call->in_vec = inptr;
+    call->in_len = in_len;
+    call->out_vec = outptr;
+    call->out_len = out_len;
+
+    tfm_rpc_set_caller_data(&call->conn, sim_ns_client_id);
+
+    pending_tail++;
+    pthread_cond_signal(&pending_cond);
+
+    pthread_mutex_unlock(&pending_lock);
+
+    return PSA_SUCCESS;
+}
+
+/*
+ * The simulated services copy the input vectors into the output vectors one
+ * after another and return the type plus the size of the input.
+ */
+static int32_t sim_service_call(const struct sim_call_t *call)
+{
+    size_t i, in_size = 0;
+    size_t copied, offset = 0, in_idx = 0;
+
+    for (i = 0; i < call->in_len; i++) {
+        in_size += call->in_vec[i].len;
+    }
+
+    for (i = 0; i < call->out_len; i++) {
+        copied = 0;
+        while ((copied < call->out_vec[i].len) && (in_idx < call->in_len)) {
+            size_t len = call->in_vec[in_idx].len - offset;
+
+            if (len > call->out_vec[i].len - copied) {
+                len = call->out_vec[i].len - copied;
+            }
+            memcpy((uint8_t *)call->out_vec[i].base + copied,
+                   (const uint8_t *)call->in_vec[in_idx].base + offset, len);
+            copied += len;
+            offset += len;
+            if (offset == call->in_vec[in_idx].len) {
+                in_idx++;
+                offset = 0;
+            }
+        }
+        call->out_vec[i].len = copied;
+    }
+
+    if (call->conn.msg.type == SIM_SERVICE_SLOW_TYPE) {
+        usleep(SIM_SERVICE_SLOW_MS * 1000);
+    }
+
+    return SIM_SERVICE_RESULT(call->conn.msg.type, in_size);
+}
+
+bool sim_spm_serve(void)
+{
+    struct sim_call_t *call;
+
+    pthread_mutex_lock(&pending_lock);
+    if (pending_head == pending_tail) {
+        pthread_mutex_unlock(&pending_lock);
+        return false;
+    }
+    call = &pending_calls[pending_head % SIM_MAX_PENDING_CALLS];
+    pthread_mutex_unlock(&pending_lock);
+
+    /* The entry is only released after the reply */
+    tfm_rpc_client_call_reply(&call->conn, sim_service_call(call));
+
+    pthread_mutex_lock(&pending_lock);
+    pending_head++;
+    pthread_mutex_unlock(&pending_lock);
+
+    return true;
+}
+
+static void *partition_runner(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        pthread_mutex_lock(&pending_lock);
+        while ((pending_head == pending_tail) && !is_stopping) {
+            pthread_cond_wait(&pending_cond, &pending_lock);
+        }
+        if (pending_head == pending_tail) {
+            pthread_mutex_unlock(&pending_lock);
+            break;
+        }
+        pthread_mutex_unlock(&pending_lock);
+
+        (void)sim_spm_serve();
+    }
+
+    return NULL;
+}
+
+int32_t sim_spm_start(void)
+{
+    is_stopping = false;
+
+    if (pthread_create(&partition_thread, NULL, partition_runner, NULL) != 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+void sim_spm_stop(void)
+{
+    pthread_mutex_lock(&pending_lock);
+    is_stopping = true;
+    pthread_cond_signal(&pending_cond);
+    pthread_mutex_unlock(&pending_lock);
+
+    pthread_join(partition_thread, NULL);
+}
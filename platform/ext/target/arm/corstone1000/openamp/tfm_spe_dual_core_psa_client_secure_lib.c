@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
@@ -17,6 +17,15 @@
 #include "utilities.h"
 #include "thread.h"
 
+/* The OpenAMP call types are delivered to TF-M RPC as they are */
+#if (OPENAMP_PSA_FRAMEWORK_VERSION != TFM_RPC_PSA_FRAMEWORK_VERSION) || \
+    (OPENAMP_PSA_VERSION != TFM_RPC_PSA_VERSION) || \
+    (OPENAMP_PSA_CONNECT != TFM_RPC_PSA_CONNECT) || \
+    (OPENAMP_PSA_CALL != TFM_RPC_PSA_CALL) || \
+    (OPENAMP_PSA_CLOSE != TFM_RPC_PSA_CLOSE)
+#error "OpenAMP PSA client call types mismatch TF-M RPC ones"
+#endif
+
 /**
  * In linux environment and for psa_call type client api,
  * the layout of the reply from tf-m to linux is as following.
@@ -101,6 +110,67 @@ static psa_invec * prepare_in_vecs(unordered_map_entry_t* s_map_entry)
     return input_buffer_in_vec;
 }
 
+#if TFM_MAP_INLINE_PAYLOAD_SIZE > 0
+/*
+ * Copy small input data into the map entry. The in_vec array in the openamp
+ * buffer is left untouched and the buffer need not be held until reply.
+ * Return NULL if the input data does not fit into the entry.
+ */
+static psa_invec * copy_in_vecs_inline(unordered_map_entry_t* s_map_entry)
+{
+    uint32_t in_len = s_map_entry->msg.params.psa_call_params.in_len;
+    const psa_invec *ns_in_vec;
+    const void *base;
+    size_t total_len = 0;
+
+    SPM_ASSERT(in_len <= PSA_MAX_IOVEC);
+
+    if (in_len == 0) {
+        return s_map_entry->inline_input.in_vec;
+    }
+
+    ns_in_vec = (const psa_invec*)tfm_to_openamp_translate_non_secure_to_secure_ptr(
+                                    (void*)s_map_entry->msg.params.psa_call_params.in_vec);
+    if (!ns_in_vec) {
+        return NULL;
+    }
+
+    /* Copy the in_vec array first, so that the lengths cannot change */
+    spm_memcpy(s_map_entry->inline_input.in_vec, ns_in_vec,
+               in_len * sizeof(psa_invec));
+
+    for (int i = 0; i < in_len; i++) {
+        if (s_map_entry->inline_input.in_vec[i].len >
+            TFM_MAP_INLINE_PAYLOAD_SIZE - total_len) {
+            return NULL;
+        }
+        total_len += s_map_entry->inline_input.in_vec[i].len;
+    }
+
+    total_len = 0;
+    for (int i = 0; i < in_len; i++) {
+        if (s_map_entry->inline_input.in_vec[i].len == 0) {
+            s_map_entry->inline_input.in_vec[i].base = NULL;
+            continue;
+        }
+
+        base = tfm_to_openamp_translate_non_secure_to_secure_ptr(
+                                    s_map_entry->inline_input.in_vec[i].base);
+        if (!base) {
+            return NULL;
+        }
+
+        spm_memcpy(&s_map_entry->inline_input.payload[total_len], base,
+                   s_map_entry->inline_input.in_vec[i].len);
+        s_map_entry->inline_input.in_vec[i].base =
+                                &s_map_entry->inline_input.payload[total_len];
+        total_len += s_map_entry->inline_input.in_vec[i].len;
+    }
+
+    return s_map_entry->inline_input.in_vec;
+}
+#endif /* TFM_MAP_INLINE_PAYLOAD_SIZE > 0 */
+
 static void * alloc_outout_buffer_in_shared_mem(size_t length,
         unordered_map_entry_t* s_map_entry)
 {
@@ -184,6 +254,14 @@ static psa_status_t prepare_params_for_psa_call(struct client_call_params_t *spm
         return ret;
     }
 
+#if TFM_MAP_INLINE_PAYLOAD_SIZE > 0
+    spm_params->in_vec = copy_in_vecs_inline(s_map_entry);
+    if (spm_params->in_vec) {
+        /* The openamp buffer is released once this callback returns */
+        return ret;
+    }
+#endif
+
     spm_params->in_vec = prepare_in_vecs(s_map_entry);
 
     /* hold the input shared memory */
@@ -249,52 +327,57 @@ int32_t register_msg_to_spe_and_verify(void **private, const void *data, size_t
 
 void deliver_msg_to_tfm_spe(void *private)
 {
-    struct client_call_params_t spm_params = {0};
+    struct tfm_rpc_req_t *req;
     psa_status_t psa_ret = PSA_ERROR_GENERIC_ERROR;
     unordered_map_entry_t* s_map_entry = (unordered_map_entry_t*)private;
 
+    /* A full request pool is dispatched before the message is submitted */
+    req = tfm_rpc_req_alloc();
+    if (!req) {
+        tfm_rpc_req_dispatch();
+        req = tfm_rpc_req_alloc();
+    }
+
     switch(s_map_entry->msg.call_type) {
-        case OPENAMP_PSA_FRAMEWORK_VERSION:
-            psa_ret = tfm_rpc_psa_framework_version();
-            send_service_reply_to_non_secure(psa_ret, s_map_entry);
-            break;
         case OPENAMP_PSA_VERSION:
-            spm_params.sid = s_map_entry->msg.params.psa_version_params.sid;
-            psa_ret = tfm_rpc_psa_version(&spm_params);
-            send_service_reply_to_non_secure(psa_ret, s_map_entry);
+            req->params.sid = s_map_entry->msg.params.psa_version_params.sid;
             break;
         case OPENAMP_PSA_CALL:
-            psa_ret = prepare_params_for_psa_call(&spm_params, s_map_entry);
+            psa_ret = prepare_params_for_psa_call(&req->params, s_map_entry);
             if (psa_ret != PSA_SUCCESS) {
                 send_service_reply_to_non_secure(psa_ret, s_map_entry);
-                break;
+                return;
             }
-            psa_ret = tfm_rpc_psa_call(&spm_params);
-            if (psa_ret != PSA_SUCCESS) {
-                send_service_reply_to_non_secure(psa_ret, s_map_entry);
-                break;
+#if TFM_MAP_INLINE_PAYLOAD_SIZE > 0
+            /*
+             * SPM checks the vectors against the non-secure caller. Only the
+             * copy of the input data of this message is accepted in addition.
+             */
+            if (!s_map_entry->is_input_buffer_hold) {
+                req->local_buf = &s_map_entry->inline_input;
+                req->local_size = sizeof(s_map_entry->inline_input);
             }
+#endif
             break;
-#if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
         case OPENAMP_PSA_CONNECT:
-            spm_params.sid = s_map_entry->msg.params.psa_connect_params.sid;
-            spm_params.version = s_map_entry->msg.params.psa_connect_params.version;
-            psa_ret = tfm_rpc_psa_connect(&spm_params);
-            if (psa_ret != PSA_SUCCESS) {
-                send_service_reply_to_non_secure(psa_ret, s_map_entry);
-            }
+            req->params.sid = s_map_entry->msg.params.psa_connect_params.sid;
+            req->params.version = s_map_entry->msg.params.psa_connect_params.version;
             break;
         case OPENAMP_PSA_CLOSE:
-            spm_params.handle = s_map_entry->msg.params.psa_close_params.handle;
-            tfm_rpc_psa_close(&spm_params);
+            req->params.handle = s_map_entry->msg.params.psa_close_params.handle;
             break;
-#endif /* CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1 */
         default:
             SPMLOG_ERRMSG("msg type did not recognized\r\n");
             send_error_to_non_secure(OPENAMP_INVAL_PARAMS, s_map_entry->msg.request_id);
             unordered_map_free(unordered_map_get_entry_handle(s_map_entry));
-            break;
+            return;
     }
+
+    req->call_type = s_map_entry->msg.call_type;
+    /* The map entry is passed back to service_reply() on completion */
+    req->caller_data = s_map_entry;
+
+    tfm_rpc_req_submit(req);
 }
 
 void init_dual_core_psa_client_secure_lib(void)
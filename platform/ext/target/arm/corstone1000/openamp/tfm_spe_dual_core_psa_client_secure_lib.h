@@ -16,8 +16,8 @@
 void init_dual_core_psa_client_secure_lib(void);
 
 /**
- * \brief Decodes the messages received from the NSPE before sending
- * to SPE.
+ * \brief Decodes the messages received from the NSPE and submits them to
+ * the TF-M RPC request pool. They are sent to SPE by tfm_rpc_req_dispatch().
  */
 void deliver_msg_to_tfm_spe(void *private);
 
@@ -1,11 +1,12 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
 #include "tfm_spe_psa_client_lib_unordered_map.h"
+#include "cmsis_compiler.h"
 #include "utilities.h"
 #include "tfm_spe_openamp_interface.h"
 #include "tfm_spe_shm_openamp.h"
@@ -13,17 +14,35 @@
 #include <stddef.h>
 #include <string.h>
 
+/*
+ * The handle is made of the slot index in the low bits and the generation of
+ * the slot in the upper bits. The generation is bumped when the slot is freed,
+ * so a handle is only valid while its entry is in use. The top bit is never set
+ * to keep the handle positive.
+ */
+#define MAP_INDEX_BITS          (8)
+#define MAP_INDEX_MASK          ((1 << MAP_INDEX_BITS) - 1)
+#define MAP_GEN_MASK            (0x7F)
+
+#define MAP_BITMAP_WORDS        ((TFM_MAX_MESSAGES + 31) / 32)
+
+#if TFM_MAX_MESSAGES > (1 << MAP_INDEX_BITS)
+#error "TFM_MAX_MESSAGES exceeds the maximum size of the map"
+#endif
+
 /*
  * SPE map where tf-m copies the psa_client parameters
  * from non-secure memory to its local secure memory.
  */
 typedef struct unordered_map {
     /*
-     * Aligned with TFM_MAX_MESSAGES. A more sophisticated approach is
-     * required if the intent is to increase TFM_MAX_MESSAGES beyond
-     * 32 bits.
+     * One bit per slot. The bits beyond TFM_MAX_MESSAGES in the last word are
+     * always set, so that they are never allocated.
      */
-    uint32_t                    busy_slots; /* protected by a spinlock */
+    uint32_t                    busy_slots[MAP_BITMAP_WORDS]; /* protected by a
+                                                               * spinlock
+                                                               */
+    uint8_t                     generation[TFM_MAX_MESSAGES];
     unordered_map_entry_t       map[TFM_MAX_MESSAGES];
 } unordered_map_t;
 
@@ -34,59 +53,85 @@ typedef struct unordered_map {
  */
 static unordered_map_t psa_client_lib_map_;
 
+/* Index of the lowest unset bit. The word must not be all ones. */
 static inline int find_first_unset_bit(uint32_t n)
 {
-    int index = -1;
-    n = ~n & (n+1);
-    while(n>0) {
-        n >>= 1;
-        index++;
-    }
-    return index;
+    uint32_t lowest = ~n & (n + 1);
+
+    return 31 - __CLZ(lowest);
+}
+
+static inline void set_bit(uint32_t *bitmap, int index)
+{
+    bitmap[index / 32] |= (1UL << (index % 32));
 }
 
-static inline bool is_map_full(unordered_map_t *m)
+static inline bool is_bit_set(const uint32_t *bitmap, int index)
 {
-    return (~(m->busy_slots) == 0);
+    return ((bitmap[index / 32] & (1UL << (index % 32))) != 0);
 }
 
-static inline void set_bit(uint32_t *n, int index)
+static inline void unset_bit(uint32_t *bitmap, int index)
 {
-    *n = (*n | (1 << index));
+    bitmap[index / 32] &= ~(1UL << (index % 32));
 }
 
-static inline bool is_bit_set(uint32_t n, int index)
+static inline unordered_map_handle_t make_handle(int index)
 {
-    return ((n & (1 << index)) != 0);
+    return (unordered_map_handle_t)
+            ((psa_client_lib_map_.generation[index] << MAP_INDEX_BITS) | index);
 }
 
-static inline void unset_bit(uint32_t *n, int index)
+/* Return the slot index of a handle in use, or -1 */
+static int handle_to_index(unordered_map_handle_t handle)
 {
-    uint32_t mask = 0;
-    mask |= (1 << index);
-    *n = (*n & ~mask);
+    int index;
+
+    if (handle < 0) {
+        return -1;
+    }
+
+    index = handle & MAP_INDEX_MASK;
+    if (index >= TFM_MAX_MESSAGES) {
+        return -1;
+    }
+
+    if (!is_bit_set(psa_client_lib_map_.busy_slots, index) ||
+        (psa_client_lib_map_.generation[index] !=
+                                            (handle >> MAP_INDEX_BITS))) {
+        return -1;
+    }
+
+    return index;
 }
 
 void unordered_map_init(void)
 {
     tfm_to_openamp_spe_map_spinlock_acquire();
-    psa_client_lib_map_.busy_slots = 0;
+    spm_memset(psa_client_lib_map_.busy_slots, 0,
+               sizeof(psa_client_lib_map_.busy_slots));
+    for (int i = TFM_MAX_MESSAGES; i < MAP_BITMAP_WORDS * 32; i++) {
+        set_bit(psa_client_lib_map_.busy_slots, i);
+    }
     tfm_to_openamp_spe_map_spinlock_release();
 }
 
-static int32_t alloc_map_entry(unordered_map_handle_t *handle)
+static int32_t alloc_map_entry(int *index)
 {
-    int32_t ret;
+    int32_t ret = OPENAMP_MAP_FULL;
+    uint32_t word;
+
     tfm_to_openamp_spe_map_spinlock_acquire();
-    do {
-        if (is_map_full(&psa_client_lib_map_)) {
-            ret = OPENAMP_MAP_FULL;
-            break;
+    for (int i = 0; i < MAP_BITMAP_WORDS; i++) {
+        word = psa_client_lib_map_.busy_slots[i];
+        if (word == UINT32_MAX) {
+            continue;
         }
-        *handle = find_first_unset_bit(psa_client_lib_map_.busy_slots);
-        set_bit(&psa_client_lib_map_.busy_slots, *handle);
+        *index = i * 32 + find_first_unset_bit(word);
+        set_bit(psa_client_lib_map_.busy_slots, *index);
         ret = OPENAMP_SUCCESS;
-    } while (0);
+        break;
+    }
     tfm_to_openamp_spe_map_spinlock_release();
     return ret;
 }
@@ -94,49 +139,56 @@ static int32_t alloc_map_entry(unordered_map_handle_t *handle)
 int32_t unordered_map_insert(const ns_openamp_msg_t *ns_msg, const void *in,
                                  unordered_map_handle_t *handle)
 {
+    unordered_map_entry_t *entry;
     int32_t ret;
+    int index;
 
-    ret = alloc_map_entry(handle);
+    ret = alloc_map_entry(&index);
     if (ret) {
         return ret;
     }
 
-    memcpy(&psa_client_lib_map_.map[*handle].msg, ns_msg,
-                                sizeof(ns_openamp_msg_t));
+    entry = &psa_client_lib_map_.map[index];
+    *handle = make_handle(index);
 
-    psa_client_lib_map_.map[*handle].input_buffer = in;
-    psa_client_lib_map_.map[*handle].output_buffer = NULL;
-    psa_client_lib_map_.map[*handle].output_buffer_len = 0;
-    psa_client_lib_map_.map[*handle].is_input_buffer_hold = false;
-    psa_client_lib_map_.map[*handle].is_output_buffer = false;
+    memcpy(&entry->msg, ns_msg, sizeof(ns_openamp_msg_t));
 
-    psa_client_lib_map_.map[*handle].handle = *handle;
+    entry->input_buffer = in;
+    entry->output_buffer = NULL;
+    entry->output_buffer_len = 0;
+    entry->is_input_buffer_hold = false;
+    entry->is_output_buffer = false;
+
+    entry->handle = *handle;
 
     return OPENAMP_SUCCESS;
 }
 
 void unordered_map_free(unordered_map_handle_t handle)
 {
-    if (handle >= TFM_MAX_MESSAGES || handle < 0) {
+    int index = handle_to_index(handle);
+
+    if (index < 0) {
         return;
     }
-    spm_memset(&psa_client_lib_map_.map[handle], 0,
+    spm_memset(&psa_client_lib_map_.map[index], 0,
                                sizeof(unordered_map_entry_t));
+    psa_client_lib_map_.generation[index] =
+                (psa_client_lib_map_.generation[index] + 1) & MAP_GEN_MASK;
 
     tfm_to_openamp_spe_map_spinlock_acquire();
-    unset_bit(&psa_client_lib_map_.busy_slots, handle);
+    unset_bit(psa_client_lib_map_.busy_slots, index);
     tfm_to_openamp_spe_map_spinlock_release();
 }
 
 unordered_map_entry_t* unordered_map_get_entry_ptr(unordered_map_handle_t handle)
 {
-    if (handle >= TFM_MAX_MESSAGES || handle < 0) {
-        return NULL;
-    }
-    if (!is_bit_set(psa_client_lib_map_.busy_slots, handle)) {
+    int index = handle_to_index(handle);
+
+    if (index < 0) {
         return NULL;
     }
-    return &psa_client_lib_map_.map[handle];
+    return &psa_client_lib_map_.map[index];
 }
 
 unordered_map_handle_t unordered_map_get_entry_handle(
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -14,10 +14,22 @@
 /* 16 bits are sufficient to store the handle. Also
  * choosing 16bits allow for better packing inside
  * the struct unordered_map_entry_t.
+ * The handle holds the slot index and the generation of the slot, so that
+ * a stale handle of a freed entry is not accepted.
  */
 typedef int16_t unordered_map_handle_t;
 #define INVALID_MAP_HANDLE -1
 
+/*
+ * The input data of psa_call() up to this size is copied into the map entry,
+ * so that the openamp buffer is released before the call completes. Larger
+ * input data is referenced in the openamp buffer, which is held until reply.
+ * Set to 0 to always reference the input data in the openamp buffer.
+ */
+#ifndef TFM_MAP_INLINE_PAYLOAD_SIZE
+#define TFM_MAP_INLINE_PAYLOAD_SIZE (64)
+#endif
+
 /* An entry structure of map data structure */
 typedef struct unordered_map_entry {
     ns_openamp_msg_t msg;
@@ -27,6 +39,12 @@ typedef struct unordered_map_entry {
     unordered_map_handle_t handle; /* entry handle */
     bool is_input_buffer_hold; /* true when input buffer is held */
     bool is_output_buffer; /* true when output buffer is preallocated */
+#if TFM_MAP_INLINE_PAYLOAD_SIZE > 0
+    struct {
+        psa_invec in_vec[PSA_MAX_IOVEC];
+        uint8_t payload[TFM_MAP_INLINE_PAYLOAD_SIZE];
+    } inline_input; /* copy of small input data */
+#endif
 } unordered_map_entry_t;
 
 /* Initialize the map data structure */
@@ -31,9 +31,10 @@
  * The Host should set RPMSG_BUFFER_SIZE accrodingly
  * such that tf-m does not recieve more than
  * TFM_MAX_MESSAGES messages.
- * Changing this macro DOES NOT increase TF-M capabilities
- * to handle more messages.
+ * The map of in-flight messages supports up to 256 messages.
  */
+#ifndef TFM_MAX_MESSAGES
 #define TFM_MAX_MESSAGES            (32)
+#endif
 
 #endif /* TFM_SPE_SHM_OPEN_AMP_H_ */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -10,6 +10,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "rss_comms_atu.h"
 #include "rss_comms_hal.h"
 #include "rss_comms_queue.h"
 #include "tfm_rpc.h"
@@ -18,13 +19,10 @@
 #include "tfm_spm_log.h"
 #include "rss_comms_permissions_hal.h"
 
-static struct client_request_t *req_to_process;
-
-static psa_status_t message_dispatch(struct client_request_t *req)
+static psa_status_t message_submit(struct client_request_t *req,
+                                   struct tfm_rpc_req_t *rpc_req)
 {
     enum tfm_plat_err_t plat_err;
-
-    /* Create the call parameters */
     struct client_call_params_t spm_params = {
         .handle = req->handle,
         .type = req->type,
@@ -34,7 +32,7 @@ static psa_status_t message_dispatch(struct client_request_t *req)
         .out_len = req->out_len,
     };
 
-    SPMLOG_DBGMSG("[RSS-COMMS] Dispatching message\r\n");
+    SPMLOG_DBGMSG("[RSS-COMMS] Submitting message\r\n");
     SPMLOG_DBGMSGVAL("handle=", spm_params.handle);
     SPMLOG_DBGMSGVAL("type=", spm_params.type);
     SPMLOG_DBGMSGVAL("in_len=", spm_params.in_len);
@@ -73,12 +71,22 @@ static psa_status_t message_dispatch(struct client_request_t *req)
         return PSA_ERROR_NOT_PERMITTED;
     }
 
-    return tfm_rpc_psa_call(&spm_params);
+    rpc_req->call_type = TFM_RPC_PSA_CALL;
+    rpc_req->params = spm_params;
+    /* The request is passed back to rss_comms_reply() on completion */
+    rpc_req->caller_data = req;
+
+    tfm_rpc_req_submit(rpc_req);
+
+    return PSA_SUCCESS;
 }
 
 static void rss_comms_reply(const void *owner, int32_t ret)
 {
     struct client_request_t *req = (struct client_request_t *)owner;
+#if TFM_SPM_LOG_LEVEL == TFM_SPM_LOG_LEVEL_DEBUG
+    struct comms_atu_stats_t atu_stats;
+#endif
 
     req->return_val = ret;
 
@@ -92,41 +100,60 @@ static void rss_comms_reply(const void *owner, int32_t ret)
     SPMLOG_DBGMSGVAL("out_vec[2].len=", req->out_vec[2].len);
     SPMLOG_DBGMSGVAL("out_vec[3].len=", req->out_vec[3].len);
 
+#if TFM_SPM_LOG_LEVEL == TFM_SPM_LOG_LEVEL_DEBUG
+    comms_atu_get_stats(&atu_stats);
+    SPMLOG_DBGMSGVAL("atu_hits=", atu_stats.hits);
+    SPMLOG_DBGMSGVAL("atu_misses=", atu_stats.misses);
+    SPMLOG_DBGMSGVAL("atu_evictions=", atu_stats.evictions);
+#endif
+
+    /* The reply is sent by rss_comms_notify() */
     if (tfm_multi_core_hal_reply(req) != TFM_PLAT_ERR_SUCCESS) {
-        SPMLOG_DBGMSG("[RSS-COMMS] Sending reply failed!\r\n");
+        SPMLOG_DBGMSG("[RSS-COMMS] Queueing reply failed!\r\n");
     }
 }
 
+static void rss_comms_notify(void)
+{
+    tfm_multi_core_hal_send_replies();
+}
+
 static void rss_comms_handle_req(void)
 {
     psa_status_t status;
+    struct tfm_rpc_req_t *rpc_req;
     void *queue_entry;
 
-    /* FIXME: consider memory limitations that may prevent dispatching all
-     * messages in one go.
+    /* Send the error replies queued by the receive interrupt handler */
+    tfm_multi_core_hal_send_replies();
+
+    /* The requests are dispatched by the priority of the requested service.
+     * A full request pool is dispatched before the next requests are taken.
      */
     while (queue_dequeue(&queue_entry) == 0) {
-        /* Deliver PSA Client call request to handler in SPM. */
-        req_to_process = queue_entry;
-        status = message_dispatch(req_to_process);
+        rpc_req = tfm_rpc_req_alloc();
+        if (!rpc_req) {
+            tfm_rpc_req_dispatch();
+            rpc_req = tfm_rpc_req_alloc();
+        }
+
+        status = message_submit(queue_entry, rpc_req);
         if (status != PSA_SUCCESS) {
-            SPMLOG_DBGMSGVAL("[RSS-COMMS] Message dispatch failed: ", status);
-            rss_comms_reply(req_to_process, status);
+            SPMLOG_DBGMSGVAL("[RSS-COMMS] Message submit failed: ", status);
+            rss_comms_reply(queue_entry, status);
         }
     }
-}
 
-static const void *rss_comms_get_caller_data(int32_t client_id)
-{
-    (void)client_id;
+    tfm_rpc_req_dispatch();
 
-    return req_to_process;
+    /* Send the error replies of the requests not submitted */
+    tfm_multi_core_hal_send_replies();
 }
 
 static struct tfm_rpc_ops_t rpc_ops = {
     .handle_req = rss_comms_handle_req,
     .reply = rss_comms_reply,
-    .get_caller_data = rss_comms_get_caller_data,
+    .notify = rss_comms_notify,
 };
 
 int32_t tfm_inter_core_comm_init(void)
@@ -1,10 +1,12 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
+#include <stdbool.h>
+
 #include "rss_comms_atu.h"
 #include "atu_rss_drv.h"
 #include "tfm_spm_log.h"
@@ -17,11 +19,24 @@ struct comms_atu_region_params_t {
     uint32_t size;
     uint8_t region;
     uint32_t ref_count;
+    bool is_mapped;             /* The ATU region is programmed. It is kept
+                                 * after the last reference is freed, until
+                                 * it is evicted or too old.
+                                 */
+    uint32_t last_used;         /* Value of atu_use_count when last freed */
 };
 
 /* ATU config */
 static struct comms_atu_region_params_t atu_regions[RSS_COMMS_ATU_REGION_AM] = {0};
 
+/* Incremented on each allocation to age the idle regions */
+static uint32_t atu_use_count;
+
+/* The regions mapped without references */
+static uint32_t nr_idle_regions;
+
+static struct comms_atu_stats_t atu_stats;
+
 static inline uint64_t round_down(uint64_t num, uint64_t boundary)
 {
     return num - (num % boundary);
@@ -49,7 +64,8 @@ static enum tfm_plat_err_t get_region_idx_from_host_buf(uint64_t host_addr,
     for (idx = 0; idx < RSS_COMMS_ATU_REGION_AM; idx++) {
         region = &atu_regions[idx];
 
-        if (atu_regions[idx].ref_count > 0 &&
+        /* Idle regions are still mapped and can be reused as they are */
+        if (region->is_mapped &&
             host_addr >= region->phys_addr &&
             host_addr + size <= region->phys_addr + region->size) {
             *region_idx = idx;
@@ -72,23 +88,112 @@ enum tfm_plat_err_t comms_atu_get_rss_ptr_from_host_addr(uint8_t region,
 
 
     region_params = &atu_regions[region];
-    *rss_ptr = (uint8_t *)((uint32_t)(host_addr - region_params->phys_addr)
-                           + region_params->log_addr);
+    *rss_ptr = (uint8_t *)(uintptr_t)((uint32_t)(host_addr -
+                                                 region_params->phys_addr)
+                                      + region_params->log_addr);
+
+    return TFM_PLAT_ERR_SUCCESS;
+}
+
+static enum tfm_plat_err_t unmap_idle_region(uint32_t region_idx)
+{
+    int32_t atu_err;
+
+    atu_err = atu_uninitialize_region(&ATU_DEV_S,
+                                      atu_regions[region_idx].region);
+    if (atu_err) {
+        return TFM_PLAT_ERR_SYSTEM_ERR;
+    }
+
+    atu_regions[region_idx].is_mapped = false;
+    nr_idle_regions--;
+
+    SPMLOG_DBGMSGVAL("[COMMS ATU] Deallocating region: ", region_idx);
 
     return TFM_PLAT_ERR_SUCCESS;
 }
 
-static int get_free_region_idx(uint32_t *region_idx) {
+/* Find the idle region unused for the most allocations */
+static enum tfm_plat_err_t get_lru_idle_region_idx(uint32_t *region_idx)
+{
     uint32_t idx;
+    uint32_t victim = RSS_COMMS_ATU_REGION_AM;
+
+    for (idx = 0; idx < RSS_COMMS_ATU_REGION_AM; idx++) {
+        if (!atu_regions[idx].is_mapped || atu_regions[idx].ref_count > 0) {
+            continue;
+        }
+
+        /* Compare the ages so that the wrap of atu_use_count is harmless */
+        if ((victim == RSS_COMMS_ATU_REGION_AM) ||
+            ((atu_use_count - atu_regions[idx].last_used) >
+             (atu_use_count - atu_regions[victim].last_used))) {
+            victim = idx;
+        }
+    }
+
+    if (victim == RSS_COMMS_ATU_REGION_AM) {
+        return TFM_PLAT_ERR_MAX_VALUE;
+    }
+
+    *region_idx = victim;
 
-    for (idx = 0; idx <= RSS_COMMS_ATU_REGION_AM; idx++) {
-        if (atu_regions[idx].ref_count == 0) {
+    return TFM_PLAT_ERR_SUCCESS;
+}
+
+/* Unmap the idle regions not reused for RSS_COMMS_ATU_IDLE_REGION_AGE
+ * allocations
+ */
+static enum tfm_plat_err_t unmap_old_idle_regions(void)
+{
+    uint32_t idx;
+    enum tfm_plat_err_t err;
+
+    for (idx = 0; idx < RSS_COMMS_ATU_REGION_AM; idx++) {
+        if (atu_regions[idx].is_mapped && atu_regions[idx].ref_count == 0 &&
+            (atu_use_count - atu_regions[idx].last_used) >
+                                            RSS_COMMS_ATU_IDLE_REGION_AGE) {
+            err = unmap_idle_region(idx);
+            if (err != TFM_PLAT_ERR_SUCCESS) {
+                return err;
+            }
+            atu_stats.evictions++;
+        }
+    }
+
+    return TFM_PLAT_ERR_SUCCESS;
+}
+
+/*
+ * Pick a region for a new mapping. An unmapped region is taken first. Otherwise
+ * the least recently used idle region is unmapped.
+ */
+static enum tfm_plat_err_t get_free_region_idx(uint32_t *region_idx)
+{
+    uint32_t idx;
+    enum tfm_plat_err_t err;
+
+    for (idx = 0; idx < RSS_COMMS_ATU_REGION_AM; idx++) {
+        if (!atu_regions[idx].is_mapped) {
             *region_idx = idx;
             return TFM_PLAT_ERR_SUCCESS;
         }
     }
 
-    return TFM_PLAT_ERR_MAX_VALUE;
+    err = get_lru_idle_region_idx(&idx);
+    if (err != TFM_PLAT_ERR_SUCCESS) {
+        return err;
+    }
+
+    err = unmap_idle_region(idx);
+    if (err != TFM_PLAT_ERR_SUCCESS) {
+        return err;
+    }
+    atu_stats.evictions++;
+
+    *region_idx = idx;
+
+    return TFM_PLAT_ERR_SUCCESS;
 }
 
 static enum tfm_plat_err_t setup_region_for_host_buf(uint64_t host_addr,
@@ -123,6 +228,7 @@ static enum tfm_plat_err_t setup_region_for_host_buf(uint64_t host_addr,
     if (atu_err) {
         return TFM_PLAT_ERR_SYSTEM_ERR;
     }
+    region_params->is_mapped = true;
 
     SPMLOG_DBGMSGVAL("[COMMS ATU] Mapping new region: ", region_idx);
     SPMLOG_DBGMSGVAL("[COMMS ATU] Region start: ", region_params->phys_addr);
@@ -137,8 +243,17 @@ enum tfm_plat_err_t comms_atu_alloc_region(uint64_t host_addr, uint32_t size,
     uint32_t region_idx;
     enum tfm_plat_err_t err;
 
+    atu_use_count++;
+
+    err = unmap_old_idle_regions();
+    if (err != TFM_PLAT_ERR_SUCCESS) {
+        return err;
+    }
+
     err = get_region_idx_from_host_buf(host_addr, size, &region_idx);
     if (err != TFM_PLAT_ERR_SUCCESS) {
+        atu_stats.misses++;
+
         err = get_free_region_idx(&region_idx);
         if (err) {
             return err;
@@ -148,6 +263,12 @@ enum tfm_plat_err_t comms_atu_alloc_region(uint64_t host_addr, uint32_t size,
         if (err) {
             return err;
         }
+    } else {
+        atu_stats.hits++;
+
+        if (atu_regions[region_idx].ref_count == 0) {
+            nr_idle_regions--;
+        }
     }
 
     atu_regions[region_idx].ref_count++;
@@ -157,50 +278,90 @@ enum tfm_plat_err_t comms_atu_alloc_region(uint64_t host_addr, uint32_t size,
     return TFM_PLAT_ERR_SUCCESS;
 }
 
-enum tfm_plat_err_t comms_atu_free_region(uint8_t region)
+/*
+ * Drop references to a region. A region left without references stays mapped
+ * for the later host buffers in it. At most RSS_COMMS_ATU_IDLE_REGION_NUM idle
+ * regions are kept, the least recently used one is unmapped first.
+ */
+static enum tfm_plat_err_t put_region(uint32_t region_idx, uint32_t count)
 {
-    int32_t atu_err;
     struct comms_atu_region_params_t *region_params;
+    enum tfm_plat_err_t err;
 
-    if (region >= RSS_COMMS_ATU_REGION_AM) {
+    region_params = &atu_regions[region_idx];
+    if (region_params->ref_count < count) {
         return TFM_PLAT_ERR_INVALID_INPUT;
     }
 
-    atu_regions[region].ref_count--;
-    region_params = &atu_regions[region];
+    region_params->ref_count -= count;
+
+    if (region_params->ref_count == 0) {
+        region_params->last_used = atu_use_count;
+        nr_idle_regions++;
 
-    if (atu_regions[region].ref_count == 0) {
-        atu_err = atu_uninitialize_region(&ATU_DEV_S, region_params->region);
-        if (atu_err) {
-            return TFM_PLAT_ERR_SYSTEM_ERR;
+        if (nr_idle_regions > RSS_COMMS_ATU_IDLE_REGION_NUM) {
+            err = get_lru_idle_region_idx(&region_idx);
+            if (err != TFM_PLAT_ERR_SUCCESS) {
+                return err;
+            }
+
+            err = unmap_idle_region(region_idx);
+            if (err != TFM_PLAT_ERR_SUCCESS) {
+                return err;
+            }
+            atu_stats.evictions++;
         }
-        SPMLOG_DBGMSGVAL("[COMMS ATU] Deallocating region: ", region);
     }
 
     return TFM_PLAT_ERR_SUCCESS;
 }
 
+enum tfm_plat_err_t comms_atu_free_region(uint8_t region)
+{
+    if (region >= RSS_COMMS_ATU_REGION_AM ||
+        atu_regions[region].ref_count == 0) {
+        return TFM_PLAT_ERR_INVALID_INPUT;
+    }
+
+    return put_region(region, 1);
+}
+
 enum tfm_plat_err_t comms_atu_free_regions(comms_atu_region_set_t regions)
 {
     uint32_t region_idx;
-    int32_t atu_err;
-    struct comms_atu_region_params_t *region_params;
+    enum tfm_plat_err_t err;
 
     for (region_idx = 0; region_idx < RSS_COMMS_ATU_REGION_AM; region_idx++) {
         if ((regions.ref_counts[region_idx]) > 0) {
-            atu_regions[region_idx].ref_count -= regions.ref_counts[region_idx];
-            region_params = &atu_regions[region_idx];
-
-            if (atu_regions[region_idx].ref_count == 0) {
-                atu_err = atu_uninitialize_region(&ATU_DEV_S,
-                                                  region_params->region);
-                if (atu_err) {
-                    return TFM_PLAT_ERR_SYSTEM_ERR;
-                }
-                SPMLOG_DBGMSGVAL("[COMMS ATU] Deallocating region: ", region_idx);
+            err = put_region(region_idx, regions.ref_counts[region_idx]);
+            if (err != TFM_PLAT_ERR_SUCCESS) {
+                return err;
             }
         }
     }
 
     return TFM_PLAT_ERR_SUCCESS;
 }
+
+enum tfm_plat_err_t comms_atu_unmap_idle_regions(void)
+{
+    uint32_t region_idx;
+    enum tfm_plat_err_t err;
+
+    for (region_idx = 0; region_idx < RSS_COMMS_ATU_REGION_AM; region_idx++) {
+        if (atu_regions[region_idx].is_mapped &&
+            atu_regions[region_idx].ref_count == 0) {
+            err = unmap_idle_region(region_idx);
+            if (err != TFM_PLAT_ERR_SUCCESS) {
+                return err;
+            }
+        }
+    }
+
+    return TFM_PLAT_ERR_SUCCESS;
+}
+
+void comms_atu_get_stats(struct comms_atu_stats_t *stats)
+{
+    *stats = atu_stats;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -19,6 +19,15 @@ typedef struct {
     uint32_t ref_counts[RSS_COMMS_ATU_REGION_AM];
 } comms_atu_region_set_t;
 
+/* Statistics of the ATU region allocations */
+struct comms_atu_stats_t {
+    uint32_t hits;              /* Host buffers found in a mapped region */
+    uint32_t misses;            /* Host buffers which needed a new mapping */
+    uint32_t evictions;         /* Idle regions unmapped for another buffer,
+                                 * over the idle region bound or for age
+                                 */
+};
+
 /* Add an ATU region to a set of ATU regions */
 enum tfm_plat_err_t comms_atu_add_region_to_set(comms_atu_region_set_t *set,
                                                 uint8_t region);
@@ -38,18 +47,29 @@ enum tfm_plat_err_t comms_atu_get_rss_ptr_from_host_addr(uint8_t region,
 enum tfm_plat_err_t comms_atu_alloc_region(uint64_t host_addr, uint32_t size,
                                            uint8_t *region);
 
-/* Decrease the regerence count to the particular region. If this is the last
- * reference to that region, uninitialise it and return it to the pool that can
- * be allocated.
+/* Decrease the reference count to the particular region. If this is the last
+ * reference to that region, keep it mapped as an idle region for later host
+ * buffers in it. The idle regions are unmapped when they are more than
+ * RSS_COMMS_ATU_IDLE_REGION_NUM, when they are not reused for
+ * RSS_COMMS_ATU_IDLE_REGION_AGE allocations, or when a region is needed for
+ * another host buffer.
  */
 enum tfm_plat_err_t comms_atu_free_region(uint8_t region);
 
 /* For each region in the set, decrease the reference count to the region by the
- * reference count in the set. If this causes any regions to have no references,
- * uninitialise the regions and return them to the pool that can be allocated.
+ * reference count in the set. The regions left without references are kept as
+ * idle regions, as by comms_atu_free_region().
  */
 enum tfm_plat_err_t comms_atu_free_regions(comms_atu_region_set_t regions);
 
+/* Unmap all the idle regions, so that no host memory is reachable outside the
+ * requests in flight.
+ */
+enum tfm_plat_err_t comms_atu_unmap_idle_regions(void);
+
+/* Get the hit and miss counts of the region allocations */
+void comms_atu_get_stats(struct comms_atu_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -16,4 +16,19 @@
 #define RSS_COMMS_ATU_PAGE_SIZE         0x2000
 #define RSS_COMMS_ATU_REGION_SIZE       (RSS_COMMS_ATU_PAGE_SIZE * 8)
 
+/* The number of regions kept mapped after their last free, for reuse by later
+ * host buffers in them. 0 unmaps a region on its last free.
+ */
+#ifndef RSS_COMMS_ATU_IDLE_REGION_NUM
+#define RSS_COMMS_ATU_IDLE_REGION_NUM   4
+#endif
+
+/* The number of later region allocations an idle region stays mapped for
+ * without being reused, so that the host memory it covers is not left
+ * reachable.
+ */
+#ifndef RSS_COMMS_ATU_IDLE_REGION_AGE
+#define RSS_COMMS_ATU_IDLE_REGION_AGE   16
+#endif
+
 #endif /* __RSS_COMMS_HAL_H__ */
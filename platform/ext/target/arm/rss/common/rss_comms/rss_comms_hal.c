@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -9,15 +9,32 @@
 
 #include "rss_comms.h"
 #include "rss_comms_queue.h"
+#include "critical_section.h"
 #include "mhu.h"
 #include "device_definition.h"
 #include "tfm_spm_log.h"
 #include "tfm_pools.h"
 #include "rss_comms_protocol.h"
+#include <stdbool.h>
 #include <string.h>
 
-/* Declared statically to avoid using huge amounts of stack space. Maybe revisit
- * if functions not being reentrant becomes a problem.
+/* Each request can have a reply queued. Error replies for the messages which
+ * could not get a request use the slots beyond that.
+ */
+#define REPLY_QUEUE_SIZE (RSS_COMMS_MAX_CONCURRENT_REQ * 2)
+
+/* A reply waiting to be sent to the AP */
+struct comms_reply_t {
+    struct client_request_t *req;   /* NULL if no request was allocated */
+    struct serialized_rss_comms_header_t header; /* Header of the message, for
+                                                  * error replies
+                                                  */
+    psa_status_t error;             /* PSA_SUCCESS for the result of a call */
+};
+
+/* Declared statically to avoid using huge amounts of stack space. The message
+ * buffer is only used by the receive interrupt handler. The reply buffer is
+ * only used by the reply sender, of which there is only one at a time.
  */
 static __ALIGNED(4) struct serialized_psa_msg_t msg;
 static __ALIGNED(4) struct serialized_psa_reply_t reply;
@@ -25,6 +42,22 @@ static __ALIGNED(4) struct serialized_psa_reply_t reply;
 TFM_POOL_DECLARE(req_pool, sizeof(struct client_request_t),
                  RSS_COMMS_MAX_CONCURRENT_REQ);
 
+/* Replies are queued by the receive interrupt handler and by the partitions
+ * replying to requests. The queue is protected by critical sections. Replies
+ * are sent by one sender at a time, never by the receive interrupt handler.
+ *
+ * All the replies go over the same MHU device, whose driver transfers each
+ * message over all of its channels, so there are no per-channel buffers. The
+ * replies may complete out of order and carry the sequence number of their
+ * request. The AP matches them by sequence number.
+ */
+static struct comms_reply_t reply_queue[REPLY_QUEUE_SIZE];
+static size_t reply_queue_head;
+static size_t reply_queue_tail;
+static size_t reply_queue_count;
+/* Set while a context is sending the queued replies */
+static bool is_sending_reply;
+
 static enum tfm_plat_err_t initialize_mhu(void)
 {
     enum mhu_error_t err;
@@ -45,15 +78,117 @@ static enum tfm_plat_err_t initialize_mhu(void)
     return TFM_PLAT_ERR_SUCCESS;
 }
 
+static void free_req(struct client_request_t *req)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+
+    /* The pool is also allocated from by the receive interrupt handler */
+    CRITICAL_SECTION_ENTER(cs_assert);
+    tfm_pool_free(req_pool, req);
+    CRITICAL_SECTION_LEAVE(cs_assert);
+}
+
+static void send_reply(struct comms_reply_t *entry)
+{
+    enum tfm_plat_err_t err;
+    enum mhu_error_t mhu_err;
+    size_t reply_size;
+
+    if (entry->error != PSA_SUCCESS) {
+        err = rss_protocol_serialize_error(entry->req, &entry->header,
+                                           entry->error, &reply, &reply_size);
+    } else {
+        err = rss_protocol_serialize_reply(entry->req, &reply, &reply_size);
+    }
+
+    if (err != TFM_PLAT_ERR_SUCCESS) {
+        SPMLOG_DBGMSGVAL("[COMMS] Serialize reply failed: ", err);
+        goto out;
+    }
+
+    mhu_err = mhu_send_data(&MHU_RSS_TO_AP_DEV, (uint8_t *)&reply, reply_size);
+    if (mhu_err != MHU_ERR_NONE) {
+        SPMLOG_DBGMSGVAL("[COMMS] MHU send failed: ", mhu_err);
+        goto out;
+    }
+
+    SPMLOG_DBGMSG("[COMMS] Sent reply\r\n");
+
+out:
+    if (entry->req != NULL) {
+        free_req(entry->req);
+    }
+}
+
+/* Queue a reply. It is sent by tfm_multi_core_hal_send_replies(). */
+static enum tfm_plat_err_t queue_reply(const struct comms_reply_t *entry)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    size_t limit;
+
+    /* Keep a slot for the reply of each request */
+    limit = entry->req != NULL ? REPLY_QUEUE_SIZE
+                               : REPLY_QUEUE_SIZE - RSS_COMMS_MAX_CONCURRENT_REQ;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    if (reply_queue_count >= limit) {
+        CRITICAL_SECTION_LEAVE(cs_assert);
+        return TFM_PLAT_ERR_SYSTEM_ERR;
+    }
+
+    reply_queue[reply_queue_head] = *entry;
+    reply_queue_head = (reply_queue_head + 1) % REPLY_QUEUE_SIZE;
+    reply_queue_count++;
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
+
+    return TFM_PLAT_ERR_SUCCESS;
+}
+
+void tfm_multi_core_hal_send_replies(void)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    struct comms_reply_t to_send;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    /* The other sender also sends the replies queued in the meantime */
+    if (is_sending_reply) {
+        CRITICAL_SECTION_LEAVE(cs_assert);
+        return;
+    }
+    is_sending_reply = true;
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
+
+    while (1) {
+        CRITICAL_SECTION_ENTER(cs_assert);
+
+        if (reply_queue_count == 0) {
+            is_sending_reply = false;
+            CRITICAL_SECTION_LEAVE(cs_assert);
+            break;
+        }
+
+        to_send = reply_queue[reply_queue_tail];
+        reply_queue_tail = (reply_queue_tail + 1) % REPLY_QUEUE_SIZE;
+        reply_queue_count--;
+
+        CRITICAL_SECTION_LEAVE(cs_assert);
+
+        send_reply(&to_send);
+    }
+}
+
 enum tfm_plat_err_t tfm_multi_core_hal_receive(void)
 {
     enum mhu_error_t mhu_err;
     enum tfm_plat_err_t err;
     size_t msg_len = sizeof(msg);
-    size_t reply_size;
+    struct comms_reply_t entry;
 
     memset(&msg, 0, sizeof(msg));
-    memset(&reply, 0, sizeof(reply));
 
     /* Receive complete message */
     mhu_err = mhu_receive_data(&MHU_AP_TO_RSS_DEV,
@@ -69,6 +204,7 @@ enum tfm_plat_err_t tfm_multi_core_hal_receive(void)
     SPMLOG_DBGMSGVAL("[COMMS] size=", msg_len);
     SPMLOG_DBGMSGVAL("[COMMS] seq_num=", msg.header.seq_num);
 
+    /* The other contexts only free requests inside critical sections */
     struct client_request_t *req = tfm_pool_alloc(req_pool);
     if (!req) {
         /* No free capacity, drop message */
@@ -80,28 +216,30 @@ enum tfm_plat_err_t tfm_multi_core_hal_receive(void)
     if (err != TFM_PLAT_ERR_SUCCESS) {
         /* Deserialisation failed, drop message */
         SPMLOG_DBGMSGVAL("[COMMS] Deserialize message failed: ", err);
-        goto out_free_req;
+        goto out_return_err;
     }
 
     if (queue_enqueue(req) != 0) {
         /* No queue capacity, drop message */
         err = TFM_PLAT_ERR_SYSTEM_ERR;
-        goto out_free_req;
+        goto out_return_err;
     }
 
     /* Message successfully received */
     return TFM_PLAT_ERR_SUCCESS;
 
-out_free_req:
-    tfm_pool_free(req_pool, req);
-
 out_return_err:
-    /* Attempt to respond with a failure message */
-    if (rss_protocol_serialize_error(req, &msg.header,
-                                     PSA_ERROR_CONNECTION_BUSY,
-                                     &reply, &reply_size)
-        == TFM_PLAT_ERR_SUCCESS) {
-        mhu_send_data(&MHU_RSS_TO_AP_DEV, (uint8_t *)&reply, reply_size);
+    /* Attempt to respond with a failure message. The request, if any, is freed
+     * once the reply is sent. Replies are not sent from the interrupt handler.
+     * This reply is sent when the mailbox signal raised by this interrupt is
+     * handled, or by a reply sender running already.
+     */
+    entry.req = req;
+    memcpy(&entry.header, &msg.header, sizeof(entry.header));
+    entry.error = PSA_ERROR_CONNECTION_BUSY;
+
+    if (queue_reply(&entry) != TFM_PLAT_ERR_SUCCESS && req != NULL) {
+        free_req(req);
     }
 
     return err;
@@ -109,34 +247,23 @@ out_return_err:
 
 enum tfm_plat_err_t tfm_multi_core_hal_reply(struct client_request_t *req)
 {
+    struct comms_reply_t entry;
     enum tfm_plat_err_t err;
-    enum mhu_error_t mhu_err;
-    size_t reply_size;
 
     if (!is_valid_chunk_data_in_pool(req_pool, (uint8_t *)req)) {
         return TFM_PLAT_ERR_SYSTEM_ERR;
     }
 
-    /* FIXME: Queue replies to avoid blocking execution */
+    /* The replies queued are sent together by the caller */
+    entry.req = req;
+    entry.error = PSA_SUCCESS;
 
-    err = rss_protocol_serialize_reply(req, &reply, &reply_size);
+    err = queue_reply(&entry);
     if (err != TFM_PLAT_ERR_SUCCESS) {
-        SPMLOG_DBGMSGVAL("[COMMS] Serialize reply failed: ", err);
-        goto out;
-    }
-
-    mhu_err = mhu_send_data(&MHU_RSS_TO_AP_DEV, (uint8_t *)&reply, reply_size);
-    if (mhu_err != MHU_ERR_NONE) {
-        SPMLOG_DBGMSGVAL("[COMMS] MHU send failed: ", mhu_err);
-        err = TFM_PLAT_ERR_SYSTEM_ERR;
-        goto out;
+        return err;
     }
 
-    SPMLOG_DBGMSG("[COMMS] Sent reply\r\n");
-
-out:
-    tfm_pool_free(req_pool, req);
-    return err;
+    return TFM_PLAT_ERR_SUCCESS;
 }
 
 enum tfm_plat_err_t tfm_multi_core_hal_init(void)
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -33,14 +33,21 @@ enum tfm_plat_err_t tfm_multi_core_hal_init(void);
 enum tfm_plat_err_t tfm_multi_core_hal_receive(void);
 
 /**
- * \brief Notify NSPE that a PSA client call return result is replied.
+ * \brief Queue the reply of a PSA client call to NSPE. The reply is sent by
+ *        \ref tfm_multi_core_hal_send_replies.
  *        Implemented by platform specific inter-processor communication driver.
  *
- * \retval TFM_PLAT_ERR_SUCCESS  The notification is successfully sent out.
+ * \retval TFM_PLAT_ERR_SUCCESS  The reply is successfully queued.
  * \retval Other return code     Operation failed with an error code.
  */
 enum tfm_plat_err_t tfm_multi_core_hal_reply(struct client_request_t *req);
 
+/**
+ * \brief Send the queued replies to NSPE, unless another context is sending
+ *        them already. It must not be called from the receive interrupt handler.
+ */
+void tfm_multi_core_hal_send_replies(void);
+
 #ifdef __cplusplus
 }
 #endif
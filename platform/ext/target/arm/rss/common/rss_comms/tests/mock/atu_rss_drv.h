@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/* Mock ATU driver recording the programmed regions */
+
+#ifndef __ATU_RSS_DRV_H__
+#define __ATU_RSS_DRV_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_ATU_REGION_NUM     32
+
+enum atu_error_t {
+    ATU_ERR_NONE,
+    ATU_ERR_INVALID_REGION,
+    ATU_ERR_INVALID_ADDRESS,
+    ATU_ERR_INVALID_ARG,
+};
+
+struct mock_atu_region_t {
+    bool     is_enabled;
+    uint32_t log_addr;
+    uint64_t phys_addr;
+    uint32_t size;
+};
+
+struct atu_dev_t {
+    struct mock_atu_region_t regions[MOCK_ATU_REGION_NUM];
+    uint32_t                 nr_init;       /* Calls to initialize a region */
+    uint32_t                 nr_uninit;     /* Calls to uninitialize one */
+    bool                     is_fail_next;  /* Fail the next call */
+};
+
+enum atu_error_t atu_initialize_region(struct atu_dev_t *dev, uint8_t region,
+                                       uint32_t log_addr, uint64_t phys_addr,
+                                       uint32_t size);
+
+enum atu_error_t atu_uninitialize_region(struct atu_dev_t *dev, uint8_t region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ATU_RSS_DRV_H__ */
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __DEVICE_DEFINITION_H__
+#define __DEVICE_DEFINITION_H__
+
+#include "atu_rss_drv.h"
+
+extern struct atu_dev_t ATU_DEV_S;
+
+#endif /* __DEVICE_DEFINITION_H__ */
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __PLATFORM_BASE_ADDRESS_H__
+#define __PLATFORM_BASE_ADDRESS_H__
+
+#define HOST_COMMS_MAPPABLE_BASE_S      0x70000000
+
+#endif /* __PLATFORM_BASE_ADDRESS_H__ */
@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef __TFM_SPM_LOG_H__
+#define __TFM_SPM_LOG_H__
+
+#define SPMLOG_DBGMSG(msg)
+#define SPMLOG_DBGMSGVAL(msg, val)
+#define SPMLOG_ERRMSG(msg)
+#define SPMLOG_ERRMSGVAL(msg, val)
+
+#endif /* __TFM_SPM_LOG_H__ */
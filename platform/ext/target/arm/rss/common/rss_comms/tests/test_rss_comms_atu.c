@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Host unit test of the RSS comms ATU region allocator against a mock ATU
+ * driver, which records the regions programmed in the ATU.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rss_comms_atu.h"
+#include "atu_rss_drv.h"
+#include "device_definition.h"
+#include "platform_base_address.h"
+
+struct atu_dev_t ATU_DEV_S;
+
+static int nr_failures;
+
+#define TEST_ASSERT(cond)                                               \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("FAIL: %s:%d: %s\r\n", __func__, __LINE__, #cond);   \
+            nr_failures++;                                              \
+            return;                                                     \
+        }                                                               \
+    } while (0)
+
+/* Host buffers far enough apart to never share a region */
+#define HOST_BUF(n)     (0x800000000ULL + (uint64_t)(n) * 0x100000)
+
+enum atu_error_t atu_initialize_region(struct atu_dev_t *dev, uint8_t region,
+                                       uint32_t log_addr, uint64_t phys_addr,
+                                       uint32_t size)
+{
+    if (dev->is_fail_next) {
+        dev->is_fail_next = false;
+        return ATU_ERR_INVALID_ARG;
+    }
+
+    if ((region >= MOCK_ATU_REGION_NUM) || dev->regions[region].is_enabled ||
+        (size % RSS_COMMS_ATU_PAGE_SIZE) != 0 ||
+        (phys_addr % RSS_COMMS_ATU_PAGE_SIZE) != 0) {
+        return ATU_ERR_INVALID_REGION;
+    }
+
+    dev->regions[region].is_enabled = true;
+    dev->regions[region].log_addr = log_addr;
+    dev->regions[region].phys_addr = phys_addr;
+    dev->regions[region].size = size;
+    dev->nr_init++;
+
+    return ATU_ERR_NONE;
+}
+
+enum atu_error_t atu_uninitialize_region(struct atu_dev_t *dev, uint8_t region)
+{
+    if (dev->is_fail_next) {
+        dev->is_fail_next = false;
+        return ATU_ERR_INVALID_ARG;
+    }
+
+    if ((region >= MOCK_ATU_REGION_NUM) || !dev->regions[region].is_enabled) {
+        return ATU_ERR_INVALID_REGION;
+    }
+
+    dev->regions[region].is_enabled = false;
+    dev->nr_uninit++;
+
+    return ATU_ERR_NONE;
+}
+
+static uint32_t nr_enabled_regions(void)
+{
+    uint32_t idx, nr = 0;
+
+    for (idx = 0; idx < MOCK_ATU_REGION_NUM; idx++) {
+        if (ATU_DEV_S.regions[idx].is_enabled) {
+            nr++;
+        }
+    }
+
+    return nr;
+}
+
+/* Whether the host range is reachable through an enabled ATU region */
+static bool is_host_mapped(uint64_t host_addr, uint32_t size)
+{
+    const struct mock_atu_region_t *region;
+    uint32_t idx;
+
+    for (idx = 0; idx < MOCK_ATU_REGION_NUM; idx++) {
+        region = &ATU_DEV_S.regions[idx];
+        if (region->is_enabled && (host_addr + size > region->phys_addr) &&
+            (host_addr < region->phys_addr + region->size)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Unmap the idle regions and return the regions left mapped */
+static uint32_t unmap_idle_regions(void)
+{
+    if (comms_atu_unmap_idle_regions() != TFM_PLAT_ERR_SUCCESS) {
+        return UINT32_MAX;
+    }
+
+    return nr_enabled_regions();
+}
+
+static void test_map_and_translate(void)
+{
+    uint64_t host_addr = HOST_BUF(0) + 0x1234;
+    uint8_t region;
+    const struct mock_atu_region_t *mock;
+    void *rss_ptr;
+
+    TEST_ASSERT(comms_atu_alloc_region(host_addr, 0x100, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(region < RSS_COMMS_ATU_REGION_AM);
+
+    mock = &ATU_DEV_S.regions[region + RSS_COMMS_ATU_REGION_MIN];
+    TEST_ASSERT(mock->is_enabled);
+    TEST_ASSERT(mock->phys_addr <= host_addr);
+    TEST_ASSERT(host_addr + 0x100 <= mock->phys_addr + mock->size);
+    TEST_ASSERT(mock->log_addr ==
+                (uint32_t)(HOST_COMMS_MAPPABLE_BASE_S +
+                           RSS_COMMS_ATU_REGION_SIZE * region));
+
+    TEST_ASSERT(comms_atu_get_rss_ptr_from_host_addr(region, host_addr,
+                                                     &rss_ptr) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT((uintptr_t)rss_ptr ==
+                mock->log_addr + (uint32_t)(host_addr - mock->phys_addr));
+
+    TEST_ASSERT(comms_atu_free_region(region) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+/* Buffers of requests in flight share a mapped region */
+static void test_share_in_flight(void)
+{
+    uint8_t first, second;
+    uint32_t nr_init = ATU_DEV_S.nr_init;
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(1), 0x40, &first) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(1) + 0x80, 0x40, &second) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(first == second);
+    TEST_ASSERT(ATU_DEV_S.nr_init == nr_init + 1);
+
+    /* The region is kept while a reference is left */
+    TEST_ASSERT(comms_atu_free_region(first) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(is_host_mapped(HOST_BUF(1), 0x40));
+
+    TEST_ASSERT(comms_atu_free_region(second) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+/* A freed region stays mapped for the next request using the same buffer */
+static void test_idle_reuse(void)
+{
+    comms_atu_region_set_t set;
+    uint8_t region;
+    uint32_t nr_init;
+
+    memset(&set, 0, sizeof(set));
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(2), 0x100, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_add_region_to_set(&set, region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(2) + 0x200, 0x100, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_add_region_to_set(&set, region) ==
+                TFM_PLAT_ERR_SUCCESS);
+
+    TEST_ASSERT(comms_atu_free_regions(set) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(is_host_mapped(HOST_BUF(2), 0x100));
+
+    /* The same buffer in the next request is not mapped again */
+    nr_init = ATU_DEV_S.nr_init;
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(2), 0x100, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(ATU_DEV_S.nr_init == nr_init);
+    TEST_ASSERT(comms_atu_free_region(region) == TFM_PLAT_ERR_SUCCESS);
+
+    /* No host memory stays reachable once the idle regions are unmapped */
+    TEST_ASSERT(comms_atu_unmap_idle_regions() == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(!is_host_mapped(HOST_BUF(2), RSS_COMMS_ATU_REGION_SIZE));
+    TEST_ASSERT(nr_enabled_regions() == 0);
+}
+
+/* At most RSS_COMMS_ATU_IDLE_REGION_NUM regions stay mapped while idle */
+static void test_idle_bound(void)
+{
+    uint8_t regions[RSS_COMMS_ATU_IDLE_REGION_NUM + 1];
+    uint32_t idx;
+
+    for (idx = 0; idx <= RSS_COMMS_ATU_IDLE_REGION_NUM; idx++) {
+        TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(idx), 0x10,
+                                           &regions[idx]) ==
+                    TFM_PLAT_ERR_SUCCESS);
+    }
+
+    for (idx = 0; idx <= RSS_COMMS_ATU_IDLE_REGION_NUM; idx++) {
+        TEST_ASSERT(comms_atu_free_region(regions[idx]) ==
+                    TFM_PLAT_ERR_SUCCESS);
+    }
+    TEST_ASSERT(nr_enabled_regions() == RSS_COMMS_ATU_IDLE_REGION_NUM);
+
+    /* The least recently used one is unmapped */
+    TEST_ASSERT(!is_host_mapped(HOST_BUF(0), 0x10));
+    TEST_ASSERT(is_host_mapped(HOST_BUF(RSS_COMMS_ATU_IDLE_REGION_NUM), 0x10));
+
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+/* An idle region not reused is unmapped after RSS_COMMS_ATU_IDLE_REGION_AGE
+ * allocations
+ */
+static void test_idle_age(void)
+{
+    uint8_t region, other;
+    uint32_t idx;
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(2), 0x10, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(region) == TFM_PLAT_ERR_SUCCESS);
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(3), 0x10, &other) ==
+                TFM_PLAT_ERR_SUCCESS);
+    for (idx = 1; idx < RSS_COMMS_ATU_IDLE_REGION_AGE; idx++) {
+        TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(3), 0x10, &other) ==
+                    TFM_PLAT_ERR_SUCCESS);
+        TEST_ASSERT(comms_atu_free_region(other) == TFM_PLAT_ERR_SUCCESS);
+    }
+    TEST_ASSERT(is_host_mapped(HOST_BUF(2), 0x10));
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(3), 0x10, &other) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(!is_host_mapped(HOST_BUF(2), 0x10));
+
+    TEST_ASSERT(comms_atu_free_region(other) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(other) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+/* A request received before the previous one is freed keeps the region */
+static void test_next_request_hit(void)
+{
+    uint8_t prev, next;
+    uint32_t nr_init = ATU_DEV_S.nr_init;
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(3), 0x100, &prev) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(3), 0x100, &next) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(prev == next);
+
+    TEST_ASSERT(comms_atu_free_region(prev) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(is_host_mapped(HOST_BUF(3), 0x100));
+    TEST_ASSERT(ATU_DEV_S.nr_init == nr_init + 1);
+
+    TEST_ASSERT(comms_atu_free_region(next) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+static void test_exhaustion(void)
+{
+    uint8_t regions[RSS_COMMS_ATU_REGION_AM];
+    uint8_t region;
+    uint32_t idx;
+
+    for (idx = 0; idx < RSS_COMMS_ATU_REGION_AM; idx++) {
+        TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(idx), 0x10,
+                                           &regions[idx]) ==
+                    TFM_PLAT_ERR_SUCCESS);
+    }
+    TEST_ASSERT(nr_enabled_regions() == RSS_COMMS_ATU_REGION_AM);
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(idx), 0x10, &region) ==
+                TFM_PLAT_ERR_MAX_VALUE);
+
+    /* A freed region is evicted for another buffer */
+    TEST_ASSERT(comms_atu_free_region(regions[0]) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(idx), 0x10, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(region == regions[0]);
+    TEST_ASSERT(!is_host_mapped(HOST_BUF(0), 0x10));
+    regions[0] = region;
+
+    for (idx = 0; idx < RSS_COMMS_ATU_REGION_AM; idx++) {
+        TEST_ASSERT(comms_atu_free_region(regions[idx]) ==
+                    TFM_PLAT_ERR_SUCCESS);
+    }
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+static void test_invalid_buffers(void)
+{
+    uint8_t region;
+
+    /* Larger than a region */
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(4),
+                                       RSS_COMMS_ATU_REGION_SIZE + 1,
+                                       &region) != TFM_PLAT_ERR_SUCCESS);
+    /* Wrapping around the address space */
+    TEST_ASSERT(comms_atu_alloc_region(UINT64_MAX - 0xF, 0x20, &region) !=
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(4), 0, &region) !=
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(nr_enabled_regions() == 0);
+}
+
+static void test_invalid_free(void)
+{
+    comms_atu_region_set_t set;
+    uint8_t region;
+
+    memset(&set, 0, sizeof(set));
+
+    TEST_ASSERT(comms_atu_free_region(0) == TFM_PLAT_ERR_INVALID_INPUT);
+    TEST_ASSERT(comms_atu_free_region(RSS_COMMS_ATU_REGION_AM) ==
+                TFM_PLAT_ERR_INVALID_INPUT);
+    TEST_ASSERT(comms_atu_add_region_to_set(&set, RSS_COMMS_ATU_REGION_AM) ==
+                TFM_PLAT_ERR_INVALID_INPUT);
+
+    /* The set holds more references than the region */
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(5), 0x10, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_add_region_to_set(&set, region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_add_region_to_set(&set, region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_regions(set) == TFM_PLAT_ERR_INVALID_INPUT);
+    TEST_ASSERT(is_host_mapped(HOST_BUF(5), 0x10));
+
+    TEST_ASSERT(comms_atu_free_region(region) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+static void test_driver_error(void)
+{
+    uint8_t region, other;
+
+    ATU_DEV_S.is_fail_next = true;
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(6), 0x10, &region) ==
+                TFM_PLAT_ERR_SYSTEM_ERR);
+
+    /* The failed mapping holds no reference */
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(7), 0x10, &region) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(6), 0x10, &other) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(region) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(other) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+static void test_stats(void)
+{
+    struct comms_atu_stats_t before, after;
+    uint8_t first, second;
+
+    comms_atu_get_stats(&before);
+
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(8), 0x10, &first) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(8) + 0x10, 0x10, &second) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(first) == TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(second) == TFM_PLAT_ERR_SUCCESS);
+
+    /* The idle region is hit again */
+    TEST_ASSERT(comms_atu_alloc_region(HOST_BUF(8), 0x10, &first) ==
+                TFM_PLAT_ERR_SUCCESS);
+    TEST_ASSERT(comms_atu_free_region(first) == TFM_PLAT_ERR_SUCCESS);
+
+    comms_atu_get_stats(&after);
+    TEST_ASSERT(after.misses == before.misses + 1);
+    TEST_ASSERT(after.hits == before.hits + 2);
+    TEST_ASSERT(after.evictions == before.evictions);
+
+    TEST_ASSERT(unmap_idle_regions() == 0);
+}
+
+static const struct {
+    const char *name;
+    void (*func)(void);
+} tests[] = {
+    {"Map and translate",       test_map_and_translate},
+    {"Share in flight",         test_share_in_flight},
+    {"Idle reuse",              test_idle_reuse},
+    {"Idle bound",              test_idle_bound},
+    {"Idle age",                test_idle_age},
+    {"Next request hit",        test_next_request_hit},
+    {"Exhaustion",              test_exhaustion},
+    {"Invalid buffers",         test_invalid_buffers},
+    {"Invalid free",            test_invalid_free},
+    {"Driver error",            test_driver_error},
+    {"Statistics",              test_stats},
+};
+
+int main(void)
+{
+    uint32_t i;
+    int failures;
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failures = nr_failures;
+        tests[i].func();
+        printf("%s: %s\r\n", nr_failures == failures ? "PASS" : "FAIL",
+               tests[i].name);
+    }
+
+    return nr_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -26,12 +26,106 @@
 #define CRYPTO_ENGINE_BUF_SIZE                 0x4000
 #endif
 
+/*
+ * Allocate the memory of the crypto backend in fixed size classes, which takes
+ * constant time and reports the usage, instead of the Mbed TLS buffer
+ * allocator
+ */
+#ifndef CRYPTO_ENGINE_POOL_ALLOC
+#define CRYPTO_ENGINE_POOL_ALLOC               0
+#endif
+
 /* The max number of concurrent operations that can be active (allocated) at any time in Crypto */
 #ifndef CRYPTO_CONC_OPER_NUM
 #pragma message("CRYPTO_CONC_OPER_NUM is defaulted to 8. Please check and set it explicitly.")
 #define CRYPTO_CONC_OPER_NUM                   8
 #endif
 
+/*
+ * The number of concurrent operations of a type which are allocated from a
+ * dedicated pool of contexts sized for that type, before falling back to the
+ * CRYPTO_CONC_OPER_NUM contexts shared by all types. They are optional.
+ */
+#ifndef CRYPTO_CIPHER_OPER_NUM
+#define CRYPTO_CIPHER_OPER_NUM                 0
+#endif
+
+#ifndef CRYPTO_MAC_OPER_NUM
+#define CRYPTO_MAC_OPER_NUM                    0
+#endif
+
+#ifndef CRYPTO_HASH_OPER_NUM
+#define CRYPTO_HASH_OPER_NUM                   0
+#endif
+
+#ifndef CRYPTO_KEY_DERIVATION_OPER_NUM
+#define CRYPTO_KEY_DERIVATION_OPER_NUM         0
+#endif
+
+#ifndef CRYPTO_AEAD_OPER_NUM
+#define CRYPTO_AEAD_OPER_NUM                   0
+#endif
+
+/*
+ * The max number of concurrent operations of a single client. 0 means no limit
+ * other than the number of contexts.
+ */
+#ifndef CRYPTO_CONC_OPER_NUM_PER_CLIENT
+#define CRYPTO_CONC_OPER_NUM_PER_CLIENT        0
+#endif
+
+/* The number of the shared contexts which only secure partitions can take */
+#ifndef CRYPTO_CONC_OPER_NUM_SECURE_RESERVED
+#define CRYPTO_CONC_OPER_NUM_SECURE_RESERVED   0
+#endif
+
+/*
+ * Measure the time spent by the service in each group of functions. The
+ * platform shall define CRYPTO_PROFILING_TIMESTAMP() to read a free-running
+ * cycle counter.
+ */
+#ifndef CRYPTO_PROFILING_ENABLED
+#define CRYPTO_PROFILING_ENABLED               0
+#endif
+
+/*
+ * Print the statistics of the service after every CRYPTO_STATS_REPORT_INTERVAL
+ * requests. 0 means never.
+ */
+#ifndef CRYPTO_STATS_REPORT_INTERVAL
+#define CRYPTO_STATS_REPORT_INTERVAL           0
+#endif
+
+/*
+ * The number of persistent key records cached from ITS. Mbed TLS reloads a
+ * persistent key from ITS each time it is evicted from the key slots. 0
+ * disables the cache. It is set by the CRYPTO_KEY_CACHE_NUM build option, as
+ * the cache is only built into Mbed TLS when enabled.
+ */
+#ifndef CRYPTO_KEY_CACHE_NUM
+#define CRYPTO_KEY_CACHE_NUM                   0
+#endif
+
+/* The max size of a cached key record, including its Mbed TLS header */
+#ifndef CRYPTO_KEY_CACHE_RECORD_SIZE
+#define CRYPTO_KEY_CACHE_RECORD_SIZE           128
+#endif
+
+/*
+ * CRYPTO_KEY_CACHE_PINNED_KEYS can be defined to a list of {owner, key ID}
+ * pairs, such as {-1, 0x10}, {0x100, 0x20}. These keys are read into the cache
+ * at init and never evicted.
+ */
+
+/*
+ * The number of subkeys derived from the builtin keys which are kept for reuse.
+ * A platform which changes the PSA RoT lifecycle state at runtime flushes the
+ * cache with tfm_builtin_key_loader_flush_derived_keys(). 0 disables the cache.
+ */
+#ifndef TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE
+#define TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE     4
+#endif
+
 /* Enable PSA Crypto random number generator module */
 #ifndef CRYPTO_RNG_MODULE_ENABLED
 #pragma message("CRYPTO_RNG_MODULE_ENABLED is defaulted to 1. Please check and set it explicitly.")
@@ -1,10 +1,11 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
@@ -14,24 +15,130 @@
 
 #include "tfm_crypto_api.h"
 #include "tfm_crypto_defs.h"
+#ifdef TFM_NS_MANAGE_NSID
+#include "service_api.h"
+#endif
 
 
+/*
+ * The contexts of the multipart operations are kept in pools. The shared pool
+ * has CRYPTO_CONC_OPER_NUM contexts sized for the largest operation type. An
+ * operation type can also have a dedicated pool of contexts sized for that
+ * type only, which is used first. Each pool keeps its unused contexts in a
+ * free list, so that both allocation and release take constant time.
+ */
+#define TFM_CRYPTO_SHARED_POOL      (0)
+#define TFM_CRYPTO_POOL_NUM         (TFM_CRYPTO_AEAD_OPERATION + 1)
+
+#define TFM_CRYPTO_OPER_TOTAL_NUM   (CRYPTO_CONC_OPER_NUM +            \
+                                     CRYPTO_CIPHER_OPER_NUM +          \
+                                     CRYPTO_MAC_OPER_NUM +             \
+                                     CRYPTO_HASH_OPER_NUM +            \
+                                     CRYPTO_KEY_DERIVATION_OPER_NUM +  \
+                                     CRYPTO_AEAD_OPER_NUM)
+
+#if (TFM_CRYPTO_OPER_TOTAL_NUM == 0) || (TFM_CRYPTO_OPER_TOTAL_NUM >= UINT16_MAX)
+#error "Invalid number of concurrent operations in Crypto"
+#endif
+
+#define TFM_CRYPTO_OPER_NULL_IDX    UINT16_MAX
+
+union tfm_crypto_operation_u {
+    psa_cipher_operation_t cipher;    /*!< Cipher operation context */
+    psa_mac_operation_t mac;          /*!< MAC operation context */
+    psa_hash_operation_t hash;        /*!< Hash operation context */
+    psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
+    psa_aead_operation_t aead;        /*!< AEAD operation context */
+};
+
 struct tfm_crypto_operation_s {
     uint32_t in_use;                /*!< Indicates if the operation is in use */
     int32_t owner;                  /*!< Indicates an ID of the owner of
                                      *   the context
                                      */
     enum tfm_crypto_operation_type type; /*!< Type of the operation */
-    union {
-        psa_cipher_operation_t cipher;    /*!< Cipher operation context */
-        psa_mac_operation_t mac;          /*!< MAC operation context */
-        psa_hash_operation_t hash;        /*!< Hash operation context */
-        psa_key_derivation_operation_t key_deriv; /*!< Key derivation operation context */
-        psa_aead_operation_t aead;        /*!< AEAD operation context */
-    } operation;
+    void *ctx;                      /*!< The context in the pool */
+    uint16_t next_free;             /*!< Next unused context in the pool */
+    uint8_t pool;                   /*!< The pool which the context is in */
 };
 
-static struct tfm_crypto_operation_s operations[CRYPTO_CONC_OPER_NUM] = {{0}};
+static struct tfm_crypto_operation_s operations[TFM_CRYPTO_OPER_TOTAL_NUM];
+
+/* Head of the free list of each pool */
+static uint16_t free_list[TFM_CRYPTO_POOL_NUM];
+
+/* Number of the contexts in the free list of each pool */
+static uint16_t nr_free[TFM_CRYPTO_POOL_NUM];
+
+static struct tfm_crypto_operation_stats_t oper_stats;
+
+/*
+ * The clients holding contexts and the number of contexts each of them holds.
+ * A client is removed once it holds no context, so the entries in use are
+ * packed at the beginning of the array.
+ */
+struct tfm_crypto_owner_s {
+    int32_t owner;                  /*!< The client ID */
+    uint16_t nr_operations;         /*!< Number of the contexts in use */
+};
+
+static struct tfm_crypto_owner_s owners[TFM_CRYPTO_OPER_TOTAL_NUM];
+static uint32_t nr_owners;
+
+#ifdef TFM_NS_MANAGE_NSID
+/*
+ * Sequence number of the next non-secure client release recorded by SPM. The
+ * contexts left by the released clients are only reclaimed when an allocation
+ * runs short of contexts, so that the requests do not pay for reading the
+ * releases.
+ */
+static uint32_t ns_release_seq;
+#endif
+
+#if CRYPTO_CONC_OPER_NUM > 0
+static union tfm_crypto_operation_u shared_ctx[CRYPTO_CONC_OPER_NUM];
+#endif
+#if CRYPTO_CIPHER_OPER_NUM > 0
+static psa_cipher_operation_t cipher_ctx[CRYPTO_CIPHER_OPER_NUM];
+#endif
+#if CRYPTO_MAC_OPER_NUM > 0
+static psa_mac_operation_t mac_ctx[CRYPTO_MAC_OPER_NUM];
+#endif
+#if CRYPTO_HASH_OPER_NUM > 0
+static psa_hash_operation_t hash_ctx[CRYPTO_HASH_OPER_NUM];
+#endif
+#if CRYPTO_KEY_DERIVATION_OPER_NUM > 0
+static psa_key_derivation_operation_t key_deriv_ctx[CRYPTO_KEY_DERIVATION_OPER_NUM];
+#endif
+#if CRYPTO_AEAD_OPER_NUM > 0
+static psa_aead_operation_t aead_ctx[CRYPTO_AEAD_OPER_NUM];
+#endif
+
+/*
+ * \brief Function used to get the size of the backend context of a type
+ *
+ * \param[in] type Type of the operation
+ *
+ * \return Size of the context
+ *
+ */
+static size_t operation_context_size(enum tfm_crypto_operation_type type)
+{
+    switch (type) {
+    case TFM_CRYPTO_CIPHER_OPERATION:
+        return sizeof(psa_cipher_operation_t);
+    case TFM_CRYPTO_MAC_OPERATION:
+        return sizeof(psa_mac_operation_t);
+    case TFM_CRYPTO_HASH_OPERATION:
+        return sizeof(psa_hash_operation_t);
+    case TFM_CRYPTO_KEY_DERIVATION_OPERATION:
+        return sizeof(psa_key_derivation_operation_t);
+    case TFM_CRYPTO_AEAD_OPERATION:
+        return sizeof(psa_aead_operation_t);
+    default:
+        return sizeof(union tfm_crypto_operation_u);
+    }
+}
 
 /*
  * \brief Function used to clear the memory associated to a backend context
@@ -43,9 +150,299 @@ static struct tfm_crypto_operation_s operations[CRYPTO_CONC_OPER_NUM] = {{0}};
  */
 static void memset_operation_context(uint32_t index)
 {
-    /* Clear the contents of the backend context */
-    (void)memset((uint8_t *)&(operations[index].operation), 0,
-                 sizeof(operations[index].operation));
+    /* Only the part used by the type of the operation needs to be cleared */
+    (void)memset(operations[index].ctx, 0,
+                 operation_context_size(operations[index].type));
+}
+
+/*
+ * \brief Function used to add the contexts of a pool to the database
+ *
+ * \param[in] pool   The pool the contexts are in
+ * \param[in] first  Index of the first context in the database
+ * \param[in] num    Number of the contexts in the pool
+ * \param[in] base   Base address of the contexts
+ * \param[in] stride Size of a context
+ *
+ * \return Index of the context following the pool in the database
+ *
+ */
+static uint32_t init_pool(uint8_t pool, uint32_t first, uint32_t num,
+                          uint8_t *base, size_t stride)
+{
+    uint32_t i;
+
+    /* Lower contexts are popped first */
+    for (i = num; i > 0; i--) {
+        operations[first + i - 1].ctx = base + (i - 1) * stride;
+        operations[first + i - 1].pool = pool;
+        operations[first + i - 1].next_free = free_list[pool];
+        free_list[pool] = (uint16_t)(first + i - 1);
+    }
+    nr_free[pool] = (uint16_t)num;
+
+    return first + num;
+}
+
+/*
+ * \brief Function used to find a client holding contexts
+ *
+ * \param[in] owner The client ID
+ *
+ * \return Index of the client in the owners, or nr_owners if not found
+ *
+ */
+static uint32_t find_owner(int32_t owner)
+{
+    uint32_t i;
+
+    for (i = 0; i < nr_owners; i++) {
+        if (owners[i].owner == owner) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+#if (CRYPTO_CONC_OPER_NUM_PER_CLIENT > 0) || defined(TFM_NS_MANAGE_NSID)
+/*
+ * \brief Function used to get the number of contexts held by a client
+ *
+ * \param[in] owner The client ID
+ *
+ * \return Number of the contexts in use by the client
+ *
+ */
+static uint32_t owner_operations(int32_t owner)
+{
+    uint32_t i = find_owner(owner);
+
+    return (i < nr_owners) ? owners[i].nr_operations : 0;
+}
+#endif
+
+/*
+ * \brief Function used to count a context taken by a client
+ *
+ * \param[in] owner The client ID
+ *
+ * \return None
+ *
+ */
+static void add_owner_operation(int32_t owner)
+{
+    uint32_t i = find_owner(owner);
+
+    /* There are never more owners than contexts */
+    if (i == nr_owners) {
+        owners[i].owner = owner;
+        owners[i].nr_operations = 0;
+        nr_owners++;
+    }
+    owners[i].nr_operations++;
+}
+
+/*
+ * \brief Function used to count a context given back by a client
+ *
+ * \param[in] owner The client ID
+ *
+ * \return None
+ *
+ */
+static void remove_owner_operation(int32_t owner)
+{
+    uint32_t i = find_owner(owner);
+
+    if (i == nr_owners) {
+        return;
+    }
+
+    /* Move the last owner to the entry of a client holding no more context */
+    if (--owners[i].nr_operations == 0) {
+        owners[i] = owners[--nr_owners];
+    }
+}
+
+/*
+ * \brief Function used to put a context in use back to its pool
+ *
+ * \param[in] index Numerical index in the database of the backend contexts
+ *
+ * \return None
+ *
+ */
+static void free_operation(uint32_t index)
+{
+    uint8_t pool = operations[index].pool;
+
+    if (operations[index].owner < 0) {
+        oper_stats.in_use_ns--;
+    }
+    oper_stats.in_use--;
+    remove_owner_operation(operations[index].owner);
+
+    memset_operation_context(index);
+    operations[index].in_use = TFM_CRYPTO_NOT_IN_USE;
+    operations[index].type = TFM_CRYPTO_OPERATION_NONE;
+    operations[index].owner = 0;
+
+    /* Give the context back to the pool it was taken from */
+    operations[index].next_free = free_list[pool];
+    free_list[pool] = (uint16_t)index;
+    nr_free[pool]++;
+}
+
+#ifdef TFM_NS_MANAGE_NSID
+/*
+ * \brief Function used to abort and free the contexts of a released
+ *        non-secure client
+ *
+ * \param[in] owner The client ID of the released non-secure client
+ *
+ * \return None
+ *
+ */
+static void reclaim_owner_operations(int32_t owner)
+{
+    uint32_t i, nr_left;
+    void *ctx;
+
+    nr_left = owner_operations(owner);
+
+    for (i = 0; (i < TFM_CRYPTO_OPER_TOTAL_NUM) && (nr_left > 0); i++) {
+        if ((operations[i].in_use != TFM_CRYPTO_IN_USE) ||
+            (operations[i].owner != owner)) {
+            continue;
+        }
+
+        /* The backend may hold resources, such as key slots, until aborted */
+        ctx = operations[i].ctx;
+        switch (operations[i].type) {
+#if CRYPTO_CIPHER_MODULE_ENABLED
+        case TFM_CRYPTO_CIPHER_OPERATION:
+            (void)psa_cipher_abort((psa_cipher_operation_t *)ctx);
+            break;
+#endif
+#if CRYPTO_MAC_MODULE_ENABLED
+        case TFM_CRYPTO_MAC_OPERATION:
+            (void)psa_mac_abort((psa_mac_operation_t *)ctx);
+            break;
+#endif
+#if CRYPTO_HASH_MODULE_ENABLED
+        case TFM_CRYPTO_HASH_OPERATION:
+            (void)psa_hash_abort((psa_hash_operation_t *)ctx);
+            break;
+#endif
+#if CRYPTO_KEY_DERIVATION_MODULE_ENABLED
+        case TFM_CRYPTO_KEY_DERIVATION_OPERATION:
+            (void)psa_key_derivation_abort(
+                                    (psa_key_derivation_operation_t *)ctx);
+            break;
+#endif
+#if CRYPTO_AEAD_MODULE_ENABLED
+        case TFM_CRYPTO_AEAD_OPERATION:
+            (void)psa_aead_abort((psa_aead_operation_t *)ctx);
+            break;
+#endif
+        default:
+            break;
+        }
+        (void)ctx;
+
+        free_operation(i);
+        oper_stats.reclaimed++;
+        nr_left--;
+    }
+}
+
+/*
+ * \brief Function used to reclaim the contexts of the non-secure clients
+ *        released since the last call
+ *
+ * \return true if any context is reclaimed
+ *
+ */
+static bool reclaim_released_operations(void)
+{
+    psa_status_t status;
+    int32_t nsid;
+    uint32_t i;
+    uint32_t nr_reclaimed = oper_stats.reclaimed;
+
+    while (1) {
+        status = tfm_core_get_ns_client_release(&ns_release_seq, &nsid);
+        if (status == PSA_SUCCESS) {
+            /*
+             * The releases are read late, the client ID may have been given
+             * to a new client since.
+             */
+            if ((nsid < 0) && !tfm_core_is_ns_client_active(nsid)) {
+                reclaim_owner_operations(nsid);
+            }
+        } else if (status == PSA_ERROR_INSUFFICIENT_MEMORY) {
+            /*
+             * Some releases were missed, check all the non-secure clients.
+             * A reclaimed client is replaced by the last one in the owners.
+             */
+            i = 0;
+            while (i < nr_owners) {
+                if ((owners[i].owner < 0) &&
+                    !tfm_core_is_ns_client_active(owners[i].owner)) {
+                    reclaim_owner_operations(owners[i].owner);
+                } else {
+                    i++;
+                }
+            }
+        } else {
+            break;
+        }
+    }
+
+    return oper_stats.reclaimed != nr_reclaimed;
+}
+#endif /* TFM_NS_MANAGE_NSID */
+
+/*
+ * \brief Function used to find the pool to take a context of a type from
+ *
+ * \param[in]  type         Type of the operation context
+ * \param[in]  partition_id Client ID of the caller
+ * \param[out] pool         Pool to take the context from
+ *
+ * \return PSA_SUCCESS if a context is available, PSA_ERROR_NOT_PERMITTED if
+ *         all the contexts are in use, or PSA_ERROR_INSUFFICIENT_MEMORY if
+ *         the caller has hit a quota
+ */
+static psa_status_t find_free_pool(enum tfm_crypto_operation_type type,
+                                   int32_t partition_id,
+                                   uint8_t *pool)
+{
+#if CRYPTO_CONC_OPER_NUM_PER_CLIENT > 0
+    /* A single client cannot take all the contexts */
+    if (owner_operations(partition_id) >=
+                                        CRYPTO_CONC_OPER_NUM_PER_CLIENT) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+#endif
+
+    /* Take a context sized for the type first, then one from the shared pool */
+    *pool = (uint8_t)type;
+    if (nr_free[*pool] == 0) {
+        *pool = TFM_CRYPTO_SHARED_POOL;
+        if (nr_free[*pool] == 0) {
+            return PSA_ERROR_NOT_PERMITTED;
+        }
+
+        /* The last shared contexts are kept for secure partitions */
+        if ((partition_id < 0) &&
+            (nr_free[*pool] <= CRYPTO_CONC_OPER_NUM_SECURE_RESERVED)) {
+            return PSA_ERROR_INSUFFICIENT_MEMORY;
+        }
+    }
+
+    return PSA_SUCCESS;
 }
 
 /*!
@@ -57,8 +454,54 @@ static void memset_operation_context(uint32_t index)
 /*!@{*/
 psa_status_t tfm_crypto_init_alloc(void)
 {
+    uint32_t i, next = 0;
+
     /* Clear the contents of the local contexts */
     (void)memset(operations, 0, sizeof(operations));
+
+    (void)memset(&oper_stats, 0, sizeof(oper_stats));
+    nr_owners = 0;
+
+    for (i = 0; i < TFM_CRYPTO_POOL_NUM; i++) {
+        free_list[i] = TFM_CRYPTO_OPER_NULL_IDX;
+        nr_free[i] = 0;
+    }
+
+#if CRYPTO_CONC_OPER_NUM > 0
+    (void)memset(shared_ctx, 0, sizeof(shared_ctx));
+    next = init_pool(TFM_CRYPTO_SHARED_POOL, next, CRYPTO_CONC_OPER_NUM,
+                     (uint8_t *)shared_ctx, sizeof(shared_ctx[0]));
+#endif
+#if CRYPTO_CIPHER_OPER_NUM > 0
+    (void)memset(cipher_ctx, 0, sizeof(cipher_ctx));
+    next = init_pool(TFM_CRYPTO_CIPHER_OPERATION, next, CRYPTO_CIPHER_OPER_NUM,
+                     (uint8_t *)cipher_ctx, sizeof(cipher_ctx[0]));
+#endif
+#if CRYPTO_MAC_OPER_NUM > 0
+    (void)memset(mac_ctx, 0, sizeof(mac_ctx));
+    next = init_pool(TFM_CRYPTO_MAC_OPERATION, next, CRYPTO_MAC_OPER_NUM,
+                     (uint8_t *)mac_ctx, sizeof(mac_ctx[0]));
+#endif
+#if CRYPTO_HASH_OPER_NUM > 0
+    (void)memset(hash_ctx, 0, sizeof(hash_ctx));
+    next = init_pool(TFM_CRYPTO_HASH_OPERATION, next, CRYPTO_HASH_OPER_NUM,
+                     (uint8_t *)hash_ctx, sizeof(hash_ctx[0]));
+#endif
+#if CRYPTO_KEY_DERIVATION_OPER_NUM > 0
+    (void)memset(key_deriv_ctx, 0, sizeof(key_deriv_ctx));
+    next = init_pool(TFM_CRYPTO_KEY_DERIVATION_OPERATION, next,
+                     CRYPTO_KEY_DERIVATION_OPER_NUM,
+                     (uint8_t *)key_deriv_ctx, sizeof(key_deriv_ctx[0]));
+#endif
+#if CRYPTO_AEAD_OPER_NUM > 0
+    (void)memset(aead_ctx, 0, sizeof(aead_ctx));
+    next = init_pool(TFM_CRYPTO_AEAD_OPERATION, next, CRYPTO_AEAD_OPER_NUM,
+                     (uint8_t *)aead_ctx, sizeof(aead_ctx[0]));
+#endif
+    (void)next;
+
+    oper_stats.total = TFM_CRYPTO_OPER_TOTAL_NUM;
+
     return PSA_SUCCESS;
 }
 
@@ -66,7 +509,8 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
                                         uint32_t *handle,
                                         void **ctx)
 {
-    uint32_t i = 0;
+    uint16_t idx;
+    uint8_t pool;
     int32_t partition_id = 0;
     psa_status_t status;
 
@@ -81,23 +525,54 @@ psa_status_t tfm_crypto_operation_alloc(enum tfm_crypto_operation_type type,
     }
     *ctx = NULL;
 
+    if ((type == TFM_CRYPTO_OPERATION_NONE) ||
+        ((uint32_t)type >= TFM_CRYPTO_POOL_NUM)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+
     status = tfm_crypto_get_caller_id(&partition_id);
     if (status != PSA_SUCCESS) {
         return status;
     }
 
-    for (i = 0; i < CRYPTO_CONC_OPER_NUM; i++) {
-        if (operations[i].in_use == TFM_CRYPTO_NOT_IN_USE) {
-            operations[i].in_use = TFM_CRYPTO_IN_USE;
-            operations[i].owner = partition_id;
-            operations[i].type = type;
-            *handle = i + 1;
-            *ctx = (void *) &(operations[i].operation);
-            return PSA_SUCCESS;
+    status = find_free_pool(type, partition_id, &pool);
+
+#ifdef TFM_NS_MANAGE_NSID
+    /* The contexts left by the released clients may free up some */
+    if ((status != PSA_SUCCESS) && reclaim_released_operations()) {
+        status = find_free_pool(type, partition_id, &pool);
+    }
+#endif
+
+    if (status != PSA_SUCCESS) {
+        if (status == PSA_ERROR_INSUFFICIENT_MEMORY) {
+            oper_stats.quota_rejects++;
         }
+        oper_stats.alloc_failures++;
+        return PSA_ERROR_NOT_PERMITTED;
+    }
+
+    idx = free_list[pool];
+    free_list[pool] = operations[idx].next_free;
+    nr_free[pool]--;
+
+    operations[idx].next_free = TFM_CRYPTO_OPER_NULL_IDX;
+    operations[idx].in_use = TFM_CRYPTO_IN_USE;
+    operations[idx].owner = partition_id;
+    operations[idx].type = type;
+    *handle = idx + 1;
+    *ctx = operations[idx].ctx;
+
+    if (partition_id < 0) {
+        oper_stats.in_use_ns++;
+    }
+    oper_stats.in_use++;
+    add_owner_operation(partition_id);
+    if (oper_stats.in_use > oper_stats.peak_in_use) {
+        oper_stats.peak_in_use = oper_stats.in_use;
     }
 
-    return PSA_ERROR_NOT_PERMITTED;
+    return PSA_SUCCESS;
 }
 
 psa_status_t tfm_crypto_operation_release(uint32_t *handle)
@@ -110,7 +585,7 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
     *handle = TFM_CRYPTO_INVALID_HANDLE;
 
     if ((h_val == TFM_CRYPTO_INVALID_HANDLE) ||
-        (h_val > CRYPTO_CONC_OPER_NUM)) {
+        (h_val > TFM_CRYPTO_OPER_TOTAL_NUM)) {
         return PSA_ERROR_INVALID_ARGUMENT;
     }
 
@@ -122,10 +597,7 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle)
     if ((operations[h_val - 1].in_use == TFM_CRYPTO_IN_USE) &&
         (operations[h_val - 1].owner == partition_id)) {
 
-        memset_operation_context(h_val - 1);
-        operations[h_val - 1].in_use = TFM_CRYPTO_NOT_IN_USE;
-        operations[h_val - 1].type = TFM_CRYPTO_OPERATION_NONE;
-        operations[h_val - 1].owner = 0;
+        free_operation(h_val - 1);
 
         return PSA_SUCCESS;
     }
@@ -141,7 +613,7 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
     psa_status_t status;
 
     if ((handle == TFM_CRYPTO_INVALID_HANDLE) ||
-        (handle > CRYPTO_CONC_OPER_NUM)) {
+        (handle > TFM_CRYPTO_OPER_TOTAL_NUM)) {
         return PSA_ERROR_BAD_STATE;
     }
 
@@ -157,10 +629,19 @@ psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
     if ((operations[handle - 1].in_use == TFM_CRYPTO_IN_USE) &&
         (operations[handle - 1].type == type) &&
         (operations[handle - 1].owner == partition_id)) {
-        *ctx = (void *) &(operations[handle - 1].operation);
+        *ctx = operations[handle - 1].ctx;
         return PSA_SUCCESS;
     }
 
     return PSA_ERROR_BAD_STATE;
 }
+
+void tfm_crypto_operation_get_stats(struct tfm_crypto_operation_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    (void)memcpy(stats, &oper_stats, sizeof(*stats));
+}
 /*!@}*/
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config_crypto.h"
+#include "tfm_mbedcrypto_include.h"
+
+#include "tfm_crypto_api.h"
+#include "mbedtls/platform.h"
+
+#if CRYPTO_ENGINE_POOL_ALLOC
+
+#if !defined(MBEDTLS_PLATFORM_MEMORY) || defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+#error "MBEDTLS_PLATFORM_MEMORY without calloc/free macros is required by the crypto engine pool"
+#endif
+
+/*
+ * The memory of the crypto engine is handed out in fixed size classes. Blocks
+ * are carved from the buffer on demand and never split or merged. A released
+ * block goes to the free list of its class, so allocation and release take
+ * constant time. The size classes grow by 1.5x or 1.33x, which covers the
+ * bignum limbs and the cipher, hash and key contexts of Mbed TLS with less
+ * than a third of each block wasted.
+ */
+static const uint16_t pool_class_size[TFM_CRYPTO_ENGINE_POOL_CLASS_NUM] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072,
+    4096
+};
+
+#define POOL_ALIGN                  8
+#define POOL_BLOCK_MAGIC            0xC5A3
+
+/* Kept in front of each block, so that the class is known on release */
+struct pool_block_hdr_t {
+    uint32_t size;                  /* Requested size, 0 if the block is free */
+    uint16_t magic;
+    uint8_t cls;
+    uint8_t reserved;
+};
+
+/* Overlaid on the payload of a free block */
+struct pool_free_block_t {
+    struct pool_free_block_t *next;
+};
+
+static uint8_t *pool_base;
+static size_t pool_len;
+static size_t pool_carved;          /* Bytes carved from the start of the pool */
+
+static struct pool_free_block_t *free_list[TFM_CRYPTO_ENGINE_POOL_CLASS_NUM];
+
+static struct tfm_crypto_engine_pool_stats_t pool_stats;
+
+static int32_t pool_class_of(size_t size)
+{
+    int32_t cls;
+
+    /* Bounded by the number of classes */
+    for (cls = 0; cls < TFM_CRYPTO_ENGINE_POOL_CLASS_NUM; cls++) {
+        if (size <= pool_class_size[cls]) {
+            return cls;
+        }
+    }
+
+    return -1;
+}
+
+static void *pool_calloc(size_t nmemb, size_t size)
+{
+    struct pool_block_hdr_t *hdr;
+    size_t total;
+    size_t block_len;
+    int32_t cls;
+
+    if ((nmemb == 0) || (size == 0) || (size > SIZE_MAX / nmemb)) {
+        return NULL;
+    }
+
+    total = nmemb * size;
+    cls = pool_class_of(total);
+    if (cls < 0) {
+        pool_stats.alloc_failures++;
+        return NULL;
+    }
+
+    if (free_list[cls] != NULL) {
+        hdr = (struct pool_block_hdr_t *)free_list[cls] - 1;
+        free_list[cls] = free_list[cls]->next;
+    } else {
+        block_len = sizeof(*hdr) + pool_class_size[cls];
+        if (pool_len - pool_carved < block_len) {
+            pool_stats.alloc_failures++;
+            return NULL;
+        }
+
+        hdr = (struct pool_block_hdr_t *)(pool_base + pool_carved);
+        hdr->magic = POOL_BLOCK_MAGIC;
+        hdr->cls = (uint8_t)cls;
+        hdr->reserved = 0;
+        pool_carved += block_len;
+
+        pool_stats.carved_bytes = pool_carved;
+        pool_stats.class_blocks[cls]++;
+    }
+
+    hdr->size = (uint32_t)total;
+
+    pool_stats.in_use_bytes += pool_class_size[cls];
+    pool_stats.requested_bytes += total;
+    if (pool_stats.in_use_bytes > pool_stats.peak_in_use_bytes) {
+        pool_stats.peak_in_use_bytes = pool_stats.in_use_bytes;
+    }
+    pool_stats.class_in_use[cls]++;
+    if (pool_stats.class_in_use[cls] > pool_stats.class_peak_in_use[cls]) {
+        pool_stats.class_peak_in_use[cls] = pool_stats.class_in_use[cls];
+    }
+
+    (void)memset(hdr + 1, 0, total);
+
+    return hdr + 1;
+}
+
+static void pool_free(void *ptr)
+{
+    struct pool_block_hdr_t *hdr;
+    struct pool_free_block_t *block = ptr;
+    uint8_t cls;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    /* Drop the pointers which are not live blocks of the pool */
+    if (((uint8_t *)ptr < pool_base + sizeof(*hdr)) ||
+        ((uint8_t *)ptr >= pool_base + pool_carved) ||
+        (((uintptr_t)ptr % POOL_ALIGN) != 0)) {
+        return;
+    }
+
+    hdr = (struct pool_block_hdr_t *)ptr - 1;
+    cls = hdr->cls;
+    if ((hdr->magic != POOL_BLOCK_MAGIC) || (hdr->size == 0) ||
+        (cls >= TFM_CRYPTO_ENGINE_POOL_CLASS_NUM)) {
+        return;
+    }
+
+    pool_stats.in_use_bytes -= pool_class_size[cls];
+    pool_stats.requested_bytes -= hdr->size;
+    pool_stats.class_in_use[cls]--;
+
+    hdr->size = 0;
+    block->next = free_list[cls];
+    free_list[cls] = block;
+}
+
+void tfm_crypto_engine_pool_init(uint8_t *buf, size_t len)
+{
+    size_t pad = (POOL_ALIGN - ((uintptr_t)buf % POOL_ALIGN)) % POOL_ALIGN;
+
+    (void)memset(free_list, 0, sizeof(free_list));
+    (void)memset(&pool_stats, 0, sizeof(pool_stats));
+
+    /* The payload follows an 8-byte header, so it is aligned as well */
+    pool_base = buf + pad;
+    pool_len = (len > pad) ? (len - pad) : 0;
+    pool_carved = 0;
+
+    pool_stats.total_bytes = pool_len;
+
+    (void)mbedtls_platform_set_calloc_free(pool_calloc, pool_free);
+}
+
+void tfm_crypto_engine_pool_get_stats(
+                                struct tfm_crypto_engine_pool_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    (void)memcpy(stats, &pool_stats, sizeof(*stats));
+}
+
+#endif /* CRYPTO_ENGINE_POOL_ALLOC */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -21,6 +21,14 @@
 
 /*!@{*/
 #if CRYPTO_HASH_MODULE_ENABLED
+static psa_status_t hash_update_chunk(void *operation,
+                                      const uint8_t *input,
+                                      size_t input_length)
+{
+    return psa_hash_update((psa_hash_operation_t *)operation,
+                           input, input_length);
+}
+
 psa_status_t tfm_crypto_hash_interface(psa_invec in_vec[],
                                        psa_outvec out_vec[])
 {
@@ -112,10 +120,8 @@ psa_status_t tfm_crypto_hash_interface(psa_invec in_vec[],
     break;
     case TFM_CRYPTO_HASH_UPDATE_SID:
     {
-        const uint8_t *input = in_vec[1].base;
-        size_t input_length = in_vec[1].len;
-
-        return psa_hash_update(operation, input, input_length);
+        return tfm_crypto_update_input(&in_vec[1], hash_update_chunk,
+                                       operation);
     }
     case TFM_CRYPTO_HASH_FINISH_SID:
     {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -15,11 +15,13 @@
 #include "crypto_check_config.h"
 #include "tfm_plat_crypto_keys.h"
 
+#if !CRYPTO_ENGINE_POOL_ALLOC
 /*
  * \brief This Mbed TLS include is needed to initialise the memory allocator
  *        of the library used for internal allocations
  */
 #include "mbedtls/memory_buffer_alloc.h"
+#endif
 
 #include "mbedtls/platform.h"
 
@@ -94,6 +96,14 @@ static psa_status_t tfm_crypto_init_iovecs(const psa_msg_t *msg,
 
     return PSA_SUCCESS;
 }
+
+psa_status_t tfm_crypto_update_input(const psa_invec *in,
+                                     tfm_crypto_update_fn_t update,
+                                     void *operation)
+{
+    /* The input is mapped as a whole */
+    return update(operation, in->base, in->len);
+}
 #else /* PSA_FRAMEWORK_HAS_MM_IOVEC == 1 */
 /**
  * \brief Internal scratch used for IOVec allocations
@@ -104,6 +114,8 @@ static struct tfm_crypto_scratch {
     uint8_t buf[CRYPTO_IOVEC_BUFFER_SIZE];
     uint32_t alloc_index;
     int32_t owner;
+    psa_handle_t handle;        /*!< Message of the streamed input */
+    uint32_t stream_idx;        /*!< Index of the streamed input, 0 if none */
 } scratch = {.buf = {0}, .alloc_index = 0};
 
 static psa_status_t tfm_crypto_set_scratch_owner(int32_t id)
@@ -139,10 +151,76 @@ static psa_status_t tfm_crypto_alloc_scratch(size_t requested_size, void **buf)
 static void tfm_crypto_clear_scratch(void)
 {
     scratch.owner = 0;
+    scratch.stream_idx = 0;
     (void)memset(scratch.buf, 0, scratch.alloc_index);
     scratch.alloc_index = 0;
 }
 
+/*
+ * Multipart hash and MAC updates can take large inputs. Their input is not
+ * copied into the scratch as a whole, but read in chunks through a window
+ * into the backend by tfm_crypto_update_input().
+ */
+static bool tfm_crypto_is_streamed_input(const struct tfm_crypto_pack_iovec *iov,
+                                         uint32_t idx)
+{
+    return (idx == 1) &&
+           ((iov->function_id == TFM_CRYPTO_HASH_UPDATE_SID) ||
+            (iov->function_id == TFM_CRYPTO_MAC_UPDATE_SID));
+}
+
+psa_status_t tfm_crypto_update_input(const psa_invec *in,
+                                     tfm_crypto_update_fn_t update,
+                                     void *operation)
+{
+    size_t remaining = in->len;
+    size_t window_size, chunk;
+    void *window = NULL;
+    psa_status_t status;
+
+    /* The input is already in the scratch */
+    if ((in->base != NULL) || (in->len == 0) || (scratch.stream_idx == 0)) {
+        return update(operation, in->base, in->len);
+    }
+
+    /* Take the free part of the scratch, no more than the input needs */
+    window_size = (sizeof(scratch.buf) - scratch.alloc_index) &
+                  ~((size_t)TFM_CRYPTO_IOVEC_ALIGNMENT - 1);
+    if (window_size > remaining) {
+        window_size = remaining;
+    }
+    if (window_size == 0) {
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    status = tfm_crypto_alloc_scratch(window_size, &window);
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+    /*
+     * The window is cleared with the rest of the scratch once the request is
+     * completed, rather than after each chunk.
+     */
+    while (remaining > 0) {
+        chunk = (remaining < window_size) ? remaining : window_size;
+
+        if (psa_read(scratch.handle, scratch.stream_idx, window, chunk) !=
+                                                                    chunk) {
+            return PSA_ERROR_GENERIC_ERROR;
+        }
+
+        status = update(operation, window, chunk);
+        if (status != PSA_SUCCESS) {
+            return status;
+        }
+
+        remaining -= chunk;
+    }
+
+    return PSA_SUCCESS;
+}
+
 static void tfm_crypto_set_caller_id(int32_t id)
 {
     /* Set the owner of the data in the scratch */
@@ -163,9 +241,19 @@ static psa_status_t tfm_crypto_init_iovecs(const psa_msg_t *msg,
     uint32_t i;
     void *alloc_buf_ptr = NULL;
     psa_status_t status;
+    const struct tfm_crypto_pack_iovec *iov = in_vec[0].base;
 
     /* Alloc/read from the second element as the first is read when parsing */
     for (i = 1; i < in_len; i++) {
+        if (tfm_crypto_is_streamed_input(iov, i)) {
+            /* Read later, when the backend consumes it */
+            scratch.handle = msg->handle;
+            scratch.stream_idx = i;
+            in_vec[i].base = NULL;
+            in_vec[i].len = msg->in_size[i];
+            continue;
+        }
+
         /* Allocate necessary space in the internal scratch */
         status = tfm_crypto_alloc_scratch(msg->in_size[i], &alloc_buf_ptr);
         if (status != PSA_SUCCESS) {
@@ -195,7 +283,138 @@ static psa_status_t tfm_crypto_init_iovecs(const psa_msg_t *msg,
 }
 #endif /* PSA_FRAMEWORK_HAS_MM_IOVEC == 1 */
 
-static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
+#if CRYPTO_PROFILING_ENABLED
+#ifndef CRYPTO_PROFILING_TIMESTAMP
+#error "CRYPTO_PROFILING_TIMESTAMP() must be defined by the platform to enable crypto profiling"
+#endif
+
+static struct tfm_crypto_profiling_stats_t
+                                    profiling_stats[TFM_CRYPTO_GROUP_ID_NUM];
+
+/*
+ * The timestamps of the request being handled. The function ID is only known
+ * once the request is parsed, a request failing before is not recorded.
+ */
+static struct {
+    bool is_parsed;
+    uint16_t function_id;
+    uint32_t backend_start;
+    uint32_t backend_end;
+} profiling_req;
+
+static void tfm_crypto_profiling_record(uint32_t req_start,
+                                        psa_status_t status)
+{
+    enum tfm_crypto_group_id group_id;
+    struct tfm_crypto_profiling_stats_t *stats;
+    uint32_t backend_cycles;
+
+    if (!profiling_req.is_parsed) {
+        return;
+    }
+
+    group_id = TFM_CRYPTO_GET_GROUP_ID(profiling_req.function_id);
+    if ((uint32_t)group_id >= TFM_CRYPTO_GROUP_ID_NUM) {
+        return;
+    }
+
+    /* A request failing before the backend spends no time in the backend */
+    backend_cycles = profiling_req.backend_end - profiling_req.backend_start;
+
+    /* The counter is free-running, so a wrapped-around value still works */
+    stats = &profiling_stats[group_id];
+    stats->calls++;
+    if (status != PSA_SUCCESS) {
+        stats->errors++;
+    }
+    stats->total_cycles += (uint32_t)CRYPTO_PROFILING_TIMESTAMP() - req_start;
+    stats->backend_cycles += backend_cycles;
+    if (backend_cycles > stats->max_backend_cycles) {
+        stats->max_backend_cycles = backend_cycles;
+    }
+}
+#endif /* CRYPTO_PROFILING_ENABLED */
+
+void tfm_crypto_profiling_get_stats(struct tfm_crypto_profiling_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+#if CRYPTO_PROFILING_ENABLED
+    (void)memcpy(stats, profiling_stats, sizeof(profiling_stats));
+#else
+    (void)memset(stats, 0, sizeof(*stats) * TFM_CRYPTO_GROUP_ID_NUM);
+#endif
+}
+
+void tfm_crypto_stats_report(void)
+{
+    struct tfm_crypto_operation_stats_t oper_stats;
+#if CRYPTO_ENGINE_POOL_ALLOC
+    struct tfm_crypto_engine_pool_stats_t pool_stats;
+#endif
+#if CRYPTO_KEY_CACHE_NUM > 0
+    struct tfm_crypto_key_cache_stats_t key_cache_stats;
+#endif
+#if CRYPTO_PROFILING_ENABLED
+    struct tfm_crypto_profiling_stats_t group_stats[TFM_CRYPTO_GROUP_ID_NUM];
+    uint32_t i, calls;
+#endif
+
+    tfm_crypto_operation_get_stats(&oper_stats);
+    LOG_INFFMT("[INF][Crypto] operations: %u/%u in use, %u by NS, peak %u\r\n",
+               oper_stats.in_use, oper_stats.total, oper_stats.in_use_ns,
+               oper_stats.peak_in_use);
+    LOG_INFFMT("[INF][Crypto] operations: %u failures, %u rejected, "
+               "%u reclaimed\r\n",
+               oper_stats.alloc_failures, oper_stats.quota_rejects,
+               oper_stats.reclaimed);
+
+#if CRYPTO_ENGINE_POOL_ALLOC
+    tfm_crypto_engine_pool_get_stats(&pool_stats);
+    LOG_INFFMT("[INF][Crypto] engine pool: %u/%u bytes carved, %u in use, "
+               "peak %u\r\n",
+               pool_stats.carved_bytes, pool_stats.total_bytes,
+               pool_stats.in_use_bytes, pool_stats.peak_in_use_bytes);
+    LOG_INFFMT("[INF][Crypto] engine pool: %u bytes requested, %u failures\r\n",
+               pool_stats.requested_bytes, pool_stats.alloc_failures);
+#endif
+
+#if CRYPTO_KEY_CACHE_NUM > 0
+    tfm_crypto_key_cache_get_stats(&key_cache_stats);
+    LOG_INFFMT("[INF][Crypto] key cache: %u hits, %u ITS get, "
+               "%u ITS get info, %u evictions\r\n",
+               key_cache_stats.hits, key_cache_stats.its_get,
+               key_cache_stats.its_get_info, key_cache_stats.evictions);
+#endif
+
+#if CRYPTO_PROFILING_ENABLED
+    tfm_crypto_profiling_get_stats(group_stats);
+    (void)memset(profiling_stats, 0, sizeof(profiling_stats));
+
+    for (i = 0; i < TFM_CRYPTO_GROUP_ID_NUM; i++) {
+        calls = group_stats[i].calls;
+        if (calls == 0) {
+            continue;
+        }
+
+        /* Average cycles of a request: whole request, backend, max backend */
+        LOG_INFFMT("[INF][Crypto] group %u: %u calls, %u errors, "
+                   "%u/%u/%u cycles\r\n",
+                   i, calls, group_stats[i].errors,
+                   (uint32_t)(group_stats[i].total_cycles / calls),
+                   (uint32_t)(group_stats[i].backend_cycles / calls),
+                   group_stats[i].max_backend_cycles);
+    }
+#endif /* CRYPTO_PROFILING_ENABLED */
+}
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+static uint32_t stats_nr_calls;
+#endif
+
+static psa_status_t tfm_crypto_handle_req(const psa_msg_t *msg)
 {
     psa_status_t status = PSA_SUCCESS;
     size_t in_len = PSA_MAX_IOVEC, out_len = PSA_MAX_IOVEC, i;
@@ -226,6 +445,13 @@ static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
     in_vec[0].base = &iov;
     in_vec[0].len = sizeof(struct tfm_crypto_pack_iovec);
 
+#if CRYPTO_PROFILING_ENABLED
+    profiling_req.is_parsed = true;
+    profiling_req.function_id = iov.function_id;
+    profiling_req.backend_start = (uint32_t)CRYPTO_PROFILING_TIMESTAMP();
+    profiling_req.backend_end = profiling_req.backend_start;
+#endif
+
     status = tfm_crypto_init_iovecs(msg, in_vec, in_len, out_vec, out_len);
     if (status != PSA_SUCCESS) {
         return status;
@@ -233,9 +459,17 @@ static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
 
     tfm_crypto_set_caller_id(msg->client_id);
 
+#if CRYPTO_PROFILING_ENABLED
+    profiling_req.backend_start = (uint32_t)CRYPTO_PROFILING_TIMESTAMP();
+#endif
+
     /* Call the dispatcher to the functions that implement the PSA Crypto API */
     status = tfm_crypto_api_dispatcher(in_vec, in_len, out_vec, out_len);
 
+#if CRYPTO_PROFILING_ENABLED
+    profiling_req.backend_end = (uint32_t)CRYPTO_PROFILING_TIMESTAMP();
+#endif
+
 #if PSA_FRAMEWORK_HAS_MM_IOVEC == 1
     for (i = 0; i < out_len; i++) {
         if (out_vec[i].base != NULL) {
@@ -255,6 +489,36 @@ static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
     return status;
 }
 
+static psa_status_t tfm_crypto_call_srv(const psa_msg_t *msg)
+{
+    psa_status_t status;
+#if CRYPTO_PROFILING_ENABLED
+    uint32_t req_start;
+#endif
+
+#if CRYPTO_STATS_REPORT_INTERVAL > 0
+    /* Printed before the request is timed, so the report is not profiled */
+    if (++stats_nr_calls >= CRYPTO_STATS_REPORT_INTERVAL) {
+        stats_nr_calls = 0;
+        tfm_crypto_stats_report();
+    }
+#endif
+
+#if CRYPTO_PROFILING_ENABLED
+    profiling_req.is_parsed = false;
+    req_start = (uint32_t)CRYPTO_PROFILING_TIMESTAMP();
+#endif
+
+    status = tfm_crypto_handle_req(msg);
+
+#if CRYPTO_PROFILING_ENABLED
+    /* Failed requests are recorded too, their time is spent all the same */
+    tfm_crypto_profiling_record(req_start, status);
+#endif
+
+    return status;
+}
+
 /**
  * \brief Static buffer to be used by Mbed Crypto for memory allocations
  *
@@ -263,6 +527,8 @@ static uint8_t mbedtls_mem_buf[CRYPTO_ENGINE_BUF_SIZE] = {0};
 
 static psa_status_t tfm_crypto_engine_init(void)
 {
+    psa_status_t status;
+
 #if CRYPTO_NV_SEED
     LOG_INFFMT("[INF][Crypto] ");
     LOG_INFFMT("Provisioning entropy seed... ");
@@ -275,8 +541,12 @@ static psa_status_t tfm_crypto_engine_init(void)
     /* Initialise the Mbed Crypto memory allocator to use static memory
      * allocation from the provided buffer instead of using the heap
      */
+#if CRYPTO_ENGINE_POOL_ALLOC
+    tfm_crypto_engine_pool_init(mbedtls_mem_buf, CRYPTO_ENGINE_BUF_SIZE);
+#else
     mbedtls_memory_buffer_alloc_init(mbedtls_mem_buf,
                                      CRYPTO_ENGINE_BUF_SIZE);
+#endif
 
     /* mbedtls_printf is used to print messages including error information. */
 #if (TFM_PARTITION_LOG_LEVEL >= TFM_PARTITION_LOG_LEVEL_ERROR)
@@ -300,7 +570,16 @@ static psa_status_t tfm_crypto_engine_init(void)
      * library. If a driver is built using the PSA Driver interface, the function
      * below will perform also the same operations as crypto_hw_accelerator_init()
      */
-    return psa_crypto_init();
+    status = psa_crypto_init();
+    if (status != PSA_SUCCESS) {
+        return status;
+    }
+
+#if CRYPTO_KEY_CACHE_NUM > 0
+    tfm_crypto_key_cache_init();
+#endif
+
+    return PSA_SUCCESS;
 }
 
 static psa_status_t tfm_crypto_module_init(void)
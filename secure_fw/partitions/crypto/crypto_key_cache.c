@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * This file is only built into Mbed TLS when CRYPTO_KEY_CACHE_NUM is not 0, and
+ * Mbed TLS is then built with its ITS calls renamed to the functions below, so
+ * the real ITS API must be visible in this file.
+ */
+#undef psa_its_get
+#undef psa_its_get_info
+#undef psa_its_set
+#undef psa_its_remove
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config_crypto.h"
+#include "tfm_mbedcrypto_include.h"
+
+#include "tfm_crypto_api.h"
+#include "psa/internal_trusted_storage.h"
+
+#if CRYPTO_KEY_CACHE_NUM == 0
+#error "The key cache is built with CRYPTO_KEY_CACHE_NUM of 0"
+#endif
+
+/*
+ * Mbed TLS evicts persistent keys from its key slots when they run short, and
+ * reloads them from ITS on the next use. The records of the persistent keys
+ * are kept here, so that reloading a key does not take a request to ITS.
+ * Pinned keys are read at init and never evicted. The other records are
+ * replaced in least recently used order.
+ */
+
+/* Mbed TLS stores a key in the ITS file of UID (owner << 32 | key ID) */
+#define KEY_CACHE_UID(owner, key_id) \
+    (((psa_storage_uid_t)(uint32_t)(owner) << 32) | (uint32_t)(key_id))
+
+/* The UIDs below this are not key records */
+#define KEY_CACHE_MIN_UID            KEY_CACHE_UID(1, 0)
+
+static struct tfm_crypto_key_cache_stats_t key_cache_stats;
+
+struct key_cache_entry_t {
+    psa_storage_uid_t uid;
+    struct psa_storage_info_t info;     /* As returned by ITS */
+    size_t len;
+    uint32_t last_use;                  /* Larger is more recently used */
+    bool is_valid;
+    bool is_pinned;
+    uint8_t data[CRYPTO_KEY_CACHE_RECORD_SIZE];
+};
+
+struct key_cache_pinned_key_t {
+    int32_t owner;
+    uint32_t key_id;
+};
+
+#ifdef CRYPTO_KEY_CACHE_PINNED_KEYS
+static const struct key_cache_pinned_key_t pinned_keys[] = {
+    CRYPTO_KEY_CACHE_PINNED_KEYS
+};
+#endif
+
+static struct key_cache_entry_t key_cache[CRYPTO_KEY_CACHE_NUM];
+static uint32_t key_cache_use_count;
+
+static bool key_cache_is_pinned_uid(psa_storage_uid_t uid)
+{
+#ifdef CRYPTO_KEY_CACHE_PINNED_KEYS
+    size_t i;
+
+    for (i = 0; i < sizeof(pinned_keys) / sizeof(pinned_keys[0]); i++) {
+        if (uid == KEY_CACHE_UID(pinned_keys[i].owner, pinned_keys[i].key_id)) {
+            return true;
+        }
+    }
+#else
+    (void)uid;
+#endif
+
+    return false;
+}
+
+static struct key_cache_entry_t *key_cache_lookup(psa_storage_uid_t uid)
+{
+    uint32_t i;
+
+    for (i = 0; i < CRYPTO_KEY_CACHE_NUM; i++) {
+        if (key_cache[i].is_valid && (key_cache[i].uid == uid)) {
+            key_cache[i].last_use = ++key_cache_use_count;
+            return &key_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void key_cache_invalidate(struct key_cache_entry_t *entry)
+{
+    volatile uint8_t *p = entry->data;
+    size_t i;
+
+    /* The record holds key material */
+    for (i = 0; i < sizeof(entry->data); i++) {
+        p[i] = 0;
+    }
+    entry->is_valid = false;
+}
+
+/*
+ * Read the information of a record from ITS, and the record itself into the
+ * cache if it fits. \p p_entry is NULL if the record is not cached.
+ */
+static psa_status_t key_cache_fill(psa_storage_uid_t uid,
+                                   struct psa_storage_info_t *p_info,
+                                   struct key_cache_entry_t **p_entry)
+{
+    struct key_cache_entry_t *entry = NULL;
+    psa_status_t status;
+    uint32_t i;
+
+    *p_entry = NULL;
+
+    key_cache_stats.its_get_info++;
+    status = psa_its_get_info(uid, p_info);
+    if ((status != PSA_SUCCESS) ||
+        (p_info->size > CRYPTO_KEY_CACHE_RECORD_SIZE)) {
+        return status;
+    }
+
+    /* Prefer an unused entry, then the least recently used unpinned one */
+    for (i = 0; i < CRYPTO_KEY_CACHE_NUM; i++) {
+        if (!key_cache[i].is_valid) {
+            entry = &key_cache[i];
+            break;
+        }
+        if (!key_cache[i].is_pinned &&
+            ((entry == NULL) || (key_cache[i].last_use < entry->last_use))) {
+            entry = &key_cache[i];
+        }
+    }
+
+    if (entry == NULL) {
+        return PSA_SUCCESS;
+    }
+
+    if (entry->is_valid) {
+        key_cache_stats.evictions++;
+        key_cache_invalidate(entry);
+    }
+
+    key_cache_stats.its_get++;
+    status = psa_its_get(uid, 0, p_info->size, entry->data, &entry->len);
+    if (status != PSA_SUCCESS) {
+        key_cache_invalidate(entry);
+        return status;
+    }
+
+    entry->uid = uid;
+    entry->info = *p_info;
+    entry->last_use = ++key_cache_use_count;
+    entry->is_pinned = key_cache_is_pinned_uid(uid);
+    entry->is_valid = true;
+    *p_entry = entry;
+
+    return PSA_SUCCESS;
+}
+
+static void key_cache_drop(psa_storage_uid_t uid)
+{
+    struct key_cache_entry_t *entry = key_cache_lookup(uid);
+
+    if (entry != NULL) {
+        key_cache_invalidate(entry);
+    }
+}
+
+psa_status_t tfm_crypto_its_get_info(psa_storage_uid_t uid,
+                                     struct psa_storage_info_t *p_info)
+{
+    struct key_cache_entry_t *entry;
+
+    /*
+     * Mbed TLS gets the information of a key record before reading it, so
+     * the record is cached here
+     */
+    if (uid >= KEY_CACHE_MIN_UID) {
+        entry = key_cache_lookup(uid);
+        if (entry != NULL) {
+            key_cache_stats.hits++;
+            *p_info = entry->info;
+            return PSA_SUCCESS;
+        }
+
+        return key_cache_fill(uid, p_info, &entry);
+    }
+
+    key_cache_stats.its_get_info++;
+
+    return psa_its_get_info(uid, p_info);
+}
+
+psa_status_t tfm_crypto_its_get(psa_storage_uid_t uid,
+                                size_t data_offset,
+                                size_t data_size,
+                                void *p_data,
+                                size_t *p_data_length)
+{
+    struct key_cache_entry_t *entry = NULL;
+
+    if (uid >= KEY_CACHE_MIN_UID) {
+        entry = key_cache_lookup(uid);
+    }
+
+    /* The other cases, including the invalid arguments, are left to ITS */
+    if ((entry != NULL) && (data_offset <= entry->len) &&
+        (data_size <= entry->len - data_offset)) {
+        key_cache_stats.hits++;
+        (void)memcpy(p_data, &entry->data[data_offset], data_size);
+        *p_data_length = data_size;
+        return PSA_SUCCESS;
+    }
+
+    key_cache_stats.its_get++;
+
+    return psa_its_get(uid, data_offset, data_size, p_data, p_data_length);
+}
+
+psa_status_t tfm_crypto_its_set(psa_storage_uid_t uid,
+                                size_t data_length,
+                                const void *p_data,
+                                psa_storage_create_flags_t create_flags)
+{
+    key_cache_drop(uid);
+
+    return psa_its_set(uid, data_length, p_data, create_flags);
+}
+
+psa_status_t tfm_crypto_its_remove(psa_storage_uid_t uid)
+{
+    key_cache_drop(uid);
+
+    return psa_its_remove(uid);
+}
+
+void tfm_crypto_key_cache_init(void)
+{
+#ifdef CRYPTO_KEY_CACHE_PINNED_KEYS
+    struct psa_storage_info_t info;
+    struct key_cache_entry_t *entry;
+#endif
+    uint32_t i;
+
+    for (i = 0; i < CRYPTO_KEY_CACHE_NUM; i++) {
+        key_cache_invalidate(&key_cache[i]);
+    }
+    key_cache_use_count = 0;
+
+#ifdef CRYPTO_KEY_CACHE_PINNED_KEYS
+    /* The keys which have not been created yet are cached on first use */
+    for (i = 0; i < sizeof(pinned_keys) / sizeof(pinned_keys[0]); i++) {
+        (void)key_cache_fill(KEY_CACHE_UID(pinned_keys[i].owner,
+                                           pinned_keys[i].key_id),
+                             &info, &entry);
+    }
+#endif
+}
+
+void tfm_crypto_key_cache_get_stats(struct tfm_crypto_key_cache_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    (void)memcpy(stats, &key_cache_stats, sizeof(*stats));
+}
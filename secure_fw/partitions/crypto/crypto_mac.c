@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -21,6 +21,14 @@
 
 /*!@{*/
 #if CRYPTO_MAC_MODULE_ENABLED
+static psa_status_t mac_update_chunk(void *operation,
+                                     const uint8_t *input,
+                                     size_t input_length)
+{
+    return psa_mac_update((psa_mac_operation_t *)operation,
+                          input, input_length);
+}
+
 psa_status_t tfm_crypto_mac_interface(psa_invec in_vec[],
                                       psa_outvec out_vec[],
                                       mbedtls_svc_key_id_t *encoded_key)
@@ -122,10 +130,8 @@ psa_status_t tfm_crypto_mac_interface(psa_invec in_vec[],
     break;
     case TFM_CRYPTO_MAC_UPDATE_SID:
     {
-        const uint8_t *input = in_vec[1].base;
-        size_t input_length = in_vec[1].len;
-
-        return psa_mac_update(operation, input, input_length);
+        return tfm_crypto_update_input(&in_vec[1], mac_update_chunk,
+                                       operation);
     }
     case TFM_CRYPTO_MAC_SIGN_FINISH_SID:
     {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -7,6 +7,7 @@
 
 #include "tfm_builtin_key_loader.h"
 
+#include "config_crypto.h"
 #include "psa/error.h"
 #include "tfm_mbedcrypto_include.h"
 #include "tfm_crypto_defs.h"
@@ -34,6 +35,84 @@ struct tfm_builtin_key_t {
 
 static struct tfm_builtin_key_t builtin_key_slots[TFM_BUILTIN_MAX_KEYS] = {0};
 
+#if TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0
+struct tfm_builtin_derived_key_t {
+    uint8_t key[TFM_BUILTIN_MAX_KEY_LEN];
+    size_t key_len;
+    mbedtls_key_owner_id_t owner;
+    psa_drv_slot_number_t slot_number;
+    uint32_t last_use;              /* Larger is more recently used */
+    uint32_t is_valid;
+};
+
+static struct tfm_builtin_derived_key_t
+                    derived_key_cache[TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE] = {0};
+static uint32_t derived_key_use_count;
+
+static struct tfm_builtin_derived_key_t *derived_key_cache_lookup(
+        psa_drv_slot_number_t slot_number, mbedtls_key_owner_id_t owner,
+        size_t key_len)
+{
+    uint32_t i;
+
+    for (i = 0; i < TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE; i++) {
+        if (derived_key_cache[i].is_valid &&
+            (derived_key_cache[i].slot_number == slot_number) &&
+            (derived_key_cache[i].owner == owner) &&
+            (derived_key_cache[i].key_len == key_len)) {
+            derived_key_cache[i].last_use = ++derived_key_use_count;
+            return &derived_key_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void derived_key_cache_insert(psa_drv_slot_number_t slot_number,
+                                     mbedtls_key_owner_id_t owner,
+                                     const uint8_t *key, size_t key_len)
+{
+    struct tfm_builtin_derived_key_t *entry = &derived_key_cache[0];
+    uint32_t i;
+
+    if (key_len > TFM_BUILTIN_MAX_KEY_LEN) {
+        return;
+    }
+
+    /* Replace an unused entry, or the least recently used one */
+    for (i = 0; i < TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE; i++) {
+        if (!derived_key_cache[i].is_valid) {
+            entry = &derived_key_cache[i];
+            break;
+        }
+        if (derived_key_cache[i].last_use < entry->last_use) {
+            entry = &derived_key_cache[i];
+        }
+    }
+
+    memcpy(entry->key, key, key_len);
+    entry->key_len = key_len;
+    entry->owner = owner;
+    entry->slot_number = slot_number;
+    entry->last_use = ++derived_key_use_count;
+    entry->is_valid = 1;
+}
+#endif /* TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0 */
+
+void tfm_builtin_key_loader_flush_derived_keys(void)
+{
+#if TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0
+    volatile uint8_t *p = (volatile uint8_t *)derived_key_cache;
+    size_t i;
+
+    /* Zeroise through a volatile pointer so that it is not optimized out */
+    for (i = 0; i < sizeof(derived_key_cache); i++) {
+        p[i] = 0;
+    }
+    derived_key_use_count = 0;
+#endif /* TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0 */
+}
+
 psa_status_t tfm_builtin_key_loader_load_key(uint8_t *buf, size_t key_len,
                                              psa_key_attributes_t *attr)
 {
@@ -60,6 +139,9 @@ psa_status_t tfm_builtin_key_loader_load_key(uint8_t *buf, size_t key_len,
         return err;
     }
 
+    /* The subkeys derived from the previous key material are stale */
+    tfm_builtin_key_loader_flush_derived_keys();
+
     memcpy(&(builtin_key_slots[slot_number].attr), attr,
            sizeof(psa_key_attributes_t));
     memcpy(&(builtin_key_slots[slot_number].key), buf, key_len);
@@ -115,6 +197,9 @@ static psa_status_t derive_subkey_into_buffer(
         uint8_t *key_buffer, size_t key_buffer_size, size_t *key_buffer_length)
 {
     int mbedtls_err;
+#if TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0
+    struct tfm_builtin_derived_key_t *cached;
+#endif
 
 #ifdef TFM_PARTITION_TEST_PS
     /* Hack to allow the PS tests to work, since they directly call
@@ -126,6 +211,17 @@ static psa_status_t derive_subkey_into_buffer(
     }
 #endif /* TFM_PARTITION_TEST_PS */
 
+#if TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0
+    /* The subkey only depends on the builtin key, the owner and the length */
+    cached = derived_key_cache_lookup(key_slot - builtin_key_slots, owner,
+                                      key_buffer_size);
+    if (cached != NULL) {
+        memcpy(key_buffer, cached->key, key_buffer_size);
+        *key_buffer_length = key_buffer_size;
+        return PSA_SUCCESS;
+    }
+#endif /* TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0 */
+
     /* FIXME this should be moved to using the PSA APIs once key derivation is
      * implemented in the PSA driver wrapper. Using the external PSA apis
      * directly creates a keyslot and we'd need to read the data from it and
@@ -141,6 +237,11 @@ static psa_status_t derive_subkey_into_buffer(
         return PSA_ERROR_GENERIC_ERROR;
     }
 
+#if TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0
+    derived_key_cache_insert(key_slot - builtin_key_slots, owner, key_buffer,
+                             key_buffer_size);
+#endif /* TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE > 0 */
+
     *key_buffer_length = key_buffer_size;
 
     return PSA_SUCCESS;
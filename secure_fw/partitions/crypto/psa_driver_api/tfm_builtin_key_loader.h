@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -73,6 +73,19 @@ psa_status_t tfm_builtin_key_loader_get_key_buffer(
         psa_drv_slot_number_t slot_number, psa_key_attributes_t *attributes,
         uint8_t *key_buffer, size_t key_buffer_size, size_t *key_buffer_length);
 
+/**
+ * \brief Zeroises the cached subkeys derived from the builtin keys.
+ *
+ * \note The subkeys are derived per owner and cached for reuse, see
+ *       TFM_BUILTIN_DERIVED_KEY_CACHE_SIZE. The cache is flushed whenever a
+ *       key is loaded. The PSA RoT lifecycle state is only changed by the
+ *       provisioning at boot, before the Crypto partition runs, or across a
+ *       reset. A platform which changes the lifecycle state at runtime must
+ *       call this function at the transition, so that no subkey derived in
+ *       the previous state is served.
+ */
+void tfm_builtin_key_loader_flush_derived_keys(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -90,6 +90,95 @@ psa_status_t tfm_crypto_key_attributes_to_client(
                         const psa_key_attributes_t *key_attributes,
                         struct psa_client_key_attributes_s *client_key_attr);
 
+/**
+ * \brief Type of the backend functions which add input to a multipart
+ *        operation, such as psa_hash_update()
+ */
+typedef psa_status_t (*tfm_crypto_update_fn_t)(void *operation,
+                                               const uint8_t *input,
+                                               size_t input_length);
+
+/**
+ * \brief Occupancy statistics of the operation contexts in the backend
+ */
+struct tfm_crypto_operation_stats_t {
+    uint32_t total;           /*!< Number of the contexts */
+    uint32_t in_use;          /*!< Number of the contexts in use */
+    uint32_t in_use_ns;       /*!< Number of the contexts in use by
+                               *   non-secure clients
+                               */
+    uint32_t peak_in_use;     /*!< Max number of the contexts in use */
+    uint32_t alloc_failures;  /*!< Number of the failed allocations */
+    uint32_t quota_rejects;   /*!< Number of the allocations rejected by the
+                               *   per-client or the reserved quota
+                               */
+    uint32_t reclaimed;       /*!< Number of the contexts reclaimed from the
+                               *   released non-secure clients
+                               */
+};
+
+/*
+ * Number of the size classes of the crypto engine pool, which is used when
+ * CRYPTO_ENGINE_POOL_ALLOC is enabled
+ */
+#define TFM_CRYPTO_ENGINE_POOL_CLASS_NUM    16
+
+/**
+ * \brief Usage statistics of the crypto engine pool. The blocks carved for a
+ *        class can only be reused by that class, so the free space left for
+ *        new blocks is (total_bytes - carved_bytes). The internal
+ *        fragmentation is (in_use_bytes - requested_bytes).
+ */
+struct tfm_crypto_engine_pool_stats_t {
+    uint32_t total_bytes;        /*!< Size of the pool */
+    uint32_t carved_bytes;       /*!< High-water mark of the pool, including
+                                  *   the block headers
+                                  */
+    uint32_t in_use_bytes;       /*!< Size of the blocks in use */
+    uint32_t peak_in_use_bytes;  /*!< Max size of the blocks in use */
+    uint32_t requested_bytes;    /*!< Size requested by the blocks in use */
+    uint32_t alloc_failures;     /*!< Number of the failed allocations */
+    uint16_t class_blocks[TFM_CRYPTO_ENGINE_POOL_CLASS_NUM];
+                                 /*!< Number of the blocks of each class */
+    uint16_t class_in_use[TFM_CRYPTO_ENGINE_POOL_CLASS_NUM];
+                                 /*!< Number of the blocks in use of each
+                                  *   class
+                                  */
+    uint16_t class_peak_in_use[TFM_CRYPTO_ENGINE_POOL_CLASS_NUM];
+                                 /*!< Max number of the blocks in use of each
+                                  *   class
+                                  */
+};
+
+/* Number of the groups of functions, as in \ref tfm_crypto_group_id */
+#define TFM_CRYPTO_GROUP_ID_NUM     (TFM_CRYPTO_GROUP_ID_KEY_DERIVATION + 1)
+
+/**
+ * \brief Time spent by the service in a group of functions, in the unit of
+ *        CRYPTO_PROFILING_TIMESTAMP(). The time of the whole request includes
+ *        the parsing of the message and the copy of the IOVECs, so the time
+ *        spent by SPM and the transport is what the client measures minus
+ *        \ref total_cycles.
+ */
+struct tfm_crypto_profiling_stats_t {
+    uint32_t calls;                 /*!< Number of the requests */
+    uint32_t errors;                /*!< Number of the requests failed */
+    uint64_t total_cycles;          /*!< Time of the whole requests */
+    uint64_t backend_cycles;        /*!< Time spent in the backend */
+    uint32_t max_backend_cycles;    /*!< Max time of a request in the backend */
+};
+
+/**
+ * \brief Statistics of the cache of the persistent key records. The requests
+ *        to ITS counted here include the ones made to fill the cache.
+ */
+struct tfm_crypto_key_cache_stats_t {
+    uint32_t its_get_info;          /*!< Number of the psa_its_get_info() */
+    uint32_t its_get;               /*!< Number of the psa_its_get() */
+    uint32_t hits;                  /*!< Number of the reads from the cache */
+    uint32_t evictions;             /*!< Number of the records evicted */
+};
+
 /**
  * \brief Allocate an operation context in the backend
  *
@@ -123,6 +212,67 @@ psa_status_t tfm_crypto_operation_release(uint32_t *handle);
 psa_status_t tfm_crypto_operation_lookup(enum tfm_crypto_operation_type type,
                                          uint32_t handle,
                                          void **ctx);
+/**
+ * \brief Add an input vector to a multipart operation in the backend.
+ *        An input which is not copied into the service beforehand is read in
+ *        chunks and each chunk is passed to \p update.
+ *
+ * \param[in] in        The input vector
+ * \param[in] update    Backend function which adds input to the operation
+ * \param[in] operation The operation context
+ *
+ * \return Return values as described in \ref psa_status_t
+ */
+psa_status_t tfm_crypto_update_input(const psa_invec *in,
+                                     tfm_crypto_update_fn_t update,
+                                     void *operation);
+/**
+ * \brief Get the occupancy statistics of the operation contexts
+ *
+ * \param[out] stats Buffer to hold the statistics
+ */
+void tfm_crypto_operation_get_stats(struct tfm_crypto_operation_stats_t *stats);
+/**
+ * \brief Initialise the crypto engine pool on a buffer and install it as the
+ *        allocator of Mbed TLS
+ *
+ * \param[in] buf Buffer of the pool
+ * \param[in] len Size of the buffer
+ */
+void tfm_crypto_engine_pool_init(uint8_t *buf, size_t len);
+/**
+ * \brief Get the usage statistics of the crypto engine pool
+ *
+ * \param[out] stats Buffer to hold the statistics
+ */
+void tfm_crypto_engine_pool_get_stats(
+                                struct tfm_crypto_engine_pool_stats_t *stats);
+/**
+ * \brief Get the profiling statistics of each group of functions, when
+ *        CRYPTO_PROFILING_ENABLED is set
+ *
+ * \param[out] stats Array of TFM_CRYPTO_GROUP_ID_NUM elements, indexed by
+ *                   \ref tfm_crypto_group_id
+ */
+void tfm_crypto_profiling_get_stats(struct tfm_crypto_profiling_stats_t *stats);
+/**
+ * \brief Print the statistics of the operation contexts, of the crypto engine
+ *        pool, of the key cache and the profiling statistics, for the ones
+ *        enabled. The profiling statistics are cleared.
+ */
+void tfm_crypto_stats_report(void);
+/**
+ * \brief Initialise the cache of the persistent key records and read the
+ *        pinned keys into it. It is called after psa_crypto_init(). The
+ *        cache is only built when CRYPTO_KEY_CACHE_NUM is not 0.
+ */
+void tfm_crypto_key_cache_init(void);
+/**
+ * \brief Get the statistics of the cache of the persistent key records
+ *
+ * \param[out] stats Buffer to hold the statistics
+ */
+void tfm_crypto_key_cache_get_stats(struct tfm_crypto_key_cache_stats_t *stats);
 
 /**
  * \brief This function acts as interface from the framework dispatching
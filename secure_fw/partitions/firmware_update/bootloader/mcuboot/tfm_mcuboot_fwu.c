@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -29,6 +29,7 @@
                                       SHARED_DATA_ENTRY_HEADER_SIZE)
 #endif
 
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY != 1
 /*
  * \struct fwu_image_info_data
  *
@@ -41,6 +42,7 @@ typedef struct fwu_image_info_data_s {
     struct shared_data_tlv_header header;
     uint8_t data[MAX_IMAGE_INFO_LENGTH];
 } fwu_image_info_data_t;
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY != 1 */
 
 typedef struct tfm_fwu_mcuboot_ctx_s {
     /* The flash area corresponding to component. */
@@ -51,32 +53,61 @@ typedef struct tfm_fwu_mcuboot_ctx_s {
 } tfm_fwu_mcuboot_ctx_t;
 
 static tfm_fwu_mcuboot_ctx_t mcuboot_ctx[FWU_COMPONENT_NUMBER];
+
+/* The TLV entries of the image information received from the bootloader */
+static const uint8_t *boot_shared_tlv;
+static uint32_t boot_shared_tlv_len;
+
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+static int fwu_bootloader_get_shared_data(void)
+{
+    /* Read the image information in place in the shared data area */
+    return tfm_core_map_boot_data(TLV_MAJOR_FWU, &boot_shared_tlv,
+                                  &boot_shared_tlv_len);
+}
+#else
 static fwu_image_info_data_t __attribute__((aligned(4))) boot_shared_data;
 
 static int fwu_bootloader_get_shared_data(void)
 {
-    return tfm_core_get_boot_data(TLV_MAJOR_FWU,
-                                  (struct tfm_boot_data *)&boot_shared_data,
-                                  sizeof(boot_shared_data));
+    int32_t ret;
+
+    ret = tfm_core_get_boot_data(TLV_MAJOR_FWU,
+                                 (struct tfm_boot_data *)&boot_shared_data,
+                                 sizeof(boot_shared_data));
+    if (ret != (int32_t)TFM_SUCCESS) {
+        return ret;
+    }
+
+    /* A corrupted header is reported when the image version is read */
+    if ((boot_shared_data.header.tlv_magic == SHARED_DATA_TLV_INFO_MAGIC) &&
+        (boot_shared_data.header.tlv_tot_len >= SHARED_DATA_HEADER_SIZE) &&
+        (boot_shared_data.header.tlv_tot_len <= sizeof(boot_shared_data))) {
+        boot_shared_tlv = boot_shared_data.data;
+        boot_shared_tlv_len = boot_shared_data.header.tlv_tot_len -
+                              SHARED_DATA_HEADER_SIZE;
+    }
+
+    return ret;
 }
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
 
 static psa_status_t get_active_image_version(psa_fwu_component_t component,
                                              struct image_version *image_ver)
 {
     struct shared_data_tlv_entry tlv_entry;
-    uint8_t *tlv_end;
-    uint8_t *tlv_curr;
+    const uint8_t *tlv_end;
+    const uint8_t *tlv_curr;
 
     /* The bootloader writes the image version information into the memory which
      * is shared between MCUboot and TF-M. Read the shared memory.
      */
-    if (boot_shared_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
+    if (boot_shared_tlv == NULL) {
         return PSA_ERROR_DATA_CORRUPT;
     }
 
-    tlv_end = (uint8_t *)&boot_shared_data +
-                boot_shared_data.header.tlv_tot_len;
-    tlv_curr = boot_shared_data.data;
+    tlv_end = boot_shared_tlv + boot_shared_tlv_len;
+    tlv_curr = boot_shared_tlv;
 
     while (tlv_curr < tlv_end) {
         (void)memcpy(&tlv_entry, tlv_curr, SHARED_DATA_ENTRY_HEADER_SIZE);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -10,6 +10,7 @@
 
 #include "psa/initial_attestation.h"
 #include "psa/client.h"
+#include "config_spm.h"
 #include "tfm_boot_status.h"
 
 #ifdef __cplusplus
@@ -58,6 +59,23 @@ attest_get_boot_data(uint8_t major_type,
                      struct tfm_boot_data *boot_data,
                      uint32_t len);
 
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+/*!
+ * \brief Get the location of the boot data (coming from boot loader) in the
+ *        shared memory area, to read it in place.
+ *
+ * \param[in]   major_type  Major type of TLV entries to look up
+ * \param[out]  tlv_start   Address of the first TLV entry
+ * \param[out]  tlv_len     Total size of the TLV entries
+ *
+ * \return Returns error code as specified in \ref psa_attest_err_t
+ */
+enum psa_attest_err_t
+attest_map_boot_data(uint8_t major_type,
+                     const uint8_t **tlv_start,
+                     uint32_t *tlv_len);
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
+
 /*!
  * \brief Get the ID of the caller thread.
  *
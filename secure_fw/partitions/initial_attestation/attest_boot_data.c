@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -9,6 +9,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include "attest_boot_data.h"
+#include "config_spm.h"
 #include "tfm_boot_status.h"
 #include "tfm_attest_iat_defs.h"
 #include "q_useful_buf.h"
@@ -20,6 +21,7 @@
 
 #define MAX_BOOT_STATUS 512
 
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY != 1
 /*!
  * \struct attest_boot_data
  *
@@ -45,98 +47,180 @@ struct attest_boot_data {
  */
 __attribute__ ((aligned(4)))
 static struct attest_boot_data boot_data;
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY != 1 */
 
 /*!
- * \brief Static function to look up all entries in the shared data area
- *       (boot status) which belong to a specific module.
+ * \var boot_data_tlv
  *
- * \param[in]     module  The identifier of SW module to look up based on this
- * \param[out]    claim   The type of SW module's attribute
- * \param[out]    tlv_len Length of the shared data entry
- * \param[in/out] tlv_ptr Pointer to the shared data entry. If its value NULL as
- *                        input then it will starts the look up from the
- *                        beginning of the shared data section. If not NULL then
- *                        it continue look up from the next entry. It returns
- *                        the address of next found entry which belongs to
- *                        module.
+ * \brief Start of the TLV entries of the boot status. They are either in
+ *        \ref boot_data or, with CONFIG_TFM_BOOT_DATA_ZERO_COPY, read in place
+ *        in the shared data area.
+ */
+static const uint8_t *boot_data_tlv;
+
+/*!
+ * \var boot_data_tlv_len
+ *
+ * \brief Total size of the TLV entries at \ref boot_data_tlv.
+ */
+static uint32_t boot_data_tlv_len;
+
+/*!
+ * \def BOOT_DATA_INDEX_MAX
+ *
+ * \brief The maximum number of TLV entries in the boot status. Each entry takes
+ *        at least its header.
+ */
+#define BOOT_DATA_INDEX_MAX (MAX_BOOT_STATUS / SHARED_DATA_ENTRY_HEADER_SIZE)
+
+/*!
+ * \struct boot_data_index_entry
+ *
+ * \brief Index entry of a TLV in the boot status.
+ *
+ * \details All the TLVs are of TLV_MAJOR_IAS type, so the minor type, which is
+ *          made of the SW module in the upper bits and the claim in the lower
+ *          bits, is used as the key.
+ */
+struct boot_data_index_entry {
+    uint16_t minor;     /* Minor type of the TLV entry */
+    uint16_t offset;    /* Offset of the TLV entry header in boot_data_tlv */
+};
+
+/*!
+ * \var boot_data_index
+ *
+ * \brief Index of the TLV entries in the boot status sorted by module and
+ *        claim. Entries with the same key keep the order of the boot status.
+ */
+static struct boot_data_index_entry boot_data_index[BOOT_DATA_INDEX_MAX];
+
+/*!
+ * \var boot_data_index_cnt
+ *
+ * \brief Number of the valid entries in \ref boot_data_index.
+ */
+static uint32_t boot_data_index_cnt;
+
+/*!
+ * \var is_boot_data_index_valid
+ *
+ * \brief Whether the boot status was well-formed when it was indexed.
+ */
+static bool is_boot_data_index_valid;
+
+/*!
+ * \brief Static function to build \ref boot_data_index from
+ *        \ref boot_data_tlv.
+ *        The TLV section is walked only once, here.
+ *
+ * \return Returns true if the boot status is well-formed, false otherwise.
+ */
+static bool attest_build_boot_data_index(void)
+{
+    struct shared_data_tlv_entry tlv_entry;
+    uint32_t tlv_end;
+    uint32_t offset;
+    uint32_t i;
+
+    boot_data_index_cnt = 0;
+
+    if (boot_data_tlv_len > MAX_BOOT_STATUS) {
+        return false;
+    }
+
+    tlv_end = boot_data_tlv_len;
+    offset = 0;
+
+    while (offset < tlv_end) {
+        if ((tlv_end - offset < SHARED_DATA_ENTRY_HEADER_SIZE) ||
+            (boot_data_index_cnt == BOOT_DATA_INDEX_MAX)) {
+            return false;
+        }
+
+        /* Create local copy to avoid unaligned access */
+        (void)memcpy(&tlv_entry, boot_data_tlv + offset,
+                     SHARED_DATA_ENTRY_HEADER_SIZE);
+
+        if (tlv_end - offset - SHARED_DATA_ENTRY_HEADER_SIZE <
+            tlv_entry.tlv_len) {
+            return false;
+        }
+
+        /* Insertion sort, stable for the entries with the same key */
+        i = boot_data_index_cnt;
+        while ((i > 0) &&
+               (boot_data_index[i - 1].minor > GET_MINOR(tlv_entry.tlv_type))) {
+            boot_data_index[i] = boot_data_index[i - 1];
+            i--;
+        }
+        boot_data_index[i].minor = GET_MINOR(tlv_entry.tlv_type);
+        boot_data_index[i].offset = (uint16_t)offset;
+        boot_data_index_cnt++;
+
+        offset += SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Static function to look up the first entry in the shared data area
+ *        (boot status) which belongs to a specific module and claim.
+ *
+ * \param[in]  module  The identifier of SW module to look up
+ * \param[in]  claim   The type of SW module's attribute to look up
+ * \param[out] tlv_len Length of the shared data entry
+ * \param[out] tlv_ptr Pointer to the shared data entry
  *
  * \retval    -1          Error, boot status is malformed
  * \retval     0          Entry not found
  * \retval     1          Entry found
  */
-static int32_t attest_get_tlv_by_module(uint8_t    module,
-                                        uint8_t   *claim,
-                                        uint16_t  *tlv_len,
-                                        uint8_t  **tlv_ptr)
+static int32_t attest_get_tlv(uint8_t    module,
+                              uint8_t    claim,
+                              uint16_t  *tlv_len,
+                              uint8_t  **tlv_ptr)
 {
     struct shared_data_tlv_entry tlv_entry;
-    uint8_t *tlv_end;
-    uint8_t *tlv_curr;
+    uint16_t key = SET_IAS_MINOR(module, claim);
+    uint32_t low = 0;
+    uint32_t high = boot_data_index_cnt;
+    uint32_t mid;
 
-    if (boot_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) {
+    if (!is_boot_data_index_valid) {
         return -1;
     }
 
-    /* Get the boundaries of TLV section where to lookup*/
-    tlv_end = (uint8_t *)&boot_data + boot_data.header.tlv_tot_len;
-    if (*tlv_ptr == NULL) {
-        /* At first call set to the beginning of the TLV section */
-        tlv_curr = boot_data.data;
-    } else {
-        /* Any subsequent call set to the next TLV entry */
-        (void)memcpy(&tlv_entry, *tlv_ptr, SHARED_DATA_ENTRY_HEADER_SIZE);
-
-        tlv_curr  = (*tlv_ptr) + SHARED_DATA_ENTRY_HEADER_SIZE
-                    + tlv_entry.tlv_len;
-    }
-
-    /* Iterates over the TLV section and returns the address and size of TLVs
-     * with requested module identifier
-     */
-    while (tlv_curr < tlv_end) {
-        /* Create local copy to avoid unaligned access */
-        (void)memcpy(&tlv_entry, tlv_curr, SHARED_DATA_ENTRY_HEADER_SIZE);
-        if (GET_IAS_MODULE(tlv_entry.tlv_type) == module) {
-            *claim   = GET_IAS_CLAIM(tlv_entry.tlv_type);
-            *tlv_ptr = tlv_curr;
-            *tlv_len = tlv_entry.tlv_len;
-            return 1;
+    /* Binary search of the first entry which is not less than the key */
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (boot_data_index[mid].minor < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
+    }
 
-        tlv_curr += (SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len);
+    if ((low == boot_data_index_cnt) || (boot_data_index[low].minor != key)) {
+        return 0;
     }
 
-    return 0;
+    /* The boot status is only read through the returned pointer */
+    *tlv_ptr = (uint8_t *)(boot_data_tlv + boot_data_index[low].offset);
+    /* Create local copy to avoid unaligned access */
+    (void)memcpy(&tlv_entry, *tlv_ptr, SHARED_DATA_ENTRY_HEADER_SIZE);
+    *tlv_len = tlv_entry.tlv_len;
+
+    return 1;
 }
 
 int32_t attest_get_tlv_by_id(uint8_t    claim,
                              uint16_t  *tlv_len,
                              uint8_t  **tlv_ptr)
 {
-    uint8_t tlv_id;
-    uint8_t module = SW_GENERAL;
-    int32_t found;
-
-    /* Ensure that look up starting from the beginning of the boot status */
-    *tlv_ptr = NULL;
-
     /* Look up specific TLV entry which belongs to SW_GENERAL module */
-    do {
-        /* Look up next entry */
-        found = attest_get_tlv_by_module(module, &tlv_id,
-                                         tlv_len, tlv_ptr);
-        if (found != 1) {
-            break;
-        }
-        /* At least one entry was found which belongs to SW_GENERAL,
-         * check whether this one is looked for
-         */
-        if (claim == tlv_id) {
-            break;
-        }
-    } while (found == 1);
-
-    return found;
+    return attest_get_tlv(SW_GENERAL, claim, tlv_len, tlv_ptr);
 }
 
 #ifdef TFM_PARTITION_MEASURED_BOOT
@@ -317,7 +401,6 @@ attest_encode_sw_components_array(QCBOREncodeContext *encode_ctx,
     struct q_useful_buf_c encoded_const = NULL_Q_USEFUL_BUF_C;
     uint16_t tlv_len;
     uint8_t *tlv_ptr;
-    uint8_t  tlv_id;
     uint8_t module = 0;
     int32_t found;
 
@@ -331,18 +414,12 @@ attest_encode_sw_components_array(QCBOREncodeContext *encode_ctx,
      * that was received from the secure bootloader.
      */
     for (module = 0; module < SW_MAX; ++module) {
-        /* Indicates to restart the look up from the beginning of the shared
-         * data section.
-         */
-        tlv_ptr = NULL;
-
-        /* Look up the first TLV entry which belongs to the SW module */
-        found = attest_get_tlv_by_module(module, &tlv_id,
-                                         &tlv_len, &tlv_ptr);
+        /* Look up the boot record of the SW module */
+        found = attest_get_tlv(module, SW_BOOT_RECORD, &tlv_len, &tlv_ptr);
         if (found == -1) {
             /* Boot status area is malformed. */
             return PSA_ATTEST_ERR_CLAIM_UNAVAILABLE;
-        } else if ((found == 1) && (tlv_id == SW_BOOT_RECORD)) {
+        } else if (found == 1) {
             (*cnt)++;
             if (*cnt == 1) {
                 /* Open array which stores SW components claims. */
@@ -370,7 +447,38 @@ attest_encode_sw_components_array(QCBOREncodeContext *encode_ctx,
 
 enum psa_attest_err_t attest_boot_data_init(void)
 {
-    return attest_get_boot_data(TLV_MAJOR_IAS,
-                                (struct tfm_boot_data *)&boot_data,
-                                MAX_BOOT_STATUS);
+    enum psa_attest_err_t err;
+
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+    err = attest_map_boot_data(TLV_MAJOR_IAS, &boot_data_tlv,
+                               &boot_data_tlv_len);
+    if (err != PSA_ATTEST_ERR_SUCCESS) {
+        return err;
+    }
+#else
+    err = attest_get_boot_data(TLV_MAJOR_IAS,
+                               (struct tfm_boot_data *)&boot_data,
+                               MAX_BOOT_STATUS);
+    if (err != PSA_ATTEST_ERR_SUCCESS) {
+        return err;
+    }
+
+    /*
+     * A malformed boot status is reported at the claim look up, like it was
+     * done before the index was introduced.
+     */
+    if ((boot_data.header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) ||
+        (boot_data.header.tlv_tot_len < SHARED_DATA_HEADER_SIZE) ||
+        (boot_data.header.tlv_tot_len > sizeof(boot_data))) {
+        is_boot_data_index_valid = false;
+        return PSA_ATTEST_ERR_SUCCESS;
+    }
+
+    boot_data_tlv = boot_data.data;
+    boot_data_tlv_len = boot_data.header.tlv_tot_len - SHARED_DATA_HEADER_SIZE;
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
+
+    is_boot_data_index_valid = attest_build_boot_data_index();
+
+    return PSA_ATTEST_ERR_SUCCESS;
 }
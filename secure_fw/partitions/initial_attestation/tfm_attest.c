@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -37,3 +37,21 @@ attest_get_boot_data(uint8_t major_type,
 
     return attest_res;
 }
+
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+enum psa_attest_err_t
+attest_map_boot_data(uint8_t major_type,
+                     const uint8_t **tlv_start,
+                     uint32_t *tlv_len)
+{
+    enum psa_attest_err_t attest_res = PSA_ATTEST_ERR_SUCCESS;
+    int32_t tfm_res;
+
+    tfm_res = tfm_core_map_boot_data(major_type, tlv_start, tlv_len);
+    if (tfm_res != (int32_t)TFM_SUCCESS) {
+        attest_res =  PSA_ATTEST_ERR_INIT_FAILED;
+    }
+
+    return attest_res;
+}
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2020-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -7,8 +7,11 @@
 #ifndef __SERVICE_API_H__
 #define __SERVICE_API_H__
 
+#include <stdbool.h>
 #include <stdint.h>
+#include "config_spm.h"
 #include "tfm_boot_status.h"
+#include "psa/error.h"
 
 /**
  * \brief Retrieve secure partition related data from shared memory area, which
@@ -22,4 +25,51 @@ int32_t tfm_core_get_boot_data(uint8_t major_type,
                                struct tfm_boot_data *boot_data,
                                uint32_t len);
 
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+/**
+ * \brief Get the location of the secure partition related data in the shared
+ *        memory area, which stores shared data between bootloader and runtime
+ *        firmware. The data is read in place, nothing is copied.
+ *
+ * \param[in]  major_type  Major type.
+ * \param[out] tlv_start   Address of the first TLV entry of the major type,
+ *                         NULL if there is none.
+ * \param[out] tlv_len     Total size of the TLV entries of the major type.
+ */
+int32_t tfm_core_map_boot_data(uint8_t major_type,
+                               const uint8_t **tlv_start,
+                               uint32_t *tlv_len);
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
+
+#ifdef TFM_NS_MANAGE_NSID
+/**
+ * \brief Get the next non-secure client ID released by the non-secure
+ *        threads. The SPM keeps the last released client IDs for all the
+ *        partitions, each partition reads them with its own sequence number.
+ *        A client ID is released when no non-secure thread uses it any more.
+ *
+ * \param[in,out] seq   The sequence number of the next record to read,
+ *                      initialized to 0. It is advanced by the call.
+ * \param[out]    nsid  The released non-secure client ID.
+ *
+ * \retval PSA_SUCCESS                   A client ID is read.
+ * \retval PSA_ERROR_DOES_NOT_EXIST      No client ID is released since the
+ *                                       last call.
+ * \retval PSA_ERROR_INSUFFICIENT_MEMORY Some released client IDs were dropped
+ *                                       before they were read. The partition
+ *                                       should check its clients with
+ *                                       \ref tfm_core_is_ns_client_active.
+ */
+psa_status_t tfm_core_get_ns_client_release(uint32_t *seq, int32_t *nsid);
+
+/**
+ * \brief Check if a non-secure client ID is used by a non-secure thread.
+ *
+ * \param[in] nsid  The non-secure client ID.
+ *
+ * \return true if the client ID is in use, false otherwise.
+ */
+bool tfm_core_is_ns_client_active(int32_t nsid);
+#endif /* TFM_NS_MANAGE_NSID */
+
 #endif /* __SERVICE_API_H__ */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2020-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -22,6 +22,39 @@ int32_t tfm_core_get_boot_data(uint8_t major_type,
         );
 }
 
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+__attribute__((naked))
+int32_t tfm_core_map_boot_data(uint8_t major_type,
+                               const uint8_t **tlv_start,
+                               uint32_t *tlv_len)
+{
+    __ASM volatile(
+        "SVC    "M2S(TFM_SVC_MAP_BOOT_DATA)"               \n"
+        "BX     lr                                         \n"
+        );
+}
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
+
+#ifdef TFM_NS_MANAGE_NSID
+__attribute__((naked))
+psa_status_t tfm_core_get_ns_client_release(uint32_t *seq, int32_t *nsid)
+{
+    __ASM volatile(
+        "SVC    "M2S(TFM_SVC_GET_NS_CLIENT_RELEASE)"       \n"
+        "BX     lr                                         \n"
+        );
+}
+
+__attribute__((naked))
+bool tfm_core_is_ns_client_active(int32_t nsid)
+{
+    __ASM volatile(
+        "SVC    "M2S(TFM_SVC_NS_CLIENT_IS_ACTIVE)"         \n"
+        "BX     lr                                         \n"
+        );
+}
+#endif /* TFM_NS_MANAGE_NSID */
+
 #if TFM_LVL != 1
 /* Entry point when Partition FLIH functions return */
 __attribute__((naked))
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2022 Cypress Semiconductor Corporation (an Infineon
  * company) or an affiliate of Cypress Semiconductor Corporation. All rights
  * reserved.
@@ -11,9 +11,11 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "critical_section.h"
 #include "region.h"
 #include "region_defs.h"
 #include "tfm_hal_multi_core.h"
+#include "tfm_mailbox_config.h"
 #include "tfm_multi_core.h"
 #include "tfm_arch.h"
 #include "utilities.h"
@@ -31,35 +33,80 @@
 #define MEM_CHECK_NONSECURE             (MEM_CHECK_AU_NONSECURE | \
                                          MEM_CHECK_MPU_NONSECURE)
 
-void tfm_get_mem_region_security_attr(const void *p, size_t s,
-                                      struct security_attr_info_t *p_attr)
-{
-    p_attr->is_valid = true;
+/* SPE local buffer accepted in non-secure memory access checks */
+static uintptr_t ns_local_region_start;
+static size_t ns_local_region_size;
+
+#if MAILBOX_NS_BUF_CACHE_CLIENTS > 0
+/* A non-secure buffer which passed the access check */
+struct ns_buf_cache_entry_t {
+    uintptr_t start;
+    size_t    size;             /* 0 if the entry is unused */
+    uint32_t  flags;            /* The access permissions checked */
+};
+
+/* The non-secure buffers recently validated for a non-secure client */
+struct ns_buf_cache_t {
+    int32_t                     client_id;  /* 0 if the cache is unused */
+    uint8_t                     next;       /* The entry replaced next */
+    struct ns_buf_cache_entry_t entries[MAILBOX_NS_BUF_CACHE_ENTRIES];
+};
+
+static struct ns_buf_cache_t ns_buf_caches[MAILBOX_NS_BUF_CACHE_CLIENTS];
+/* The cache replaced next by a client not in the caches */
+static uint8_t next_ns_buf_cache;
+/* The cache of the non-secure client whose request is under dispatch */
+static struct ns_buf_cache_t *cur_ns_buf_cache;
+#endif
 
-    if (check_address_range(p, s, NS_DATA_START,
-                            NS_DATA_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_secure = false;
-        return;
-    }
+/* The lookups which a memory region takes part in */
+#define MEM_REGION_SECURITY_ATTR        (1U << 0)
+#define MEM_REGION_SECURE_ACCESS_ATTR   (1U << 1)
+#define MEM_REGION_NS_ACCESS_ATTR       (1U << 2)
 
-    if (check_address_range(p, s, NS_CODE_START,
-                            NS_CODE_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_secure = false;
-        return;
-    }
+/*
+ * The number of regions added by mem_region_init(). Update it together with
+ * mem_region_init(). Adding more regions panics.
+ */
+#if TFM_LVL == 1
+#define MEM_REGION_MAX_NUM              4
+#elif TFM_LVL == 2
+#ifdef CONFIG_TFM_PARTITION_META
+#define MEM_REGION_MAX_NUM              8
+#else
+#define MEM_REGION_MAX_NUM              7
+#endif
+#else
+#error "Cannot support current TF-M isolation level"
+#endif
 
-    if (check_address_range(p, s, S_DATA_START, S_DATA_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_secure = true;
-        return;
-    }
+#define MEM_REGION_NONE                 UINT8_MAX
 
-    if (check_address_range(p, s, S_CODE_START, S_CODE_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_secure = true;
-        return;
-    }
+/* A memory region in the system memory layout and its attributes */
+struct mem_region_t {
+    uintptr_t              start;
+    uintptr_t              limit;      /* The last address in the region */
+    uint8_t                lookups;    /* Lookups the region takes part in */
+    uint8_t                parent;     /* The smallest region containing it */
+    bool                   is_secure;
+    struct mem_attr_info_t attr;
+};
 
-    p_attr->is_valid = false;
-}
+/*
+ * The memory regions in lookup priority order. A lookup returns the first
+ * region taking part in it which contains the whole target range.
+ */
+static struct mem_region_t mem_regions[MEM_REGION_MAX_NUM];
+static uint8_t nr_mem_regions;
+/* Indexes of mem_regions sorted by start address, then outer region first */
+static uint8_t mem_region_order[MEM_REGION_MAX_NUM];
+/*
+ * Whether the sorted table can be binary searched. The regions must be either
+ * disjoint or nested, and a nested region must come first in the lookups it
+ * shares with the containing one. Otherwise lookups scan mem_regions in order.
+ */
+static bool is_mem_region_sorted;
+static bool is_mem_region_init;
 
 #if TFM_LVL == 2
 REGION_DECLARE(Image$$, TFM_UNPRIV_CODE, $$RO$$Base);
@@ -74,147 +121,293 @@ REGION_DECLARE(Image$$, TFM_APP_RW_STACK_START, $$Base);
 REGION_DECLARE(Image$$, TFM_APP_RW_STACK_END, $$Base);
 #endif
 
-void tfm_get_secure_mem_region_attr(const void *p, size_t s,
-                                    struct mem_attr_info_t *p_attr)
+/*
+ * Append a region to the lowest lookup priority. Data regions are writable and
+ * Execute Never. Code regions are read-only. Privileged access is always
+ * allowed and unprivileged access is allowed if is_unpriv is set.
+ */
+static void mem_region_add(uintptr_t start, uintptr_t limit, uint8_t lookups,
+                           bool is_secure, bool is_data, bool is_unpriv)
 {
-#if TFM_LVL == 1
-    p_attr->is_mpu_enabled = false;
-    p_attr->is_valid = true;
+    struct mem_region_t *region;
 
-    if (check_address_range(p, s, S_DATA_START, S_DATA_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = true;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = true;
-        p_attr->is_xn = true;
+    /* An empty region never contains a range */
+    if (limit < start) {
         return;
     }
 
-    if (check_address_range(p, s, S_CODE_START, S_CODE_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = false;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = false;
-        p_attr->is_xn = false;
-        return;
+    /* A region silently dropped would fail the checks of valid buffers */
+    if (nr_mem_regions >= MEM_REGION_MAX_NUM) {
+        tfm_core_panic();
     }
 
-    p_attr->is_valid = false;
-#elif TFM_LVL == 2
-    uintptr_t base, limit;
+    region = &mem_regions[nr_mem_regions];
+    region->start = start;
+    region->limit = limit;
+    region->lookups = lookups;
+    region->parent = MEM_REGION_NONE;
+    region->is_secure = is_secure;
+
+    region->attr.is_mpu_enabled = false;
+    region->attr.is_valid = true;
+    region->attr.is_xn = is_data;
+    region->attr.is_priv_rd_allow = true;
+    region->attr.is_priv_wr_allow = is_data;
+    region->attr.is_unpriv_rd_allow = is_unpriv;
+    region->attr.is_unpriv_wr_allow = is_unpriv && is_data;
+
+    nr_mem_regions++;
+}
 
-    p_attr->is_mpu_enabled = false;
-    p_attr->is_valid = true;
+/* Whether region a is sorted before region b */
+static bool mem_region_is_before(uint8_t a, uint8_t b)
+{
+    if (mem_regions[a].start != mem_regions[b].start) {
+        return mem_regions[a].start < mem_regions[b].start;
+    }
 
-    /* TFM Core unprivileged code region */
-    base = (uintptr_t)&REGION_NAME(Image$$, TFM_UNPRIV_CODE, $$RO$$Base);
-    limit = (uintptr_t)&REGION_NAME(Image$$, TFM_UNPRIV_CODE, $$RO$$Limit) - 1;
-    if (check_address_range(p, s, base, limit) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = false;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = false;
-        p_attr->is_xn = false;
+    if (mem_regions[a].limit != mem_regions[b].limit) {
+        return mem_regions[a].limit > mem_regions[b].limit;
+    }
+
+    /* The same region. The one of higher priority is taken as nested. */
+    return a > b;
+}
+
+/*
+ * Sort the regions and link each one to the smallest region containing it.
+ * Return false if the regions cannot be binary searched.
+ */
+static bool mem_region_sort(void)
+{
+    uint8_t stack[MEM_REGION_MAX_NUM];
+    uint8_t depth = 0;
+    uint8_t i, j, idx, up;
+
+    for (i = 0; i < nr_mem_regions; i++) {
+        idx = i;
+        for (j = i; (j > 0) && mem_region_is_before(idx,
+                                                    mem_region_order[j - 1]);
+             j--) {
+            mem_region_order[j] = mem_region_order[j - 1];
+        }
+        mem_region_order[j] = idx;
+    }
+
+    for (i = 0; i < nr_mem_regions; i++) {
+        idx = mem_region_order[i];
+
+        /* Drop the regions which end before the current one */
+        while ((depth > 0) &&
+               (mem_regions[stack[depth - 1]].limit < mem_regions[idx].start)) {
+            depth--;
+        }
+
+        if (depth > 0) {
+            up = stack[depth - 1];
+
+            /* Overlapping but not nested */
+            if (mem_regions[idx].limit > mem_regions[up].limit) {
+                return false;
+            }
+
+            mem_regions[idx].parent = up;
+
+            /* A containing region must not win a lookup over a nested one */
+            for (; up != MEM_REGION_NONE; up = mem_regions[up].parent) {
+                if ((mem_regions[idx].lookups & mem_regions[up].lookups) &&
+                    (up < idx)) {
+                    return false;
+                }
+            }
+        }
+
+        stack[depth++] = idx;
+    }
+
+    return true;
+}
+
+/* Collect the memory regions once. The layout is fixed at link time. */
+static void mem_region_init(void)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    if (is_mem_region_init) {
+        CRITICAL_SECTION_LEAVE(cs_assert);
         return;
     }
 
+    nr_mem_regions = 0;
+
+#if TFM_LVL == 1
+    mem_region_add((uintptr_t)NS_DATA_START, (uintptr_t)NS_DATA_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_NS_ACCESS_ATTR,
+                   false, true, true);
+    mem_region_add((uintptr_t)NS_CODE_START, (uintptr_t)NS_CODE_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_NS_ACCESS_ATTR,
+                   false, false, true);
+    mem_region_add((uintptr_t)S_DATA_START, (uintptr_t)S_DATA_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_SECURE_ACCESS_ATTR,
+                   true, true, true);
+    mem_region_add((uintptr_t)S_CODE_START, (uintptr_t)S_CODE_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_SECURE_ACCESS_ATTR,
+                   true, false, true);
+#elif TFM_LVL == 2
+    /* TFM Core unprivileged code region */
+    mem_region_add(
+        (uintptr_t)&REGION_NAME(Image$$, TFM_UNPRIV_CODE, $$RO$$Base),
+        (uintptr_t)&REGION_NAME(Image$$, TFM_UNPRIV_CODE, $$RO$$Limit) - 1,
+        MEM_REGION_SECURE_ACCESS_ATTR, true, false, true);
+
 #ifdef CONFIG_TFM_PARTITION_META
     /* TFM partition metadata pointer region */
-    base = (uintptr_t)&REGION_NAME(Image$$, TFM_SP_META_PTR, $$ZI$$Base);
-    limit = (uintptr_t)&REGION_NAME(Image$$, TFM_SP_META_PTR, $$ZI$$Limit) - 1;
-    if (check_address_range(p, s, base, limit) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = true;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = true;
-        p_attr->is_xn = true;
-        return;
-    }
+    mem_region_add(
+        (uintptr_t)&REGION_NAME(Image$$, TFM_SP_META_PTR, $$ZI$$Base),
+        (uintptr_t)&REGION_NAME(Image$$, TFM_SP_META_PTR, $$ZI$$Limit) - 1,
+        MEM_REGION_SECURE_ACCESS_ATTR, true, true, true);
 #endif
 
     /* APP RoT partition RO region */
-    base = (uintptr_t)&REGION_NAME(Image$$, TFM_APP_CODE_START, $$Base);
-    limit = (uintptr_t)&REGION_NAME(Image$$, TFM_APP_CODE_END, $$Base) - 1;
-    if (check_address_range(p, s, base, limit) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = false;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = false;
-        p_attr->is_xn = false;
-        return;
-    }
+    mem_region_add(
+        (uintptr_t)&REGION_NAME(Image$$, TFM_APP_CODE_START, $$Base),
+        (uintptr_t)&REGION_NAME(Image$$, TFM_APP_CODE_END, $$Base) - 1,
+        MEM_REGION_SECURE_ACCESS_ATTR, true, false, true);
 
     /* RW, ZI and stack as one region */
-    base = (uintptr_t)&REGION_NAME(Image$$, TFM_APP_RW_STACK_START, $$Base);
-    limit = (uintptr_t)&REGION_NAME(Image$$, TFM_APP_RW_STACK_END, $$Base) - 1;
-    if (check_address_range(p, s, base, limit) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = true;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = true;
-        p_attr->is_xn = true;
-        return;
-    }
+    mem_region_add(
+        (uintptr_t)&REGION_NAME(Image$$, TFM_APP_RW_STACK_START, $$Base),
+        (uintptr_t)&REGION_NAME(Image$$, TFM_APP_RW_STACK_END, $$Base) - 1,
+        MEM_REGION_SECURE_ACCESS_ATTR, true, true, true);
+
+    mem_region_add((uintptr_t)NS_DATA_START, (uintptr_t)NS_DATA_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_NS_ACCESS_ATTR,
+                   false, true, true);
+    mem_region_add((uintptr_t)NS_CODE_START, (uintptr_t)NS_CODE_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_NS_ACCESS_ATTR,
+                   false, false, true);
 
     /*
      * Treat the remaining parts in secure data section and secure code section
      * as privileged regions
      */
-    base = (uintptr_t)S_DATA_START;
-    limit = (uintptr_t)S_DATA_LIMIT;
-    if (check_address_range(p, s, base, limit) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = true;
-        p_attr->is_unpriv_rd_allow = false;
-        p_attr->is_unpriv_wr_allow = false;
-        p_attr->is_xn = true;
-        return;
+    mem_region_add((uintptr_t)S_DATA_START, (uintptr_t)S_DATA_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_SECURE_ACCESS_ATTR,
+                   true, true, false);
+    mem_region_add((uintptr_t)S_CODE_START, (uintptr_t)S_CODE_LIMIT,
+                   MEM_REGION_SECURITY_ATTR | MEM_REGION_SECURE_ACCESS_ATTR,
+                   true, false, false);
+#else
+#error "Cannot support current TF-M isolation level"
+#endif
+
+    is_mem_region_sorted = mem_region_sort();
+    is_mem_region_init = true;
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
+}
+
+/*
+ * Find the memory region of the highest priority in the lookup which contains
+ * the whole target range. Return NULL if none is found.
+ */
+static const struct mem_region_t *mem_region_lookup(const void *p, size_t s,
+                                                    uint8_t lookup)
+{
+    uint8_t lo = 0, hi, mid, idx;
+
+    if (!is_mem_region_init) {
+        mem_region_init();
     }
 
-    base = (uintptr_t)S_CODE_START;
-    limit = (uintptr_t)S_CODE_LIMIT;
-    if (check_address_range(p, s, base, limit) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = false;
-        p_attr->is_unpriv_rd_allow = false;
-        p_attr->is_unpriv_wr_allow = false;
-        p_attr->is_xn = false;
-        return;
+    if (!is_mem_region_sorted) {
+        for (idx = 0; idx < nr_mem_regions; idx++) {
+            if ((mem_regions[idx].lookups & lookup) &&
+                (check_address_range(p, s, mem_regions[idx].start,
+                                     mem_regions[idx].limit) == TFM_SUCCESS)) {
+                return &mem_regions[idx];
+            }
+        }
+
+        return NULL;
     }
 
-    p_attr->is_valid = false;
-#else
-#error "Cannot support current TF-M isolation level"
-#endif
+    /* Find the last region starting at or below the target range */
+    hi = nr_mem_regions;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (mem_regions[mem_region_order[mid]].start <= (uintptr_t)p) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0) {
+        return NULL;
+    }
+
+    /*
+     * Any region containing the target range is either that region or one of
+     * the regions containing it. Nested regions are met first.
+     */
+    for (idx = mem_region_order[lo - 1]; idx != MEM_REGION_NONE;
+         idx = mem_regions[idx].parent) {
+        if ((mem_regions[idx].lookups & lookup) &&
+            (check_address_range(p, s, mem_regions[idx].start,
+                                 mem_regions[idx].limit) == TFM_SUCCESS)) {
+            return &mem_regions[idx];
+        }
+    }
+
+    return NULL;
 }
 
-void tfm_get_ns_mem_region_attr(const void *p, size_t s,
-                                struct mem_attr_info_t *p_attr)
+void tfm_get_mem_region_security_attr(const void *p, size_t s,
+                                      struct security_attr_info_t *p_attr)
 {
-    p_attr->is_mpu_enabled = false;
+    const struct mem_region_t *region;
+
+    region = mem_region_lookup(p, s, MEM_REGION_SECURITY_ATTR);
+    if (!region) {
+        p_attr->is_valid = false;
+        return;
+    }
+
     p_attr->is_valid = true;
+    p_attr->is_secure = region->is_secure;
+}
+
+void tfm_get_secure_mem_region_attr(const void *p, size_t s,
+                                    struct mem_attr_info_t *p_attr)
+{
+    const struct mem_region_t *region;
 
-    if (check_address_range(p, s, NS_DATA_START,
-                            NS_DATA_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = true;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = true;
-        p_attr->is_xn = true;
+    region = mem_region_lookup(p, s, MEM_REGION_SECURE_ACCESS_ATTR);
+    if (!region) {
+        p_attr->is_mpu_enabled = false;
+        p_attr->is_valid = false;
         return;
     }
 
-    if (check_address_range(p, s, NS_CODE_START,
-                            NS_CODE_LIMIT) == TFM_SUCCESS) {
-        p_attr->is_priv_rd_allow = true;
-        p_attr->is_priv_wr_allow = false;
-        p_attr->is_unpriv_rd_allow = true;
-        p_attr->is_unpriv_wr_allow = false;
-        p_attr->is_xn = false;
+    *p_attr = region->attr;
+}
+
+void tfm_get_ns_mem_region_attr(const void *p, size_t s,
+                                struct mem_attr_info_t *p_attr)
+{
+    const struct mem_region_t *region;
+
+    region = mem_region_lookup(p, s, MEM_REGION_NS_ACCESS_ATTR);
+    if (!region) {
+        p_attr->is_mpu_enabled = false;
+        p_attr->is_valid = false;
         return;
     }
 
-    p_attr->is_valid = false;
+    *p_attr = region->attr;
 }
 
 static void security_attr_init(struct security_attr_info_t *p_attr)
@@ -390,6 +583,50 @@ static enum tfm_status_e mem_attr_check(struct mem_attr_info_t attr,
     return secure_mem_attr_check(attr, flags);
 }
 
+#if MAILBOX_NS_BUF_CACHE_CLIENTS > 0
+/* Whether the range lies in a buffer validated with the same permissions */
+static bool ns_buf_cache_hit(const void *p, size_t s, uint32_t flags)
+{
+    const struct ns_buf_cache_entry_t *entry;
+    uint8_t i;
+
+    if (!cur_ns_buf_cache) {
+        return false;
+    }
+
+    for (i = 0; i < MAILBOX_NS_BUF_CACHE_ENTRIES; i++) {
+        entry = &cur_ns_buf_cache->entries[i];
+        if ((entry->size > 0) && (entry->flags == flags) &&
+            (check_address_range(p, s, entry->start,
+                                 entry->start + entry->size - 1)
+             == TFM_SUCCESS)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Record a non-secure buffer which passed the check, replacing the oldest */
+static void ns_buf_cache_add(const void *p, size_t s, uint32_t flags)
+{
+    struct ns_buf_cache_entry_t *entry;
+
+    if (!cur_ns_buf_cache ||
+        ((flags & MEM_CHECK_NONSECURE) != MEM_CHECK_NONSECURE)) {
+        return;
+    }
+
+    entry = &cur_ns_buf_cache->entries[cur_ns_buf_cache->next];
+    entry->start = (uintptr_t)p;
+    entry->size = s;
+    entry->flags = flags;
+
+    cur_ns_buf_cache->next = (cur_ns_buf_cache->next + 1) %
+                             MAILBOX_NS_BUF_CACHE_ENTRIES;
+}
+#endif /* MAILBOX_NS_BUF_CACHE_CLIENTS > 0 */
+
 enum tfm_status_e tfm_has_access_to_region(const void *p, size_t s,
                                            uint32_t flags)
 {
@@ -414,6 +651,21 @@ enum tfm_status_e tfm_has_access_to_region(const void *p, size_t s,
         tfm_core_panic();
     }
 
+    /* The SPE local copy of the data owned by the non-secure caller */
+    if (((flags & MEM_CHECK_NONSECURE) == MEM_CHECK_NONSECURE) &&
+        (ns_local_region_size > 0) &&
+        (check_address_range(p, s, ns_local_region_start,
+                             ns_local_region_start + ns_local_region_size - 1)
+         == TFM_SUCCESS)) {
+        return TFM_SUCCESS;
+    }
+
+#if MAILBOX_NS_BUF_CACHE_CLIENTS > 0
+    if (ns_buf_cache_hit(p, s, flags)) {
+        return TFM_SUCCESS;
+    }
+#endif
+
     security_attr_init(&security_attr);
 
     /* Retrieve security attributes of target memory region */
@@ -440,7 +692,57 @@ enum tfm_status_e tfm_has_access_to_region(const void *p, size_t s,
         tfm_hal_get_ns_access_attr(p, s, &mem_attr);
     }
 
-    return mem_attr_check(mem_attr, flags);
+    if (mem_attr_check(mem_attr, flags) != TFM_SUCCESS) {
+        return TFM_ERROR_GENERIC;
+    }
+
+#if MAILBOX_NS_BUF_CACHE_CLIENTS > 0
+    ns_buf_cache_add(p, s, flags);
+#endif
+
+    return TFM_SUCCESS;
+}
+
+void tfm_multi_core_set_ns_local_region(const void *p, size_t s)
+{
+    if (!p) {
+        s = 0;
+    }
+
+    ns_local_region_start = (uintptr_t)p;
+    ns_local_region_size = s;
+}
+
+void tfm_multi_core_set_ns_client(int32_t client_id)
+{
+#if MAILBOX_NS_BUF_CACHE_CLIENTS > 0
+    struct ns_buf_cache_t *cache;
+    uint8_t i;
+
+    /* Only non-secure client IDs are negative */
+    if (client_id >= 0) {
+        cur_ns_buf_cache = NULL;
+        return;
+    }
+
+    for (i = 0; i < MAILBOX_NS_BUF_CACHE_CLIENTS; i++) {
+        if (ns_buf_caches[i].client_id == client_id) {
+            cur_ns_buf_cache = &ns_buf_caches[i];
+            return;
+        }
+    }
+
+    /* Take over the caches in turn */
+    cache = &ns_buf_caches[next_ns_buf_cache];
+    next_ns_buf_cache = (next_ns_buf_cache + 1) % MAILBOX_NS_BUF_CACHE_CLIENTS;
+
+    spm_memset(cache, 0, sizeof(*cache));
+    cache->client_id = client_id;
+
+    cur_ns_buf_cache = cache;
+#else
+    (void)client_id;
+#endif
 }
 
 enum tfm_status_e check_address_range(const void *p, size_t s,
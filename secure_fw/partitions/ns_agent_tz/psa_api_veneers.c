@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2022-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -13,6 +13,10 @@
 
 #include "psa/client.h"
 
+#if TFM_LVL == 1
+#include "ffm/psa_api.h"
+#endif
+
 /*
  * This is the veneers of FF-M Client APIs, except for Armv8.0-m.
  * The interfaces are written in C unlike Armv8.0-m because reentrant detection
@@ -20,18 +24,28 @@
  *
  * As NS Agent is also a Secure Partition, it can call the client APIs directly.
  *
+ * The version queries are side-effect free, so they are answered in the veneer
+ * without entering SPM where possible:
+ * - The framework version is a constant.
+ * - The service version is read from the constant service load information.
+ *   That needs the privileged access to SPM data, so it is only done with
+ *   isolation level 1.
  */
 
 __tz_c_veneer
 uint32_t tfm_psa_framework_version_veneer(void)
 {
-    return psa_framework_version();
+    return PSA_FRAMEWORK_VERSION;
 }
 
 __tz_c_veneer
 uint32_t tfm_psa_version_veneer(uint32_t sid)
 {
+#if TFM_LVL == 1
+    return tfm_spm_client_psa_version_ns_fast(sid);
+#else
     return psa_version(sid);
+#endif
 }
 
 __tz_c_veneer
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -15,9 +15,12 @@
 
 #include "psa/client.h"
 
+#if (CONFIG_TFM_PSA_API_CROSS_CALL == 1) || (TFM_LVL == 1)
+#include "ffm/psa_api.h"
+#endif
+
 #if CONFIG_TFM_PSA_API_CROSS_CALL == 1
 #include "spm_ipc.h"
-#include "ffm/psa_api.h"
 #elif CONFIG_TFM_PSA_API_SFN_CALL == 1
 #include "tfm_psa_call_pack.h"
 #endif
@@ -36,13 +39,29 @@
  *   the pushed non-secure context is popped and overrides the returned
  *   context before returning to NSPE. Therefore it is unnecessary to
  *   explicitly clean up the context.
+ *
+ * - The version queries are side-effect free and are answered in the veneer
+ *   without entering SPM where possible. The framework version is a constant.
+ *   The service version is read from the constant service load information,
+ *   which needs the privileged access to SPM data, so it is only done with
+ *   isolation level 1.
  */
 
+/* PSA_FRAMEWORK_VERSION without the integer suffix, to be used in assembly */
+#define FRAMEWORK_VERSION_ASM           0x0101
+
+#if FRAMEWORK_VERSION_ASM != PSA_FRAMEWORK_VERSION
+#error "FRAMEWORK_VERSION_ASM does not match PSA_FRAMEWORK_VERSION!"
+#endif
+
 #if defined(__ICCARM__)
 
+#if TFM_LVL == 1
+#pragma required = tfm_spm_client_psa_version_ns_fast
+#endif
+
 #if CONFIG_TFM_PSA_API_CROSS_CALL == 1
 
-#pragma required = tfm_spm_client_psa_framework_version
 #pragma required = tfm_spm_client_psa_version
 #pragma required = tfm_spm_client_psa_call
 #pragma required = spm_interface_cross_dispatcher
@@ -56,7 +75,6 @@
 #pragma required = psa_close_sfn
 #pragma required = psa_connect_sfn
 #pragma required = psa_call_pack_sfn
-#pragma required = psa_framework_version_sfn
 #pragma required = psa_version_sfn
 #endif /* CONFIG_TFM_PSA_API_CROSS_CALL == 1 */
 
@@ -98,37 +116,21 @@ static void clear_caller_context(void)
 __tz_naked_veneer
 uint32_t tfm_psa_framework_version_veneer(void)
 {
+    /*
+     * The secure stack is not used, so no reentrant check is needed. Clear the
+     * registers that are not restored by the return to NSPE.
+     */
     __ASM volatile(
 #if !defined(__ICCARM__)
         ".syntax unified                                      \n"
 #endif
 
-        "   ldr    r2, [sp]                                   \n"
-        "   ldr    r3, ="M2S(STACK_SEAL_PATTERN)"             \n"
-        "   cmp    r2, r3                                     \n"
-        "   bne    reent_panic1                               \n"
-        "   push   {r4, lr}                                   \n"
-
-#if CONFIG_TFM_PSA_API_CROSS_CALL == 1
-        "   push   {r0-r3}                                    \n"
-        "   ldr    r0, =tfm_spm_client_psa_framework_version  \n"
-        "   mov    r1, sp                                     \n"
-        "   bl     spm_interface_cross_dispatcher             \n"
-        "   pop    {r0-r3}                                    \n"
-#elif CONFIG_TFM_PSA_API_SFN_CALL == 1
-        "   bl     psa_framework_version_sfn                  \n"
-#else
-        "   svc    "M2S(TFM_SVC_PSA_FRAMEWORK_VERSION)"       \n"
-#endif
-        "   bl     clear_caller_context                       \n"
-        "   pop    {r1, r2}                                   \n"
-        "   mov    lr, r2                                     \n"
-        "   mov    r4, r1                                     \n"
+        "   ldr    r0, ="M2S(FRAMEWORK_VERSION_ASM)"          \n"
+        "   movs   r1, #0x0                                   \n"
+        "   movs   r2, #0x0                                   \n"
+        "   movs   r3, #0x0                                   \n"
+        "   msr    APSR_nzcvq, r3                             \n"
         "   bxns   lr                                         \n"
-
-        "reent_panic1:                                        \n"
-        "   svc    "M2S(TFM_SVC_PSA_PANIC)"                   \n"
-        "   b      .                                          \n"
     );
 }
 
@@ -146,7 +148,9 @@ uint32_t tfm_psa_version_veneer(uint32_t sid)
         "   bne    reent_panic2                               \n"
 
         "   push   {r4, lr}                                   \n"
-#if CONFIG_TFM_PSA_API_CROSS_CALL == 1
+#if TFM_LVL == 1
+        "   bl     tfm_spm_client_psa_version_ns_fast         \n"
+#elif CONFIG_TFM_PSA_API_CROSS_CALL == 1
         "   push   {r0-r3}                                    \n"
         "   ldr    r0, =tfm_spm_client_psa_version            \n"
         "   mov    r1, sp                                     \n"
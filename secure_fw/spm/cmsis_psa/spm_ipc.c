@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2021-2022 Cypress Semiconductor Corporation (an Infineon
  * company) or an affiliate of Cypress Semiconductor Corporation. All rights
  * reserved.
@@ -228,6 +228,32 @@ struct service_t *tfm_spm_get_service_by_sid(uint32_t sid)
     return NULL;
 }
 
+struct service_t *tfm_spm_get_service_by_handle(psa_handle_t handle)
+{
+    struct conn_handle_t *p_conn_handle;
+    uint32_t index;
+
+    if (IS_STATIC_HANDLE(handle)) {
+        index = GET_INDEX_FROM_STATIC_HANDLE(handle);
+        if (!IS_VALID_STATIC_HANDLE_IDX(index)) {
+            return NULL;
+        }
+
+        return stateless_services_ref_tbl[index];
+    }
+
+    p_conn_handle = tfm_spm_to_handle_instance(handle);
+    if (tfm_spm_validate_conn_handle(p_conn_handle) != PSA_SUCCESS) {
+        return NULL;
+    }
+
+    /*
+     * The connection is not checked against its owner, the result must not
+     * be used for access control.
+     */
+    return p_conn_handle->service;
+}
+
 #if CONFIG_TFM_DOORBELL_API == 1
 /**
  * \brief                   Get the partition context by partition ID.
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2020-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2021-2022 Cypress Semiconductor Corporation (an Infineon
  * company) or an affiliate of Cypress Semiconductor Corporation. All rights
  * reserved.
@@ -217,6 +217,20 @@ struct partition_t *tfm_spm_get_partition_by_id(int32_t partition_id);
  */
 struct service_t *tfm_spm_get_service_by_sid(uint32_t sid);
 
+/**
+ * \brief                   Get the service context which a client handle
+ *                          refers to. The handle is not checked against the
+ *                          caller, so it is only for informational use such
+ *                          as request ordering.
+ *
+ * \param[in] handle        A static handle or a connection handle
+ *
+ * \retval NULL             Failed
+ * \retval "Not NULL"       Target service context pointer,
+ *                          \ref service_t structures
+ */
+struct service_t *tfm_spm_get_service_by_handle(psa_handle_t handle);
+
 /************************ Message functions **********************************/
 
 #if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
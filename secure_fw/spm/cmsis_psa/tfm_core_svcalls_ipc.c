@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2017-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -24,6 +24,7 @@
 #include "load/partition_defs.h"
 #include "psa/client.h"
 #include "tfm_hal_platform.h"
+#include "tfm_nspm.h"
 
 /* MSP bottom (higher address) */
 REGION_DECLARE(Image$$, ARM_LIB_STACK, $$ZI$$Limit);
@@ -174,6 +175,19 @@ uint32_t tfm_core_svc_handler(uint32_t *msp, uint32_t exc_return,
     case TFM_SVC_GET_BOOT_DATA:
         tfm_core_get_boot_data_handler(svc_args);
         break;
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+    case TFM_SVC_MAP_BOOT_DATA:
+        tfm_core_map_boot_data_handler(svc_args);
+        break;
+#endif
+#ifdef TFM_NS_MANAGE_NSID
+    case TFM_SVC_GET_NS_CLIENT_RELEASE:
+        tfm_nspm_get_ns_client_release_handler(svc_args);
+        break;
+    case TFM_SVC_NS_CLIENT_IS_ACTIVE:
+        tfm_nspm_is_ns_client_active_handler(svc_args);
+        break;
+#endif
 #if (TFM_LVL != 1) && (CONFIG_TFM_FLIH_API == 1)
     case TFM_SVC_PREPARE_DEPRIV_FLIH:
         exc_return = tfm_flih_prepare_depriv_flih(
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -9,6 +9,8 @@
 #define __TFM_MULTI_CORE_H__
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "tfm_api.h"
 
@@ -102,6 +104,33 @@ void tfm_get_ns_mem_region_attr(const void *p, size_t s,
 enum tfm_status_e tfm_has_access_to_region(const void *p, size_t s,
                                            uint32_t flags);
 
+/**
+ * \brief Let non-secure memory access checks accept a SPE local buffer, until
+ *        it is cleared.
+ *
+ * \note The mailbox sets the buffer holding the copy of the inline payload of
+ *       the message under dispatch, and clears it right after the dispatch.
+ *
+ * \param[in] p               The start address of the buffer. NULL to clear.
+ * \param[in] s               The size of the buffer
+ */
+void tfm_multi_core_set_ns_local_region(const void *p, size_t s);
+
+/**
+ * \brief Set the non-secure client whose request is under dispatch. The
+ *        non-secure buffers which pass the access checks are cached per
+ *        client, so that the buffers reused in later requests are accepted
+ *        without walking the memory region attributes again.
+ *
+ * \note It takes effect only if MAILBOX_NS_BUF_CACHE_CLIENTS is greater than
+ *       0. The cached results assume that the non-secure memory attributes do
+ *       not change at runtime.
+ *
+ * \param[in] client_id       The non-secure client ID. A non-negative value
+ *                            clears the current client.
+ */
+void tfm_multi_core_set_ns_client(int32_t client_id);
+
 /**
  * \brief Initialization of the multi core communication.
  *
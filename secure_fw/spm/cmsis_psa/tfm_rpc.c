@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -11,6 +11,11 @@
 #include "utilities.h"
 #include "load/partition_defs.h"
 #include "tfm_psa_call_pack.h"
+#include "tfm_multi_core.h"
+
+#if TFM_RPC_REQ_POOL_SIZE > 255
+#error "TFM_RPC_REQ_POOL_SIZE should be <= 255"
+#endif
 
 static void default_handle_req(void)
 {
@@ -35,6 +40,33 @@ static struct tfm_rpc_ops_t rpc_ops = {
     .get_caller_data = default_get_caller_data,
 };
 
+/* The private data of the request under tfm_rpc_dispatch() */
+static const void *dispatch_caller_data = NULL;
+
+/*
+ * The requests received by the mailbox in a batch. They are dispatched in the
+ * order of req_order[], which holds the indexes of the first nr_reqs entries
+ * of req_pool[] sorted by priority.
+ */
+static struct tfm_rpc_req_t req_pool[TFM_RPC_REQ_POOL_SIZE];
+static uint8_t req_order[TFM_RPC_REQ_POOL_SIZE];
+static uint8_t nr_reqs;
+
+/*
+ * Priorities of the services looked up by SID, direct-mapped by the low bits
+ * of the SID. The services never change after SPM init, so an entry stays
+ * valid once it is filled, including the SIDs without a service.
+ */
+#define RPC_SID_PRIO_CACHE_SIZE     8
+
+struct rpc_sid_prio_t {
+    uint32_t sid;
+    uint8_t  priority;
+    bool     is_valid;
+};
+
+static struct rpc_sid_prio_t sid_prio_cache[RPC_SID_PRIO_CACHE_SIZE];
+
 uint32_t tfm_rpc_psa_framework_version(void)
 {
     return tfm_spm_client_psa_framework_version();
@@ -77,13 +109,210 @@ void tfm_rpc_psa_close(const struct client_call_params_t *params)
 
 #endif /* CONFIG_TFM_CONNECTION_BASED_SERVICE_API */
 
+int32_t tfm_rpc_dispatch(uint32_t call_type,
+                         const struct client_call_params_t *params,
+                         const void *caller_data, int32_t *reply)
+{
+    int32_t ret = TFM_RPC_SUCCESS;
+    psa_status_t status;
+
+    SPM_ASSERT(params != NULL);
+    SPM_ASSERT(reply != NULL);
+
+    /* SPM takes it via tfm_rpc_set_caller_data() while creating the message */
+    dispatch_caller_data = caller_data;
+
+    switch (call_type) {
+    case TFM_RPC_PSA_FRAMEWORK_VERSION:
+        *reply = (int32_t)tfm_rpc_psa_framework_version();
+        break;
+    case TFM_RPC_PSA_VERSION:
+        *reply = (int32_t)tfm_rpc_psa_version(params);
+        break;
+    case TFM_RPC_PSA_CALL:
+        status = tfm_rpc_psa_call(params);
+        if (status == PSA_SUCCESS) {
+            ret = TFM_RPC_REPLY_PENDING;
+        } else {
+            /* The request failed before reaching the service */
+            *reply = status;
+        }
+        break;
+#if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
+    case TFM_RPC_PSA_CONNECT:
+        status = tfm_rpc_psa_connect(params);
+        if (status == PSA_SUCCESS) {
+            ret = TFM_RPC_REPLY_PENDING;
+        } else {
+            *reply = status;
+        }
+        break;
+    case TFM_RPC_PSA_CLOSE:
+        tfm_rpc_psa_close(params);
+        ret = TFM_RPC_REPLY_PENDING;
+        break;
+#endif /* CONFIG_TFM_CONNECTION_BASED_SERVICE_API */
+    default:
+        ret = TFM_RPC_INVAL_PARAM;
+        break;
+    }
+
+    dispatch_caller_data = NULL;
+
+    return ret;
+}
+
+static uint8_t rpc_service_priority(const struct service_t *service)
+{
+    if (!service || !service->partition) {
+        return PARTITION_PRI_HIGHEST;
+    }
+
+    return (uint8_t)PARTITION_PRIORITY(service->partition->p_ldinf->flags);
+}
+
+/*
+ * Only the first request to a SID walks the service list, which also moves
+ * the service to the front of the list.
+ */
+static uint8_t rpc_sid_priority(uint32_t sid)
+{
+    struct rpc_sid_prio_t *entry;
+
+    entry = &sid_prio_cache[sid % RPC_SID_PRIO_CACHE_SIZE];
+    if (!entry->is_valid || (entry->sid != sid)) {
+        entry->sid = sid;
+        entry->priority = rpc_service_priority(
+                                            tfm_spm_get_service_by_sid(sid));
+        entry->is_valid = true;
+    }
+
+    return entry->priority;
+}
+
+/*
+ * The priority of the Secure Partition which provides the service requested.
+ * The requests which cannot be associated with a service are either answered
+ * directly or rejected quickly by SPM, so they take the highest priority. A
+ * handle is resolved in constant time.
+ */
+static uint8_t rpc_req_priority(const struct tfm_rpc_req_t *req)
+{
+    switch (req->call_type) {
+    case TFM_RPC_PSA_VERSION:
+        return rpc_sid_priority(req->params.sid);
+    case TFM_RPC_PSA_CALL:
+        return rpc_service_priority(
+                            tfm_spm_get_service_by_handle(req->params.handle));
+#if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
+    case TFM_RPC_PSA_CONNECT:
+        return rpc_sid_priority(req->params.sid);
+    case TFM_RPC_PSA_CLOSE:
+        return rpc_service_priority(
+                            tfm_spm_get_service_by_handle(req->params.handle));
+#endif /* CONFIG_TFM_CONNECTION_BASED_SERVICE_API */
+    default:
+        return PARTITION_PRI_HIGHEST;
+    }
+}
+
+struct tfm_rpc_req_t *tfm_rpc_req_alloc(void)
+{
+    struct tfm_rpc_req_t *req;
+
+    if (nr_reqs >= TFM_RPC_REQ_POOL_SIZE) {
+        return NULL;
+    }
+
+    req = &req_pool[nr_reqs];
+    spm_memset(req, 0, sizeof(*req));
+
+    return req;
+}
+
+void tfm_rpc_req_submit(struct tfm_rpc_req_t *req)
+{
+    uint8_t i;
+
+    SPM_ASSERT(req == &req_pool[nr_reqs]);
+
+    req->priority = rpc_req_priority(req);
+
+    /* Insert by priority. The submission order is kept for equal priority. */
+    for (i = nr_reqs; i > 0; i--) {
+        if (req_pool[req_order[i - 1]].priority <= req->priority) {
+            break;
+        }
+        req_order[i] = req_order[i - 1];
+    }
+    req_order[i] = nr_reqs;
+
+    nr_reqs++;
+}
+
+uint32_t tfm_rpc_req_dispatch(void)
+{
+    struct tfm_rpc_req_t *req;
+    uint32_t nr_dispatched = nr_reqs;
+    uint32_t nr_replies = 0;
+    uint8_t i;
+    int32_t ret, reply;
+
+    for (i = 0; i < nr_reqs; i++) {
+        req = &req_pool[req_order[i]];
+        reply = PSA_ERROR_GENERIC_ERROR;
+
+        /* SPM checks the vectors against the non-secure caller */
+        if (req->local_buf) {
+            tfm_multi_core_set_ns_local_region(req->local_buf,
+                                               req->local_size);
+        }
+        if (req->client_id < 0) {
+            tfm_multi_core_set_ns_client(req->client_id);
+        }
+
+        ret = tfm_rpc_dispatch(req->call_type, &req->params,
+                               req->caller_data, &reply);
+
+        if (req->client_id < 0) {
+            tfm_multi_core_set_ns_client(0);
+        }
+        if (req->local_buf) {
+            tfm_multi_core_set_ns_local_region(NULL, 0);
+        }
+
+        if (ret == TFM_RPC_REPLY_PENDING) {
+            continue;
+        }
+
+        if (ret != TFM_RPC_SUCCESS) {
+            reply = PSA_ERROR_NOT_SUPPORTED;
+        }
+
+        if (rpc_ops.reply_direct) {
+            rpc_ops.reply_direct(req->caller_data, reply);
+        } else {
+            rpc_ops.reply(req->caller_data, reply);
+        }
+        nr_replies++;
+    }
+
+    nr_reqs = 0;
+
+    if ((nr_replies > 0) && rpc_ops.notify) {
+        rpc_ops.notify();
+    }
+
+    return nr_dispatched;
+}
+
 int32_t tfm_rpc_register_ops(const struct tfm_rpc_ops_t *ops_ptr)
 {
     if (!ops_ptr) {
         return TFM_RPC_INVAL_PARAM;
     }
 
-    if (!ops_ptr->handle_req || !ops_ptr->reply || !ops_ptr->get_caller_data) {
+    if (!ops_ptr->handle_req || !ops_ptr->reply) {
         return TFM_RPC_INVAL_PARAM;
     }
 
@@ -96,7 +325,11 @@ int32_t tfm_rpc_register_ops(const struct tfm_rpc_ops_t *ops_ptr)
 
     rpc_ops.handle_req = ops_ptr->handle_req;
     rpc_ops.reply = ops_ptr->reply;
-    rpc_ops.get_caller_data = ops_ptr->get_caller_data;
+    rpc_ops.reply_direct = ops_ptr->reply_direct;
+    rpc_ops.notify = ops_ptr->notify;
+    if (ops_ptr->get_caller_data) {
+        rpc_ops.get_caller_data = ops_ptr->get_caller_data;
+    }
 
     return TFM_RPC_SUCCESS;
 }
@@ -105,6 +338,8 @@ void tfm_rpc_unregister_ops(void)
 {
     rpc_ops.handle_req = default_handle_req;
     rpc_ops.reply = default_mailbox_reply;
+    rpc_ops.reply_direct = NULL;
+    rpc_ops.notify = NULL;
     rpc_ops.get_caller_data = default_get_caller_data;
 }
 
@@ -118,9 +353,18 @@ void tfm_rpc_client_call_reply(const void *owner, int32_t ret)
     const struct conn_handle_t *handle = (const struct conn_handle_t *)owner;
 
     rpc_ops.reply(handle->caller_data, ret);
+
+    if (rpc_ops.notify) {
+        rpc_ops.notify();
+    }
 }
 
 void tfm_rpc_set_caller_data(struct conn_handle_t *handle, int32_t client_id)
 {
+    if (dispatch_caller_data) {
+        handle->caller_data = dispatch_caller_data;
+        return;
+    }
+
     handle->caller_data = rpc_ops.get_caller_data(client_id);
 }
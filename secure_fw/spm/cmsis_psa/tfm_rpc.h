@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2022 Cypress Semiconductor Corporation (an Infineon company)
  * or an affiliate of Cypress Semiconductor Corporation. All rights reserved.
  *
@@ -28,6 +28,14 @@
 #define TFM_RPC_SUCCESS             (0)
 #define TFM_RPC_INVAL_PARAM         (INT32_MIN + 1)
 #define TFM_RPC_CONFLICT_CALLBACK   (INT32_MIN + 2)
+#define TFM_RPC_REPLY_PENDING       (1)
+
+/* PSA client call types which the inter-core transports deliver to SPM */
+#define TFM_RPC_PSA_FRAMEWORK_VERSION       (0x1)
+#define TFM_RPC_PSA_VERSION                 (0x2)
+#define TFM_RPC_PSA_CONNECT                 (0x3)
+#define TFM_RPC_PSA_CALL                    (0x4)
+#define TFM_RPC_PSA_CLOSE                   (0x5)
 
 /*
  * This structure holds the parameters used in a PSA client call.
@@ -49,18 +57,57 @@ struct client_call_params_t {
  * the specific operations to complete the RPC functionalities.
  *
  * It includes the following operations:
- * handle_req() - Handle PSA client call request from NSPE
+ * handle_req() - Receive PSA client call requests from NSPE. The requests are
+ *                usually submitted to the TF-M RPC request pool and dispatched
+ *                by \ref tfm_rpc_req_dispatch.
  * reply()      - Reply PSA client call return result to NSPE. The parameter
  *                owner identifies the owner of the PSA client call.
+ * reply_direct() - Reply the result of a request which TF-M RPC completes
+ *                  without delivering it to a service, such as a version query
+ *                  or a rejected call. Optional. reply() is used if it is not
+ *                  provided.
+ * notify()     - Notify NSPE of the replies written since the last
+ *                notification. Optional. If it is provided, reply() and
+ *                reply_direct() only write the results, and TF-M RPC notifies
+ *                NSPE once per batch of replies.
  * get_caller_data() - Get the private data of NSPE client from mailbox to
- *                     identify the PSA client call.
+ *                     identify the PSA client call. Optional if the mailbox
+ *                     delivers the requests via \ref tfm_rpc_dispatch, which
+ *                     takes the private data directly.
  */
 struct tfm_rpc_ops_t {
     void (*handle_req)(void);
     void (*reply)(const void *owner, int32_t ret);
+    void (*reply_direct)(const void *owner, int32_t ret);
+    void (*notify)(void);
     const void * (*get_caller_data)(int32_t client_id);
 };
 
+/*
+ * Number of requests in the TF-M RPC request pool. A transport which receives
+ * more requests at once dispatches the pool when it is full.
+ */
+#ifndef TFM_RPC_REQ_POOL_SIZE
+#define TFM_RPC_REQ_POOL_SIZE       8
+#endif
+
+/* A PSA client call request received by the underlying mailbox */
+struct tfm_rpc_req_t {
+    uint32_t                    call_type;   /* TFM_RPC_PSA_* */
+    struct client_call_params_t params;
+    const void                  *caller_data; /* Passed back to reply() */
+    int32_t                     client_id;   /* Non-secure client ID, 0 if
+                                              * unknown
+                                              */
+    const void                  *local_buf;  /* SPE copy of the vectors which
+                                              * SPM should accept as
+                                              * non-secure memory. NULL if
+                                              * none.
+                                              */
+    size_t                      local_size;  /* Size of local_buf */
+    uint8_t                     priority;    /* Set by TF-M RPC */
+};
+
 /**
  * \brief RPC handler for \ref psa_framework_version.
  *
@@ -124,6 +171,63 @@ psa_status_t tfm_rpc_psa_call(const struct client_call_params_t *params);
  */
 void tfm_rpc_psa_close(const struct client_call_params_t *params);
 
+/**
+ * \brief Deliver a PSA client call request received by the underlying mailbox
+ *        to SPM.
+ *
+ * \param[in]  call_type        The PSA client call type, TFM_RPC_PSA_*.
+ * \param[in]  params           Base address of parameters
+ * \param[in]  caller_data      The private data of the request in mailbox.
+ *                              It is passed back to reply() of the mailbox
+ *                              operations when SPM completes the request.
+ * \param[out] reply            The return result of the request, valid only
+ *                              if \ref TFM_RPC_SUCCESS is returned.
+ *
+ * \retval TFM_RPC_SUCCESS      The request is completed. The mailbox should
+ *                              return \p reply to the caller.
+ * \retval TFM_RPC_REPLY_PENDING The request is delivered. SPM will return the
+ *                              result via reply() of the mailbox operations.
+ * \retval TFM_RPC_INVAL_PARAM  The call type is not supported.
+ */
+int32_t tfm_rpc_dispatch(uint32_t call_type,
+                         const struct client_call_params_t *params,
+                         const void *caller_data, int32_t *reply);
+
+/**
+ * \brief Allocate a request in the TF-M RPC request pool.
+ *
+ * \note The request is only taken from the pool by \ref tfm_rpc_req_submit.
+ *       A request which is not submitted is allocated again by the next call.
+ *       The pool is only used in handle_req() of the mailbox operations.
+ *
+ * \retval NULL                 The pool is full. Dispatch the submitted
+ *                              requests first.
+ * \retval Other                The request to be filled, cleared to zero.
+ */
+struct tfm_rpc_req_t *tfm_rpc_req_alloc(void);
+
+/**
+ * \brief Submit the request last allocated by \ref tfm_rpc_req_alloc. The
+ *        requests are ordered by the priority of the requested service.
+ *
+ * \param[in] req               The request filled by the mailbox.
+ */
+void tfm_rpc_req_submit(struct tfm_rpc_req_t *req);
+
+/**
+ * \brief Dispatch the submitted requests to SPM in priority order, then empty
+ *        the pool. The requests of equal priority are dispatched in the order
+ *        of submission.
+ *
+ * \note The results completed at once are returned via reply_direct() of the
+ *       mailbox operations, and the others via reply() when SPM completes
+ *       them. NSPE is notified of the results completed at once via notify()
+ *       after all the requests are dispatched.
+ *
+ * \return The number of requests dispatched.
+ */
+uint32_t tfm_rpc_req_dispatch(void);
+
 /**
  * \brief Register underlying mailbox communication operations.
  *
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
@@ -8,6 +8,7 @@
 
 #include "cmsis_compiler.h"
 
+#include "critical_section.h"
 #include "psa/error.h"
 #include "utilities.h"
 #include "tfm_arch.h"
@@ -18,76 +19,88 @@
 
 static struct secure_mailbox_queue_t spe_mailbox_queue;
 
-static int32_t tfm_mailbox_dispatch(uint32_t call_type,
-                                    const struct psa_client_params_t *params,
-                                    int32_t client_id,
-                                    psa_status_t *psa_ret)
-{
-    struct client_call_params_t spm_params = {0};
+/* Statistics of the replies notified to NSPE */
+static struct mailbox_notify_stats_t notify_stats;
+
+/* Number of the replies written since the last notification */
+static uint32_t nr_unnotified_replies;
 
-    SPM_ASSERT(params != NULL);
-    SPM_ASSERT(psa_ret != NULL);
+/* The mailbox call types are delivered to TF-M RPC as they are */
+#if (MAILBOX_PSA_FRAMEWORK_VERSION != TFM_RPC_PSA_FRAMEWORK_VERSION) || \
+    (MAILBOX_PSA_VERSION != TFM_RPC_PSA_VERSION) || \
+    (MAILBOX_PSA_CONNECT != TFM_RPC_PSA_CONNECT) || \
+    (MAILBOX_PSA_CALL != TFM_RPC_PSA_CALL) || \
+    (MAILBOX_PSA_CLOSE != TFM_RPC_PSA_CLOSE)
+#error "Mailbox PSA client call types mismatch TF-M RPC ones"
+#endif
+
+/*
+ * Submit a message taken into a SPE slot to TF-M RPC, which dispatches the
+ * requests by the priority of the requested service.
+ */
+static void mailbox_submit_msg(uint8_t idx, struct tfm_rpc_req_t *req)
+{
+    struct secure_mailbox_slot_t *slot = &spe_mailbox_queue.queue[idx];
+    const struct psa_client_params_t *params = &slot->msg.params;
 
-    (void)client_id;
+    req->call_type = slot->msg.call_type;
 
-    switch (call_type) {
-    case MAILBOX_PSA_FRAMEWORK_VERSION:
-        *psa_ret = tfm_rpc_psa_framework_version();
-        return MAILBOX_SUCCESS;
+    switch (req->call_type) {
     case MAILBOX_PSA_VERSION:
-        spm_params.sid = params->psa_version_params.sid;
-        *psa_ret = tfm_rpc_psa_version(&spm_params);
-        return MAILBOX_SUCCESS;
+        req->params.sid = params->psa_version_params.sid;
+        break;
     case MAILBOX_PSA_CALL:
-        spm_params.handle = params->psa_call_params.handle;
-        spm_params.type = params->psa_call_params.type;
-        spm_params.in_vec = params->psa_call_params.in_vec;
-        spm_params.in_len = params->psa_call_params.in_len;
-        spm_params.out_vec = params->psa_call_params.out_vec;
-        spm_params.out_len = params->psa_call_params.out_len;
-        *psa_ret = tfm_rpc_psa_call(&spm_params);
-        return MAILBOX_SUCCESS;
-/* Following cases are only needed by connection-based services */
-#if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
+        req->params.handle = params->psa_call_params.handle;
+        req->params.type = params->psa_call_params.type;
+        req->params.in_vec = params->psa_call_params.in_vec;
+        req->params.in_len = params->psa_call_params.in_len;
+        req->params.out_vec = params->psa_call_params.out_vec;
+        req->params.out_len = params->psa_call_params.out_len;
+        break;
     case MAILBOX_PSA_CONNECT:
-        spm_params.sid = params->psa_connect_params.sid;
-        spm_params.version = params->psa_connect_params.version;
-        *psa_ret = tfm_rpc_psa_connect(&spm_params);
-        return MAILBOX_SUCCESS;
+        req->params.sid = params->psa_connect_params.sid;
+        req->params.version = params->psa_connect_params.version;
+        break;
     case MAILBOX_PSA_CLOSE:
-        spm_params.handle = params->psa_close_params.handle;
-        tfm_rpc_psa_close(&spm_params);
-        return MAILBOX_SUCCESS;
-#endif /* CONFIG_TFM_CONNECTION_BASED_SERVICE_API */
+        req->params.handle = params->psa_close_params.handle;
+        break;
     default:
-        return MAILBOX_INVAL_PARAMS;
+        break;
     }
-}
 
-__STATIC_INLINE void set_spe_queue_empty_status(uint8_t idx)
-{
-    if (idx < NUM_MAILBOX_QUEUE_SLOT) {
-        spe_mailbox_queue.empty_slots |= (1 << idx);
-    }
-}
+    /* The slot handle identifies the message when SPM replies to it */
+    req->caller_data = &slot->msg_handle;
 
-__STATIC_INLINE void clear_spe_queue_empty_status(uint8_t idx)
-{
-    if (idx < NUM_MAILBOX_QUEUE_SLOT) {
-        spe_mailbox_queue.empty_slots &= ~(1 << idx);
+#if MAILBOX_NS_BUF_CACHE_CLIENTS > 0
+    /* Non-secure clients usually pass the same buffers call after call */
+    req->client_id = slot->msg.client_id;
+#endif
+
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    /*
+     * SPM checks the vectors against the non-secure caller. Only the copy of
+     * the inline payload of this message is accepted in addition.
+     */
+    if (slot->is_inline) {
+        req->local_buf = &slot->inline_buf;
+        req->local_size = sizeof(slot->inline_buf);
     }
+#endif
+
+    tfm_rpc_req_submit(req);
 }
 
 __STATIC_INLINE bool get_spe_queue_empty_status(uint8_t idx)
 {
-    if ((idx < NUM_MAILBOX_QUEUE_SLOT) &&
-        (spe_mailbox_queue.empty_slots & (1 << idx))) {
+    if ((idx >= NUM_MAILBOX_QUEUE_SLOT) ||
+        (spe_mailbox_queue.queue[idx].msg_handle == MAILBOX_MSG_NULL_HANDLE)) {
         return true;
     }
 
     return false;
 }
 
+#ifndef TFM_MULTI_CORE_MAILBOX_RING
 __STATIC_INLINE mailbox_queue_status_t get_nspe_queue_pend_status(
                                     const struct ns_mailbox_queue_t *ns_queue)
 {
@@ -107,6 +120,7 @@ __STATIC_INLINE void clear_nspe_queue_pend_status(
 {
     ns_queue->pend_slots &= ~mask;
 }
+#endif /* TFM_MULTI_CORE_MAILBOX_RING */
 
 __STATIC_INLINE int32_t get_spe_mailbox_msg_handle(uint8_t idx,
                                                    mailbox_msg_handle_t *handle)
@@ -132,17 +146,78 @@ __STATIC_INLINE int32_t get_spe_mailbox_msg_idx(mailbox_msg_handle_t handle,
     return MAILBOX_SUCCESS;
 }
 
+/*
+ * Take an empty SPE mailbox queue slot. The slot is marked in use by its
+ * message handle. Replies may free slots from another context, so the stack of
+ * empty slots is only accessed in critical section.
+ */
+static int32_t mailbox_alloc_queue_slot(uint8_t *idx)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    int32_t ret = MAILBOX_QUEUE_FULL;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    if (spe_mailbox_queue.nr_free_slots > 0) {
+        spe_mailbox_queue.nr_free_slots--;
+        *idx = spe_mailbox_queue.free_slots[spe_mailbox_queue.nr_free_slots];
+        get_spe_mailbox_msg_handle(*idx,
+                                   &spe_mailbox_queue.queue[*idx].msg_handle);
+        ret = MAILBOX_SUCCESS;
+    }
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
+
+    return ret;
+}
+
 static void mailbox_clean_queue_slot(uint8_t idx)
 {
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+
     if (idx >= NUM_MAILBOX_QUEUE_SLOT) {
         return;
     }
 
-    spm_memset(&spe_mailbox_queue.queue[idx], 0,
-                         sizeof(spe_mailbox_queue.queue[idx]));
-    set_spe_queue_empty_status(idx);
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    if (!get_spe_queue_empty_status(idx)) {
+        spm_memset(&spe_mailbox_queue.queue[idx], 0,
+                   sizeof(spe_mailbox_queue.queue[idx]));
+        spe_mailbox_queue.free_slots[spe_mailbox_queue.nr_free_slots] = idx;
+        spe_mailbox_queue.nr_free_slots++;
+    }
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
 }
 
+#ifdef TFM_MULTI_CORE_MAILBOX_RING
+static void mailbox_direct_reply(uint8_t idx, uint32_t result)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
+
+    if (idx >= NUM_MAILBOX_QUEUE_SLOT) {
+        return;
+    }
+
+    /*
+     * Both the mailbox agent and the SPM reply path produce completions. They
+     * are serialized by a SPE local critical section. No lock is shared with
+     * NSPE. The ring cannot be full since NSPE has no more outstanding
+     * requests than ring entries. A corrupted ring just loses the completion.
+     */
+    CRITICAL_SECTION_ENTER(cs_assert);
+
+    (void)mailbox_cpl_ring_put(&ns_queue->cpl_ring,
+                               spe_mailbox_queue.queue[idx].ns_slot_idx,
+                               (int32_t)result);
+
+    CRITICAL_SECTION_LEAVE(cs_assert);
+
+    mailbox_clean_queue_slot(idx);
+}
+#else /* TFM_MULTI_CORE_MAILBOX_RING */
 __STATIC_INLINE struct mailbox_reply_t *get_nspe_reply_addr(uint8_t idx)
 {
     uint8_t ns_slot_idx;
@@ -173,6 +248,7 @@ static void mailbox_direct_reply(uint8_t idx, uint32_t result)
      * Update NSPE queue status after all the mailbox messages are completed
      */
 }
+#endif /* TFM_MULTI_CORE_MAILBOX_RING */
 
 __STATIC_INLINE int32_t check_mailbox_msg(const struct mailbox_msg_t *msg)
 {
@@ -184,119 +260,161 @@ __STATIC_INLINE int32_t check_mailbox_msg(const struct mailbox_msg_t *msg)
     return MAILBOX_SUCCESS;
 }
 
-int32_t tfm_mailbox_handle_msg(void)
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+__STATIC_INLINE struct mailbox_payload_t *get_nspe_payload_addr(uint8_t idx)
 {
-    uint8_t idx;
-    int32_t result;
-    psa_status_t psa_ret = PSA_ERROR_GENERIC_ERROR;
-    mailbox_queue_status_t mask_bits, pend_slots, reply_slots = 0;
-    struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
-    struct mailbox_msg_t *msg_ptr;
+    uint8_t ns_slot_idx = spe_mailbox_queue.queue[idx].ns_slot_idx;
 
-    SPM_ASSERT(ns_queue != NULL);
+#ifdef TFM_MULTI_CORE_MAILBOX_RING
+    return &spe_mailbox_queue.ns_queue->payload[ns_slot_idx];
+#else
+    return &spe_mailbox_queue.ns_queue->queue[ns_slot_idx].payload;
+#endif
+}
 
-    tfm_mailbox_hal_enter_critical();
+/*
+ * Copy the inline payload of a psa_call() into the SPE slot and turn the
+ * message into a plain psa_call() whose vectors point to the copy. The copy
+ * prevents NSPE from changing the data after it is checked.
+ */
+static int32_t mailbox_unpack_inline_payload(uint8_t idx)
+{
+    struct secure_mailbox_slot_t *slot = &spe_mailbox_queue.queue[idx];
+    struct secure_mailbox_inline_buf_t *buf = &slot->inline_buf;
+    const struct mailbox_payload_t *ns_payload = get_nspe_payload_addr(idx);
+    uint32_t size[PSA_MAX_IOVEC];
+    size_t in_len = slot->msg.params.psa_call_params.in_len;
+    size_t out_len = slot->msg.params.psa_call_params.out_len;
+    size_t offset = 0, in_size = 0;
+    size_t i;
+
+    if ((in_len > PSA_MAX_IOVEC) || (out_len > PSA_MAX_IOVEC - in_len)) {
+        return MAILBOX_INVAL_PARAMS;
+    }
 
-    pend_slots = get_nspe_queue_pend_status(ns_queue);
+    spm_memcpy(size, ns_payload->size, sizeof(size));
 
-    tfm_mailbox_hal_exit_critical();
+    for (i = 0; i < in_len + out_len; i++) {
+        if (size[i] > MAILBOX_INLINE_PAYLOAD_SIZE - offset) {
+            return MAILBOX_INVAL_PARAMS;
+        }
 
-    /* Check if NSPE mailbox did assert a PSA client call request */
-    if (!pend_slots) {
-        return MAILBOX_NO_PEND_EVENT;
+        if (i < in_len) {
+            buf->in_vec[i].base = &buf->data[offset];
+            buf->in_vec[i].len = size[i];
+            in_size += size[i];
+        } else {
+            buf->out_vec[i - in_len].base = &buf->data[offset];
+            buf->out_vec[i - in_len].len = size[i];
+        }
+
+        offset += size[i];
     }
 
-    for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
-        mask_bits = (1 << idx);
-        /* Check if current NSPE mailbox queue slot is pending for handling */
-        if (!(pend_slots & mask_bits)) {
-            continue;
-        }
+    /* Only the input vectors carry data */
+    spm_memcpy(buf->data, ns_payload->data, in_size);
 
-        /*
-         * TODO
-         * The operations are simplified here. Use the SPE mailbox queue
-         * slot with the same idx as that of the NSPE mailbox queue slot.
-         * A more general implementation should dynamically search and
-         * select an empty SPE mailbox queue slot.
-         */
-        clear_spe_queue_empty_status(idx);
-        spe_mailbox_queue.queue[idx].ns_slot_idx = idx;
+    slot->msg.call_type = MAILBOX_PSA_CALL;
+    slot->msg.params.psa_call_params.in_vec = buf->in_vec;
+    slot->msg.params.psa_call_params.out_vec = buf->out_vec;
+    slot->is_inline = true;
 
-        msg_ptr = &spe_mailbox_queue.queue[idx].msg;
-        spm_memcpy(msg_ptr, &ns_queue->queue[idx].msg, sizeof(*msg_ptr));
+    return MAILBOX_SUCCESS;
+}
 
-        if (check_mailbox_msg(msg_ptr) != MAILBOX_SUCCESS) {
-            mailbox_clean_queue_slot(idx);
-            continue;
-        }
+/*
+ * Write the output vectors of an inline psa_call() back to NSPE. SPM has
+ * updated the sizes of the output vectors in the SPE slot.
+ */
+static void mailbox_reply_inline_payload(uint8_t idx)
+{
+    struct secure_mailbox_slot_t *slot = &spe_mailbox_queue.queue[idx];
+    struct secure_mailbox_inline_buf_t *buf = &slot->inline_buf;
+    struct mailbox_payload_t *ns_payload;
+    size_t in_len = slot->msg.params.psa_call_params.in_len;
+    size_t out_len = slot->msg.params.psa_call_params.out_len;
+    size_t offset;
+    size_t i;
+
+    if (!slot->is_inline) {
+        return;
+    }
 
-        get_spe_mailbox_msg_handle(idx,
-                                   &spe_mailbox_queue.queue[idx].msg_handle);
+    ns_payload = get_nspe_payload_addr(idx);
 
-        /*
-         * Set the current slot index under processing.
-         * The value is used in mailbox_get_caller_data() to identify the
-         * mailbox queue slot.
-         */
-        spe_mailbox_queue.cur_proc_slot_idx = idx;
+    for (i = 0; i < out_len; i++) {
+        offset = (uint8_t *)buf->out_vec[i].base - buf->data;
+        spm_memcpy(&ns_payload->data[offset], buf->out_vec[i].base,
+                   buf->out_vec[i].len);
+        ns_payload->size[in_len + i] = (uint32_t)buf->out_vec[i].len;
+    }
 
-        result = tfm_mailbox_dispatch(msg_ptr->call_type, &msg_ptr->params,
-                                      msg_ptr->client_id, &psa_ret);
-        if (result != MAILBOX_SUCCESS) {
-            mailbox_clean_queue_slot(idx);
-            continue;
-        }
+    ns_payload->nr_out_replied = (uint32_t)out_len;
+}
+#endif /* MAILBOX_INLINE_PAYLOAD_SIZE > 0 */
 
-        /* Clean up the current slot index under processing */
-        spe_mailbox_queue.cur_proc_slot_idx = NUM_MAILBOX_QUEUE_SLOT;
+/*
+ * Check a message taken into a SPE slot and prepare it for dispatch.
+ * The NSPE slot index of the message should be set already.
+ */
+static int32_t mailbox_prepare_msg(uint8_t idx)
+{
+    struct secure_mailbox_slot_t *slot = &spe_mailbox_queue.queue[idx];
+    int32_t ret;
 
-        if ((msg_ptr->call_type == MAILBOX_PSA_FRAMEWORK_VERSION) ||
-            (msg_ptr->call_type == MAILBOX_PSA_VERSION)) {
-            /*
-             * Directly write the result to NSPE for psa_framework_version() and
-             * psa_version().
-             */
-            reply_slots |= (1 << idx);
+    ret = check_mailbox_msg(&slot->msg);
+    if (ret != MAILBOX_SUCCESS) {
+        return ret;
+    }
 
-            mailbox_direct_reply(idx, (uint32_t)psa_ret);
-        } else if ((msg_ptr->call_type == MAILBOX_PSA_CONNECT) ||
-                   (msg_ptr->call_type == MAILBOX_PSA_CALL)) {
-            /*
-             * If it failed to deliver psa_connect() or psa_call() request to
-             * TF-M IPC SPM, the failure result should be returned immediately.
-             */
-            if (psa_ret != PSA_SUCCESS) {
-                reply_slots |= (1 << idx);
-                mailbox_direct_reply(idx, (uint32_t)psa_ret);
-            }
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    if (slot->msg.call_type == MAILBOX_PSA_CALL_INLINE) {
+        ret = mailbox_unpack_inline_payload(idx);
+        if (ret != MAILBOX_SUCCESS) {
+            return ret;
         }
-        /*
-         * Skip checking psa_call() since it neither returns immediately nor
-         * has return value.
-         */
     }
+#endif
 
-    tfm_mailbox_hal_enter_critical();
-
-    /* Clean the NSPE mailbox pending status. */
-    clear_nspe_queue_pend_status(ns_queue, pend_slots);
-
-    /* Set the NSPE mailbox replied status */
-    set_nspe_queue_replied_status(ns_queue, reply_slots);
+    return MAILBOX_SUCCESS;
+}
 
-    tfm_mailbox_hal_exit_critical();
+/*
+ * Notify NSPE of the replies written since the last notification.
+ * The replies written in a batch share a single notification.
+ */
+static void mailbox_notify_replies(void)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+    uint32_t nr_replies;
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+    nr_replies = nr_unnotified_replies;
+    nr_unnotified_replies = 0;
+    if (nr_replies > 0) {
+        notify_stats.nr_msgs += nr_replies;
+        notify_stats.nr_notify++;
+    }
+    CRITICAL_SECTION_LEAVE(cs_assert);
 
-    if (reply_slots) {
+    if (nr_replies > 0) {
         tfm_mailbox_hal_notify_peer();
     }
-
-    return MAILBOX_SUCCESS;
 }
 
-int32_t tfm_mailbox_reply_msg(mailbox_msg_handle_t handle, int32_t reply)
+/*
+ * Write the result of a message to NSPE and free its SPE slot. NSPE is
+ * notified later by mailbox_notify_replies(). The output vectors of an inline
+ * psa_call() are only written back if the call reached the service.
+ */
+static int32_t mailbox_write_reply(mailbox_msg_handle_t handle, int32_t reply,
+                                   bool is_delivered)
 {
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
     uint8_t idx;
+#ifndef TFM_MULTI_CORE_MAILBOX_RING
+    uint8_t ns_idx;
+#endif
     int32_t ret;
     struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
 
@@ -321,71 +439,315 @@ int32_t tfm_mailbox_reply_msg(mailbox_msg_handle_t handle, int32_t reply)
         return MAILBOX_NO_PEND_EVENT;
     }
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    if (is_delivered) {
+        mailbox_reply_inline_payload(idx);
+    }
+#else
+    (void)is_delivered;
+#endif
+
+#ifdef TFM_MULTI_CORE_MAILBOX_RING
+    mailbox_direct_reply(idx, (uint32_t)reply);
+#else
+    /* The SPE slot is cleaned by the reply */
+    ns_idx = spe_mailbox_queue.queue[idx].ns_slot_idx;
+
     mailbox_direct_reply(idx, (uint32_t)reply);
 
     tfm_mailbox_hal_enter_critical();
 
     /* Set the NSPE mailbox replied status */
-    set_nspe_queue_replied_status(ns_queue, (1 << idx));
+    set_nspe_queue_replied_status(ns_queue, (1 << ns_idx));
 
     tfm_mailbox_hal_exit_critical();
+#endif /* TFM_MULTI_CORE_MAILBOX_RING */
 
-    tfm_mailbox_hal_notify_peer();
+    CRITICAL_SECTION_ENTER(cs_assert);
+    nr_unnotified_replies++;
+    CRITICAL_SECTION_LEAVE(cs_assert);
 
     return MAILBOX_SUCCESS;
 }
 
+/*
+ * Reply an error to a message which cannot be dispatched, so that the NSPE
+ * caller does not wait forever and its NSPE slot is freed. The reply is
+ * notified together with the other replies.
+ */
+static void mailbox_reply_invalid_msg(uint8_t idx)
+{
+    (void)mailbox_write_reply(spe_mailbox_queue.queue[idx].msg_handle,
+                              PSA_ERROR_PROGRAMMER_ERROR, false);
+}
+
+#ifdef TFM_MULTI_CORE_MAILBOX_RING
+int32_t tfm_mailbox_handle_msg(void)
+{
+    uint8_t idx;
+    uint32_t token, nr_taken, nr_invalid;
+    struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
+    struct mailbox_req_ring_t *req_ring;
+    struct secure_mailbox_slot_t *slot;
+    struct tfm_rpc_req_t *req;
+
+    SPM_ASSERT(ns_queue != NULL);
+
+    req_ring = &ns_queue->req_ring;
+
+    if (mailbox_req_ring_is_empty(req_ring)) {
+        return MAILBOX_NO_PEND_EVENT;
+    }
+
+    /*
+     * NSPE may skip notifying SPE of the requests put while SPE is busy. Keep
+     * draining the ring until it is empty after SPE is marked idle again, so
+     * that no request is left without a notification.
+     */
+    do {
+        nr_taken = 0;
+        nr_invalid = 0;
+
+        mailbox_req_ring_set_consumer_busy(req_ring, true);
+
+        /*
+         * The mailbox agent is the only consumer of the request ring, so the
+         * ring is drained without any lock shared with NSPE. The requests are
+         * copied out of the ring, then submitted to TF-M RPC.
+         */
+        while ((req = tfm_rpc_req_alloc()) != NULL) {
+            /*
+             * The SPE queue is as deep as the ring so it cannot run out of
+             * slots. If it does, the remaining requests are left in the ring.
+             */
+            if (mailbox_alloc_queue_slot(&idx) != MAILBOX_SUCCESS) {
+                break;
+            }
+
+            slot = &spe_mailbox_queue.queue[idx];
+
+            if (!mailbox_req_ring_get(req_ring, &slot->msg, &token)) {
+                mailbox_clean_queue_slot(idx);
+                break;
+            }
+
+            nr_taken++;
+
+            /* The token is returned to NSPE as it is. It must fit the slot. */
+            if (token >= MAILBOX_RING_DEPTH) {
+                mailbox_clean_queue_slot(idx);
+                continue;
+            }
+
+            slot->ns_slot_idx = (uint8_t)token;
+
+            if (mailbox_prepare_msg(idx) != MAILBOX_SUCCESS) {
+                mailbox_reply_invalid_msg(idx);
+                nr_invalid++;
+                continue;
+            }
+
+            mailbox_submit_msg(idx, req);
+        }
+
+        tfm_rpc_req_dispatch();
+
+        /* The error replies are notified even if no request is dispatched */
+        if (nr_invalid > 0) {
+            mailbox_notify_replies();
+        }
+
+        mailbox_req_ring_set_consumer_busy(req_ring, false);
+    } while ((nr_taken > 0) && !mailbox_req_ring_is_empty(req_ring));
+
+    return MAILBOX_SUCCESS;
+}
+#else /* TFM_MULTI_CORE_MAILBOX_RING */
+int32_t tfm_mailbox_handle_msg(void)
+{
+    uint8_t idx, ns_idx;
+    mailbox_queue_status_t mask_bits, pend_slots, taken_slots, invalid_slots;
+    struct ns_mailbox_queue_t *ns_queue = spe_mailbox_queue.ns_queue;
+    struct secure_mailbox_slot_t *slot;
+    struct tfm_rpc_req_t *req;
+
+    SPM_ASSERT(ns_queue != NULL);
+
+    tfm_mailbox_hal_enter_critical();
+
+    pend_slots = get_nspe_queue_pend_status(ns_queue);
+
+    tfm_mailbox_hal_exit_critical();
+
+    /* Check if NSPE mailbox did assert a PSA client call request */
+    if (!pend_slots) {
+        return MAILBOX_NO_PEND_EVENT;
+    }
+
+    /*
+     * NSPE may skip notifying SPE of the requests submitted while other slots
+     * are still pending. Keep handling until no slot is pending, so that no
+     * request is left without a notification.
+     */
+    do {
+        taken_slots = 0;
+        invalid_slots = 0;
+
+        /*
+         * Take the pending requests into empty SPE mailbox queue slots and
+         * submit them to TF-M RPC. The messages are copied so that NSPE cannot
+         * change them after they are checked.
+         */
+        for (ns_idx = 0; ns_idx < NUM_MAILBOX_QUEUE_SLOT; ns_idx++) {
+            mask_bits = (1 << ns_idx);
+            /* Check if current NSPE mailbox queue slot is pending */
+            if (!(pend_slots & mask_bits)) {
+                continue;
+            }
+
+            req = tfm_rpc_req_alloc();
+            if (!req) {
+                break;
+            }
+
+            /*
+             * The SPE queue is as deep as the NSPE one so it cannot run out
+             * of slots. If it does, the remaining requests are left pending.
+             */
+            if (mailbox_alloc_queue_slot(&idx) != MAILBOX_SUCCESS) {
+                break;
+            }
+
+            taken_slots |= mask_bits;
+
+            slot = &spe_mailbox_queue.queue[idx];
+            slot->ns_slot_idx = ns_idx;
+
+            spm_memcpy(&slot->msg, &ns_queue->queue[ns_idx].msg,
+                       sizeof(slot->msg));
+
+            if (mailbox_prepare_msg(idx) != MAILBOX_SUCCESS) {
+                invalid_slots |= (1 << idx);
+                continue;
+            }
+
+            mailbox_submit_msg(idx, req);
+        }
+
+        /*
+         * Clean the NSPE mailbox pending status of the requests taken before
+         * they are dispatched. SPM may reply to a request before the others
+         * are dispatched, and NSPE may then submit a new request in the same
+         * NSPE slot, whose pending status must be kept.
+         */
+        tfm_mailbox_hal_enter_critical();
+        clear_nspe_queue_pend_status(ns_queue, taken_slots);
+        tfm_mailbox_hal_exit_critical();
+
+        /*
+         * The invalid requests are replied with an error once their pending
+         * status is cleaned, for the same reason.
+         */
+        for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+            if (invalid_slots & (1 << idx)) {
+                mailbox_reply_invalid_msg(idx);
+            }
+        }
+
+        tfm_rpc_req_dispatch();
+
+        /* The error replies are notified even if no request is dispatched */
+        if (invalid_slots) {
+            mailbox_notify_replies();
+        }
+
+        tfm_mailbox_hal_enter_critical();
+
+        /* Fetch the requests submitted in the meantime */
+        pend_slots = get_nspe_queue_pend_status(ns_queue);
+
+        tfm_mailbox_hal_exit_critical();
+    } while (taken_slots && pend_slots);
+
+    return MAILBOX_SUCCESS;
+}
+#endif /* TFM_MULTI_CORE_MAILBOX_RING */
+
+int32_t tfm_mailbox_reply_msg(mailbox_msg_handle_t handle, int32_t reply)
+{
+    int32_t ret;
+
+    ret = mailbox_write_reply(handle, reply, true);
+    if (ret != MAILBOX_SUCCESS) {
+        return ret;
+    }
+
+    mailbox_notify_replies();
+
+    return MAILBOX_SUCCESS;
+}
+
+void tfm_mailbox_get_notify_stats(struct mailbox_notify_stats_t *stats)
+{
+    struct critical_section_t cs_assert = CRITICAL_SECTION_STATIC_INIT;
+
+    SPM_ASSERT(stats != NULL);
+
+    CRITICAL_SECTION_ENTER(cs_assert);
+    spm_memcpy(stats, &notify_stats, sizeof(*stats));
+    CRITICAL_SECTION_LEAVE(cs_assert);
+}
+
 /* RPC handle_req() callback */
 static void mailbox_handle_req(void)
 {
     (void)tfm_mailbox_handle_msg();
 }
 
-/* RPC reply() callback */
-static void mailbox_reply(const void *owner, int32_t ret)
+__STATIC_INLINE mailbox_msg_handle_t mailbox_owner_handle(const void *owner)
 {
-    mailbox_msg_handle_t handle = MAILBOX_MSG_NULL_HANDLE;
-
     /* If the owner is specified */
     if (owner) {
-        handle = *((mailbox_msg_handle_t *)owner);
+        return *((mailbox_msg_handle_t *)owner);
     }
 
-    (void)tfm_mailbox_reply_msg(handle, ret);
+    return MAILBOX_MSG_NULL_HANDLE;
 }
 
-/* RPC get_caller_data() callback */
-static const void *mailbox_get_caller_data(int32_t client_id)
+/* RPC reply() callback */
+static void mailbox_reply(const void *owner, int32_t ret)
 {
-    uint8_t idx;
-
-    (void)client_id;
-
-    idx = spe_mailbox_queue.cur_proc_slot_idx;
-    if (idx < NUM_MAILBOX_QUEUE_SLOT) {
-        return (const void *)&spe_mailbox_queue.queue[idx].msg_handle;
-    }
+    (void)mailbox_write_reply(mailbox_owner_handle(owner), ret, true);
+}
 
-    return NULL;
+/* RPC reply_direct() callback */
+static void mailbox_reply_direct(const void *owner, int32_t ret)
+{
+    (void)mailbox_write_reply(mailbox_owner_handle(owner), ret, false);
 }
 
 /* Mailbox specific operations callback for TF-M RPC */
 static const struct tfm_rpc_ops_t mailbox_rpc_ops = {
-    .handle_req = mailbox_handle_req,
-    .reply      = mailbox_reply,
-    .get_caller_data = mailbox_get_caller_data,
+    .handle_req   = mailbox_handle_req,
+    .reply        = mailbox_reply,
+    .reply_direct = mailbox_reply_direct,
+    .notify       = mailbox_notify_replies,
 };
 
 int32_t tfm_mailbox_init(void)
 {
     int32_t ret;
+    uint8_t idx;
 
     spm_memset(&spe_mailbox_queue, 0, sizeof(spe_mailbox_queue));
+    nr_unnotified_replies = 0;
 
-    spe_mailbox_queue.empty_slots =
-            (mailbox_queue_status_t)((1UL << (NUM_MAILBOX_QUEUE_SLOT - 1)) - 1);
-    spe_mailbox_queue.empty_slots +=
-            (mailbox_queue_status_t)(1UL << (NUM_MAILBOX_QUEUE_SLOT - 1));
+    /* Lower slots are popped first */
+    for (idx = 0; idx < NUM_MAILBOX_QUEUE_SLOT; idx++) {
+        spe_mailbox_queue.free_slots[idx] =
+                                (uint8_t)(NUM_MAILBOX_QUEUE_SLOT - 1 - idx);
+    }
+    spe_mailbox_queue.nr_free_slots = NUM_MAILBOX_QUEUE_SLOT;
 
     /* Register RPC callbacks */
     ret = tfm_rpc_register_ops(&mailbox_rpc_ops);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -15,24 +15,45 @@ typedef int32_t    mailbox_msg_handle_t;
 
 #define MAILBOX_MSG_NULL_HANDLE          ((mailbox_msg_handle_t)0)
 
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+/*
+ * SPE copy of the inline payload of a psa_call(). The vectors passed to SPM
+ * point into it.
+ */
+struct secure_mailbox_inline_buf_t {
+    psa_invec            in_vec[PSA_MAX_IOVEC];
+    psa_outvec           out_vec[PSA_MAX_IOVEC];
+    uint8_t              data[MAILBOX_INLINE_PAYLOAD_SIZE];
+};
+#endif
+
 /* A single slot structure in SPE mailbox queue */
 struct secure_mailbox_slot_t {
     struct mailbox_msg_t msg;
 
     uint8_t              ns_slot_idx;
-    mailbox_msg_handle_t msg_handle;
+    mailbox_msg_handle_t msg_handle;    /* MAILBOX_MSG_NULL_HANDLE if the slot
+                                         * is empty
+                                         */
+#if MAILBOX_INLINE_PAYLOAD_SIZE > 0
+    bool                 is_inline;     /* The vectors are in inline_buf */
+    struct secure_mailbox_inline_buf_t inline_buf;
+#endif
 };
 
 struct secure_mailbox_queue_t {
-    mailbox_queue_status_t       empty_slots;      /* bitmask of empty slots */
+    uint8_t                      free_slots[NUM_MAILBOX_QUEUE_SLOT];
+                                                    /*
+                                                     * Stack of the indexes of
+                                                     * empty slots
+                                                     */
+    uint8_t                      nr_free_slots;     /*
+                                                     * Number of the indexes
+                                                     * in free_slots
+                                                     */
 
     struct secure_mailbox_slot_t queue[NUM_MAILBOX_QUEUE_SLOT];
     struct ns_mailbox_queue_t    *ns_queue;
-    uint8_t                      cur_proc_slot_idx; /*
-                                                     * The index of mailbox
-                                                     * queue slot currently
-                                                     * under processing.
-                                                     */
 };
 
 /**
@@ -55,6 +76,16 @@ int32_t tfm_mailbox_handle_msg(void);
  */
 int32_t tfm_mailbox_reply_msg(mailbox_msg_handle_t handle, int32_t reply);
 
+/**
+ * \brief Get the statistics of the notifications sent to NSPE.
+ *        The average number of replies per notification is
+ *        nr_msgs / nr_notify.
+ *
+ * \param[out] stats            The buffer to be written with
+ *                              \ref mailbox_notify_stats_t.
+ */
+void tfm_mailbox_get_notify_stats(struct mailbox_notify_stats_t *stats);
+
 /**
  * \brief SPE mailbox initialization
  *
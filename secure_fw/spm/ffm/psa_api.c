@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2022 Cypress Semiconductor Corporation (an Infineon
  * company) or an affiliate of Cypress Semiconductor Corporation. All rights
  * reserved.
@@ -21,6 +21,7 @@
 #include "load/partition_defs.h"
 #include "load/service_defs.h"
 #include "load/interrupt_defs.h"
+#include "load/spm_load_api.h"
 #include "ffm/psa_api.h"
 #include "utilities.h"
 #include "ffm/backend.h"
@@ -142,6 +143,38 @@ uint32_t tfm_spm_client_psa_version(uint32_t sid)
     return service->p_ldinf->version;
 }
 
+#if TFM_LVL == 1
+uint32_t tfm_spm_client_psa_version_ns_fast(uint32_t sid)
+{
+    const struct partition_t *p_part;
+    const struct service_load_info_t *p_servldinf;
+    uint32_t i;
+
+    /*
+     * Walk the partition list and the constant service load information
+     * instead of the service list: the partition list is not changed after
+     * initialization, while tfm_spm_get_service_by_sid() reorders the service
+     * list and can preempt this function.
+     */
+    UNI_LIST_FOREACH(p_part, PARTITION_LIST_ADDR, next) {
+        p_servldinf = LOAD_INFO_SERVICE(p_part->p_ldinf);
+        for (i = 0; i < p_part->p_ldinf->nservices; i++) {
+            if (p_servldinf[i].sid != sid) {
+                continue;
+            }
+
+            if (!SERVICE_IS_NS_ACCESSIBLE(p_servldinf[i].flags)) {
+                return PSA_VERSION_NONE;
+            }
+
+            return p_servldinf[i].version;
+        }
+    }
+
+    return PSA_VERSION_NONE;
+}
+#endif /* TFM_LVL == 1 */
+
 psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
                                      uint32_t ctrl_param,
                                      const psa_invec *inptr,
@@ -162,9 +195,19 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
     size_t out_num = (size_t)((ctrl_param & OUT_LEN_MASK) >> OUT_LEN_OFFSET);
     fih_int fih_rc = FIH_FAILURE;
 
-    /* The request type must be zero or positive. */
+    /*
+     * The request type must be zero or positive, except for the reset of an
+     * established connection, which carries no vectors.
+     */
     if (type < 0) {
+#if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
+        if ((type != TFM_IPC_RESET) || IS_STATIC_HANDLE(handle) ||
+            (in_num != 0) || (out_num != 0)) {
+            return PSA_ERROR_PROGRAMMER_ERROR;
+        }
+#else
         return PSA_ERROR_PROGRAMMER_ERROR;
+#endif
     }
 
     /* It is a PROGRAMMER ERROR if in_len + out_len > PSA_MAX_IOVEC. */
@@ -242,6 +285,15 @@ psa_status_t tfm_spm_client_psa_call(psa_handle_t handle,
             /* FixMe: Need to implement a mechanism to resolve this failure. */
             return PSA_ERROR_PROGRAMMER_ERROR;
         }
+
+        /*
+         * The reset is only delivered to the services which declare that they
+         * handle it, the client closes the connection of the others.
+         */
+        if ((type == TFM_IPC_RESET) &&
+            !SERVICE_ENABLED_CONN_RESET(service->p_ldinf->flags)) {
+            return PSA_ERROR_NOT_SUPPORTED;
+        }
 #else
         return PSA_ERROR_PROGRAMMER_ERROR;
 #endif
@@ -795,6 +847,18 @@ psa_status_t tfm_spm_partition_psa_reply(psa_handle_t msg_handle,
          * ignored
          */
         break;
+#if CONFIG_TFM_CONNECTION_BASED_SERVICE_API == 1
+    case TFM_IPC_RESET:
+        /*
+         * The service has released the connection state on success, so the
+         * connection is handed back to the client as a fresh one.
+         */
+        if (status == PSA_SUCCESS) {
+            handle->rhandle = NULL;
+        }
+        ret = status;
+        break;
+#endif
     default:
         if (handle->msg.type >= PSA_IPC_CALL) {
 
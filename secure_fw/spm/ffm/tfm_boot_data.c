@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "array.h"
+#include "config_spm.h"
 #include "tfm_boot_status.h"
 #include "region_defs.h"
 #include "tfm_api.h"
@@ -44,6 +45,27 @@
  */
 static uint32_t is_boot_data_valid = BOOT_DATA_INVALID;
 
+#ifdef BOOT_DATA_AVAILABLE
+/*!
+ * \struct boot_data_major_index
+ *
+ * \brief Location of the TLV entries of one major type in the shared data
+ *        area. It is filled once when the shared data is validated.
+ */
+struct boot_data_major_index {
+    uintptr_t first;     /* Address of the first entry, 0 if there is none */
+    uintptr_t end;       /* End address of the last entry */
+    uint32_t  tot_len;   /* Total size of the entries, headers included */
+};
+
+/*!
+ * \var boot_data_index
+ *
+ * \brief Location of the TLV entries in the shared data area per major type.
+ */
+static struct boot_data_major_index boot_data_index[MAJOR_MASK + 1];
+#endif /* BOOT_DATA_AVAILABLE */
+
 /*!
  * \struct boot_data_access_policy
  *
@@ -117,12 +139,50 @@ void tfm_core_validate_boot_data(void)
 {
 #ifdef BOOT_DATA_AVAILABLE
     struct tfm_boot_data *boot_data;
+    struct shared_data_tlv_entry tlv_entry;
+    struct boot_data_major_index *index;
+    uintptr_t tlv_end, offset;
+    size_t next_tlv_offset;
 
     boot_data = (struct tfm_boot_data *)BOOT_TFM_SHARED_DATA_BASE;
 
-    if (boot_data->header.tlv_magic == SHARED_DATA_TLV_INFO_MAGIC) {
-        is_boot_data_valid = BOOT_DATA_VALID;
+    if ((boot_data->header.tlv_magic != SHARED_DATA_TLV_INFO_MAGIC) ||
+        (boot_data->header.tlv_tot_len > BOOT_TFM_SHARED_DATA_SIZE)) {
+        return;
     }
+
+    /*
+     * Walk the TLV section once to check that every entry is inside the
+     * section and to record where the entries of each major type are, so
+     * that the later requests do not need to walk the whole section.
+     */
+    spm_memset(boot_data_index, 0, sizeof(boot_data_index));
+    tlv_end = BOOT_TFM_SHARED_DATA_BASE + boot_data->header.tlv_tot_len;
+    offset  = BOOT_TFM_SHARED_DATA_BASE + SHARED_DATA_HEADER_SIZE;
+
+    for (; offset < tlv_end; offset += next_tlv_offset) {
+        if (tlv_end - offset < SHARED_DATA_ENTRY_HEADER_SIZE) {
+            return;
+        }
+
+        /* Create local copy to avoid unaligned access */
+        (void)spm_memcpy(&tlv_entry, (const void *)offset,
+                         SHARED_DATA_ENTRY_HEADER_SIZE);
+
+        next_tlv_offset = SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
+        if (tlv_end - offset < next_tlv_offset) {
+            return;
+        }
+
+        index = &boot_data_index[GET_MAJOR(tlv_entry.tlv_type)];
+        if (index->first == 0) {
+            index->first = offset;
+        }
+        index->end = offset + next_tlv_offset;
+        index->tot_len += next_tlv_offset;
+    }
+
+    is_boot_data_valid = BOOT_DATA_VALID;
 #else
     is_boot_data_valid = BOOT_DATA_VALID;
 #endif /* BOOT_DATA_AVAILABLE */
@@ -137,7 +197,8 @@ void tfm_core_get_boot_data_handler(uint32_t args[])
 #ifdef BOOT_DATA_AVAILABLE
     uint8_t *ptr;
     struct shared_data_tlv_entry tlv_entry;
-    uintptr_t tlv_end, offset;
+    const struct boot_data_major_index *index;
+    uintptr_t offset;
     size_t next_tlv_offset;
 #endif /* BOOT_DATA_AVAILABLE */
     struct partition_t *curr_partition = GET_CURRENT_COMPONENT();
@@ -162,34 +223,56 @@ void tfm_core_get_boot_data_handler(uint32_t args[])
         return;
     }
 
-#ifdef BOOT_DATA_AVAILABLE
-    /* Get the boundaries of TLV section */
-    boot_data = (struct tfm_boot_data *)BOOT_TFM_SHARED_DATA_BASE;
-    tlv_end = BOOT_TFM_SHARED_DATA_BASE + boot_data->header.tlv_tot_len;
-    offset  = BOOT_TFM_SHARED_DATA_BASE + SHARED_DATA_HEADER_SIZE;
-#endif /* BOOT_DATA_AVAILABLE */
-
     /* Add header to output buffer as well */
     if (buf_size < SHARED_DATA_HEADER_SIZE) {
         args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
         return;
-    } else {
-        boot_data = (struct tfm_boot_data *)buf_start;
-        boot_data->header.tlv_magic   = SHARED_DATA_TLV_INFO_MAGIC;
-        boot_data->header.tlv_tot_len = SHARED_DATA_HEADER_SIZE;
     }
 
+#ifdef BOOT_DATA_AVAILABLE
+    /* No TLV can have a major type which does not fit in the major field */
+    if (tlv_major > MAJOR_MASK) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+
+    /* Get the entries of the requested major type found at validation */
+    index = &boot_data_index[tlv_major];
+
+    /* Reject a buffer which is too small before anything is copied */
+    if (index->tot_len > (uint32_t)(buf_size - SHARED_DATA_HEADER_SIZE)) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+#endif /* BOOT_DATA_AVAILABLE */
+
+    boot_data = (struct tfm_boot_data *)buf_start;
+    boot_data->header.tlv_magic   = SHARED_DATA_TLV_INFO_MAGIC;
+    boot_data->header.tlv_tot_len = SHARED_DATA_HEADER_SIZE;
+
 #ifdef BOOT_DATA_AVAILABLE
     ptr = boot_data->data;
-    /* Iterates over the TLV section and copy TLVs with requested major
-     * type to the provided buffer.
+    /* Iterates over the part of the TLV section which holds the requested
+     * major type, and copy those TLVs to the provided buffer. The entries
+     * are read again from the shared area, so each of them is checked
+     * against the indexed part of the section and the remaining buffer.
      */
-    for (; offset < tlv_end; offset += next_tlv_offset) {
+    for (offset = index->first; offset < index->end;
+         offset += next_tlv_offset) {
+        if (index->end - offset < SHARED_DATA_ENTRY_HEADER_SIZE) {
+            args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+            return;
+        }
+
         /* Create local copy to avoid unaligned access */
         (void)spm_memcpy(&tlv_entry, (const void *)offset,
                          SHARED_DATA_ENTRY_HEADER_SIZE);
 
         next_tlv_offset = SHARED_DATA_ENTRY_HEADER_SIZE + tlv_entry.tlv_len;
+        if (index->end - offset < next_tlv_offset) {
+            args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+            return;
+        }
 
         if (GET_MAJOR(tlv_entry.tlv_type) == tlv_major) {
             /* Check buffer overflow */
@@ -208,3 +291,80 @@ void tfm_core_get_boot_data_handler(uint32_t args[])
     args[0] = (uint32_t)TFM_SUCCESS;
     return;
 }
+
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+void tfm_core_map_boot_data_handler(uint32_t args[])
+{
+    uint8_t tlv_major = (uint8_t)args[0];
+    const uint8_t **tlv_start = (const uint8_t **)args[1];
+    uint32_t *tlv_len = (uint32_t *)args[2];
+#ifdef BOOT_DATA_AVAILABLE
+    const struct boot_data_major_index *index;
+#endif /* BOOT_DATA_AVAILABLE */
+    struct partition_t *curr_partition = GET_CURRENT_COMPONENT();
+    fih_int fih_rc = FIH_FAILURE;
+
+    FIH_CALL(tfm_hal_memory_check, fih_rc,
+             curr_partition->boundary, (uintptr_t)tlv_start,
+             sizeof(*tlv_start), TFM_HAL_ACCESS_READWRITE);
+    if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+
+    FIH_CALL(tfm_hal_memory_check, fih_rc,
+             curr_partition->boundary, (uintptr_t)tlv_len,
+             sizeof(*tlv_len), TFM_HAL_ACCESS_READWRITE);
+    if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+
+    if (is_boot_data_valid != BOOT_DATA_VALID) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+
+    /* Check whether caller has access right to given tlv_major_type */
+    if (tfm_core_check_boot_data_access_policy(tlv_major)) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+
+    *tlv_start = NULL;
+    *tlv_len = 0;
+
+#ifdef BOOT_DATA_AVAILABLE
+    if (tlv_major > MAJOR_MASK) {
+        args[0] = (uint32_t)TFM_ERROR_INVALID_PARAMETER;
+        return;
+    }
+
+    index = &boot_data_index[tlv_major];
+    if (index->tot_len != 0) {
+        /*
+         * Only the entries of the requested major type may be exposed, so
+         * they have to be contiguous in the shared data area.
+         */
+        if (index->tot_len != index->end - index->first) {
+            args[0] = (uint32_t)TFM_ERROR_NOT_IN_RANGE;
+            return;
+        }
+
+        /* The isolation boundary of the caller must allow reading them */
+        FIH_CALL(tfm_hal_memory_check, fih_rc,
+                 curr_partition->boundary, index->first,
+                 index->tot_len, TFM_HAL_ACCESS_READABLE);
+        if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+            args[0] = (uint32_t)TFM_ERROR_NOT_IN_RANGE;
+            return;
+        }
+
+        *tlv_start = (const uint8_t *)index->first;
+        *tlv_len = index->tot_len;
+    }
+#endif /* BOOT_DATA_AVAILABLE */
+
+    args[0] = (uint32_t)TFM_SUCCESS;
+}
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2020, Arm Limited. All rights reserved.
+ * Copyright (c) 2020-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -9,6 +9,7 @@
 #define __TFM_BOOT_DATA_H__
 
 #include <stdint.h>
+#include "config_spm.h"
 
 /**
  * \brief Retrieve secure partition related data from shared memory area, which
@@ -18,6 +19,17 @@
  */
 void tfm_core_get_boot_data_handler(uint32_t args[]);
 
+#if CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1
+/**
+ * \brief Give the location of secure partition related data in the shared
+ *        memory area, which stores shared data between bootloader and runtime
+ *        firmware, to be read in place by the partition.
+ *
+ * \param[in] args  Pointer to stack frame, which carries input parameters.
+ */
+void tfm_core_map_boot_data_handler(uint32_t args[]);
+#endif /* CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1 */
+
 /**
  * \brief Validate the content of shared memory area, which stores the shared
  *        data between bootloader and runtime firmware.
@@ -17,6 +17,24 @@
 #define CONFIG_TFM_CONN_HANDLE_MAX_NUM 8
 #endif
 
+/* The number of non-secure contexts for NS client extension (TFM_NS_MANAGE_NSID) */
+#ifndef CONFIG_TFM_NS_CTX_NUM
+#pragma message("CONFIG_TFM_NS_CTX_NUM is defaulted to 1. Please check and set it explicitly.")
+#define CONFIG_TFM_NS_CTX_NUM          1
+#endif
+
+/* The number of NS threads holding a context for NS client extension */
+#ifndef CONFIG_TFM_NS_THREAD_NUM
+#pragma message("CONFIG_TFM_NS_THREAD_NUM is defaulted to 8. Please check and set it explicitly.")
+#define CONFIG_TFM_NS_THREAD_NUM       8
+#endif
+
+/* Map the shared boot data into partitions instead of copying it */
+#ifndef CONFIG_TFM_BOOT_DATA_ZERO_COPY
+#pragma message("CONFIG_TFM_BOOT_DATA_ZERO_COPY is defaulted to 0. Please check and set it explicitly.")
+#define CONFIG_TFM_BOOT_DATA_ZERO_COPY 0
+#endif
+
 /* Set the doorbell APIs */
 #ifndef CONFIG_TFM_DOORBELL_API
 #if CONFIG_TFM_SPM_BACKEND_IPC == 1
@@ -30,4 +48,22 @@
 #error "Invalid config: CONFIG_TFM_SPM_BACKEND_SFN AND CONFIG_TFM_DOORBELL_API!"
 #endif
 
+/*
+ * The shared data area is only readable by the partitions at isolation level
+ * 1. The isolation HAL cannot add it to a partition boundary at higher levels.
+ */
+#if (CONFIG_TFM_BOOT_DATA_ZERO_COPY == 1) && defined(TFM_LVL) && (TFM_LVL != 1)
+#error "Invalid config: CONFIG_TFM_BOOT_DATA_ZERO_COPY requires TFM_LVL 1!"
+#endif
+
+/* The context index is carried in 8 bits of the NS client token */
+#if (CONFIG_TFM_NS_CTX_NUM < 1) || (CONFIG_TFM_NS_CTX_NUM > 0xFF)
+#error "Invalid config: CONFIG_TFM_NS_CTX_NUM must be in range [1, 255]!"
+#endif
+
+/* The thread entries are indexed in 8 bits, 0xFF ends a list */
+#if (CONFIG_TFM_NS_THREAD_NUM < 1) || (CONFIG_TFM_NS_THREAD_NUM > 0xFE)
+#error "Invalid config: CONFIG_TFM_NS_THREAD_NUM must be in range [1, 254]!"
+#endif
+
 #endif /* __CONFIG_PARTITION_SPM_H__ */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2019-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -59,6 +59,25 @@ uint32_t tfm_spm_client_psa_framework_version(void);
  */
 uint32_t tfm_spm_client_psa_version(uint32_t sid);
 
+#if TFM_LVL == 1
+/**
+ * \brief handler for \ref psa_version called by the NS agent without
+ *        entering SPM.
+ *
+ * \details This reads the constant service load information only and does
+ *          not touch any SPM runtime state, so it can be called directly from
+ *          the NS agent veneer without the SVC round-trip. The NS caller is
+ *          only required to have the service marked as NS accessible.
+ *
+ * \param[in] sid               RoT Service identity.
+ *
+ * \retval PSA_VERSION_NONE     The RoT Service is not implemented, or the
+ *                              service is not accessible from NSPE.
+ * \retval > 0                  The version of the implemented RoT Service.
+ */
+uint32_t tfm_spm_client_psa_version_ns_fast(uint32_t sid);
+#endif
+
 /**
  * \brief handler for \ref psa_call.
  *
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+ * Copyright (c) 2018-2023, Arm Limited. All rights reserved.
  * Copyright (c) 2022 Cypress Semiconductor Corporation (an Infineon company)
  * or an affiliate of Cypress Semiconductor Corporation. All rights reserved.
  *
@@ -55,4 +55,22 @@ void tfm_nspm_ctx_init(void);
  */
 int32_t tfm_nspm_get_current_client_id(void);
 
+#ifdef TFM_NS_MANAGE_NSID
+/**
+ * \brief SVC handler to get the next released NS client ID for the calling
+ *        partition. See tfm_core_get_ns_client_release().
+ *
+ * \param[in,out] args  The SVC arguments. The status is returned in args[0].
+ */
+void tfm_nspm_get_ns_client_release_handler(uint32_t args[]);
+
+/**
+ * \brief SVC handler to check if an NS client ID is used by an NS thread. See
+ *        tfm_core_is_ns_client_active().
+ *
+ * \param[in,out] args  The SVC arguments. The result is returned in args[0].
+ */
+void tfm_nspm_is_ns_client_active_handler(uint32_t args[]);
+#endif /* TFM_NS_MANAGE_NSID */
+
 #endif /* __TFM_NSPM_H__ */
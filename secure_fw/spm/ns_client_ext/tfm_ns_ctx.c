@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -7,88 +7,218 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "cmsis.h"
+#include "psa/error.h"
 #include "tfm_ns_ctx.h"
 #include "tfm_nspm.h"
 
+#if TFM_NS_THREAD_MAX >= TFM_NS_THREAD_NULL
+#error "Invalid CONFIG_TFM_NS_THREAD_NUM!"
+#endif
+
 /*
  * NS context. Initialized to 0.
  * All contexts are not used as the reference counter is 0 in initialization.
  */
 static struct tfm_ns_ctx_t ns_ctx_data[TFM_NS_CONTEXT_MAX] = {0};
 
+/*
+ * Group ID to context index map. The group ID is 8 bits wide, so a direct
+ * lookup table keeps the search for a group's context constant time no matter
+ * how many contexts are configured. TFM_NS_CONTEXT_MAX marks an unmapped gid.
+ */
+static uint8_t ns_ctx_gid_map[TFM_NS_CONTEXT_GID_NUM];
+
+/* Stack of free context indexes, so allocating a new context is O(1) too */
+static uint8_t ns_ctx_free_list[TFM_NS_CONTEXT_MAX];
+static uint32_t ns_ctx_free_cnt;
+
+/*
+ * The threads holding a context. The threads of a group are linked from the
+ * context of the group, the free entries are linked from ns_thread_free.
+ */
+static struct tfm_ns_thread_t ns_thread_data[TFM_NS_THREAD_MAX];
+static uint8_t ns_thread_free;
+
+/*
+ * The client IDs released by the NS threads. ns_release_seq is the sequence
+ * number of the next record. It never resets, so each partition reading the
+ * records keeps its own sequence number and can tell the records it missed.
+ */
+static int32_t ns_release_records[TFM_NS_RELEASE_RECORD_NUM];
+static uint32_t ns_release_seq;
+
 /* Current active NS context index. Default is invalid index */
 static uint8_t active_ns_ctx_index = TFM_NS_CONTEXT_MAX;
 
+/*
+ * NSID of the active NS context. It is only written with IRQs disabled and a
+ * word read is atomic, so the NSID can be read on each PSA API call without
+ * disabling IRQs.
+ */
+static volatile int32_t active_nsid = TFM_NS_CLIENT_INVALID_ID;
+
+/* Switch the active NS context. Called with IRQs disabled. */
+static void set_active_ns_ctx(uint8_t idx, int32_t nsid)
+{
+    active_ns_ctx_index = idx;
+    active_nsid = nsid;
+}
+
+/* Put a context back to the free list. Called with IRQs disabled. */
+static void free_ns_ctx_slot(uint8_t idx)
+{
+    ns_ctx_gid_map[ns_ctx_data[idx].gid] = TFM_NS_CONTEXT_MAX;
+    ns_ctx_free_list[ns_ctx_free_cnt++] = idx;
+}
+
+/*
+ * Find the thread entry of a thread in the group of a context. A thread which
+ * has not been loaded yet takes an entry not loaded. Called with IRQs disabled.
+ * prev: Output buffer to retrieve the entry linked before the thread, or
+ *       TFM_NS_THREAD_NULL if the thread is the first one.
+ * Return: The index of the thread entry, or TFM_NS_THREAD_NULL if not found.
+ */
+static uint8_t find_ns_thread(uint8_t idx, uint8_t tid, uint8_t *prev)
+{
+    uint8_t i, prev_i = TFM_NS_THREAD_NULL;
+    uint8_t unloaded = TFM_NS_THREAD_NULL, unloaded_prev = TFM_NS_THREAD_NULL;
+
+    for (i = ns_ctx_data[idx].threads; i != TFM_NS_THREAD_NULL;
+         i = ns_thread_data[i].next) {
+        if (!ns_thread_data[i].is_loaded) {
+            if (unloaded == TFM_NS_THREAD_NULL) {
+                unloaded = i;
+                unloaded_prev = prev_i;
+            }
+        } else if (ns_thread_data[i].tid == tid) {
+            *prev = prev_i;
+            return i;
+        }
+        prev_i = i;
+    }
+
+    *prev = unloaded_prev;
+    return unloaded;
+}
+
+/* Record a released client ID for the partitions. Called with IRQs disabled. */
+static void record_ns_client_release(int32_t nsid)
+{
+    if (is_ns_client_active(nsid)) {
+        return;
+    }
+
+    ns_release_records[ns_release_seq & TFM_NS_RELEASE_RECORD_MASK] = nsid;
+    ns_release_seq++;
+}
+
+/*
+ * Free the thread entry of a released thread, found by find_ns_thread().
+ * Called with IRQs disabled.
+ */
+static void release_ns_thread(uint8_t idx, uint8_t i, uint8_t prev)
+{
+    bool is_loaded;
+
+    if (prev == TFM_NS_THREAD_NULL) {
+        ns_ctx_data[idx].threads = ns_thread_data[i].next;
+    } else {
+        ns_thread_data[prev].next = ns_thread_data[i].next;
+    }
+
+    is_loaded = ns_thread_data[i].is_loaded;
+    ns_thread_data[i].is_loaded = false;
+    ns_thread_data[i].next = ns_thread_free;
+    ns_thread_free = i;
+
+    if (is_loaded) {
+        record_ns_client_release(ns_thread_data[i].nsid);
+    }
+}
+
 bool init_ns_ctx(void)
 {
     uint32_t i;
 
+    for (i = 0; i < TFM_NS_CONTEXT_GID_NUM; i++) {
+        ns_ctx_gid_map[i] = TFM_NS_CONTEXT_MAX;
+    }
+
+    /* Fill the free list so that the lower indexes are allocated first */
     for (i = 0; i < TFM_NS_CONTEXT_MAX; i++) {
         /* Only need to ensure the reference counter is 0 */
         ns_ctx_data[i].ref_cnt = 0;
+        ns_ctx_free_list[i] = (uint8_t)(TFM_NS_CONTEXT_MAX - 1 - i);
+    }
+    ns_ctx_free_cnt = TFM_NS_CONTEXT_MAX;
+
+    for (i = 0; i < TFM_NS_THREAD_MAX; i++) {
+        ns_thread_data[i].is_loaded = false;
+        ns_thread_data[i].next = (i + 1 < TFM_NS_THREAD_MAX) ?
+                                 (uint8_t)(i + 1) : TFM_NS_THREAD_NULL;
     }
+    ns_thread_free = 0;
+    ns_release_seq = 0;
 
-    active_ns_ctx_index = TFM_NS_CONTEXT_MAX;
+    set_active_ns_ctx(TFM_NS_CONTEXT_MAX, TFM_NS_CLIENT_INVALID_ID);
     return true;
 }
 
 bool acquire_ns_ctx(uint8_t gid, uint8_t *idx)
 {
-    /* Only support one context slot for now */
-    uint32_t i;
-    uint32_t empty_ctx_idx = TFM_NS_CONTEXT_MAX; /* default is invalid */
+    uint8_t ctx_idx, thread;
 
     __disable_irq();
-    /*
-     * Go through all context slots to get the context for the given group ID.
-     * It will not take a long time as the context number should be limited.
-     */
-    for (i = 0; i < TFM_NS_CONTEXT_MAX; i++) {
-        if (ns_ctx_data[i].ref_cnt > 0) {  /* This context has been taken */
-            if (ns_ctx_data[i].gid == gid) {
-                /*
-                 * Found the context associated with the input group ID.
-                 * Check if the thread number reached the limit.
-                 */
-                if (ns_ctx_data[i].ref_cnt < TFM_NS_CONTEXT_MAX_TID) {
-                    /* Reuse this context and increase the reference number */
-                    ns_ctx_data[i].ref_cnt++;
-                    *idx = i;
-                    __enable_irq();
-                    return true;
-                } else {
-                    /* No more thread for this group */
-                    __enable_irq();
-                    return false;
-                }
-            }
-        } else {    /* Found an empty context slot */
-            /* Save the first unused context index and continue */
-            if (empty_ctx_idx == TFM_NS_CONTEXT_MAX) {
-                empty_ctx_idx = i;
-            }
-            /*
-             * Still need to go through the remaining slots to check if there
-             * is an existing context assigned to the given group ID.
-             */
-        }
-    }
 
-    /* No existing context for the group ID, use the first free context */
-    if (empty_ctx_idx < TFM_NS_CONTEXT_MAX) {
-        ns_ctx_data[empty_ctx_idx].ref_cnt++;
-        ns_ctx_data[empty_ctx_idx].gid = gid;
-        *idx = empty_ctx_idx;
+    /* Each thread takes an entry to track its client ID */
+    if (ns_thread_free == TFM_NS_THREAD_NULL) {
         __enable_irq();
-        return true;
+        return false;   /* No available thread entry */
+    }
+
+    ctx_idx = ns_ctx_gid_map[gid];
+    if (ctx_idx < TFM_NS_CONTEXT_MAX) {
+        /*
+         * Found the context associated with the input group ID.
+         * Check if the thread number reached the limit.
+         */
+        if (ns_ctx_data[ctx_idx].ref_cnt < TFM_NS_CONTEXT_MAX_TID) {
+            /* Reuse this context and increase the reference number */
+            ns_ctx_data[ctx_idx].ref_cnt++;
+        } else {
+            /* No more thread for this group */
+            __enable_irq();
+            return false;
+        }
     } else {
-        __enable_irq();
-        return false;   /* No available context */
+        /* No existing context for the group ID, take a free context */
+        if (ns_ctx_free_cnt == 0) {
+            __enable_irq();
+            return false;   /* No available context */
+        }
+
+        ctx_idx = ns_ctx_free_list[--ns_ctx_free_cnt];
+        ns_ctx_data[ctx_idx].ref_cnt = 1;
+        ns_ctx_data[ctx_idx].gid = gid;
+        ns_ctx_data[ctx_idx].threads = TFM_NS_THREAD_NULL;
+        ns_ctx_gid_map[gid] = ctx_idx;
     }
+
+    thread = ns_thread_free;
+    ns_thread_free = ns_thread_data[thread].next;
+    ns_thread_data[thread].is_loaded = false;
+    ns_thread_data[thread].next = ns_ctx_data[ctx_idx].threads;
+    ns_ctx_data[ctx_idx].threads = thread;
+
+    *idx = ctx_idx;
+    __enable_irq();
+    return true;
 }
 
 bool release_ns_ctx(uint8_t gid, uint8_t tid, uint8_t idx)
 {
+    uint8_t thread, prev;
+
     /* Check if the index is in range */
     if (idx >= TFM_NS_CONTEXT_MAX) {
         return false;
@@ -96,39 +226,39 @@ bool release_ns_ctx(uint8_t gid, uint8_t tid, uint8_t idx)
 
     __disable_irq();
 
-    /* Check if the context belongs to that group  */
-    if (ns_ctx_data[idx].gid != gid) {
+    /* Check if the context is allocated and belongs to that group */
+    if ((ns_ctx_data[idx].gid != gid) || (ns_ctx_data[idx].ref_cnt == 0)) {
         __enable_irq();
         return false;
     }
 
     /*
-     * If it is to release the current active context, then set active context
+     * Each thread holding the context has an entry in the thread list, so the
+     * reference counter is the length of the list. A thread without an entry
+     * does not hold the context. In particular, the active thread keeps its
+     * own entry, so the release of another thread cannot drop the last
+     * reference of the active context.
+     */
+    thread = find_ns_thread(idx, tid, &prev);
+    if (thread == TFM_NS_THREAD_NULL) {
+        __enable_irq();
+        return false;
+    }
+
+    /*
+     * If it is to release the current active thread, then set active context
      * to invalid.
-     * Otherwise, just de-reference the context
      */
-    if (idx == active_ns_ctx_index) {
-        if (ns_ctx_data[idx].tid == tid) {
-            /* Release the currrent active thread */
-            if (ns_ctx_data[idx].ref_cnt > 0) {
-                ns_ctx_data[idx].ref_cnt--;
-            }
-            active_ns_ctx_index = TFM_NS_CONTEXT_MAX;
-        } else {
-            /*
-             * Release for another thread in the active context
-             * As there's an active thread ongoing, so the ref_counter should
-             * be at least 1 after the release.
-             */
-            if (ns_ctx_data[idx].ref_cnt > 1) {
-                ns_ctx_data[idx].ref_cnt--;
-            }
-        }
-    } else {
-        /* Release in the non-active context */
-        if (ns_ctx_data[idx].ref_cnt > 0) {
-            ns_ctx_data[idx].ref_cnt--;
-        }
+    if ((idx == active_ns_ctx_index) && (ns_ctx_data[idx].tid == tid)) {
+        set_active_ns_ctx(TFM_NS_CONTEXT_MAX, TFM_NS_CLIENT_INVALID_ID);
+    }
+
+    ns_ctx_data[idx].ref_cnt--;
+    release_ns_thread(idx, thread, prev);
+
+    /* The last thread of the group is gone, the context can be reused */
+    if (ns_ctx_data[idx].ref_cnt == 0) {
+        free_ns_ctx_slot(idx);
     }
 
     __enable_irq();
@@ -137,6 +267,8 @@ bool release_ns_ctx(uint8_t gid, uint8_t tid, uint8_t idx)
 
 bool load_ns_ctx(uint8_t gid, uint8_t tid, int32_t nsid, uint8_t idx)
 {
+    uint8_t thread, prev;
+
     /* Check if the index is in range */
     if (idx >= TFM_NS_CONTEXT_MAX) {
         return false;
@@ -152,7 +284,16 @@ bool load_ns_ctx(uint8_t gid, uint8_t tid, int32_t nsid, uint8_t idx)
 
     ns_ctx_data[idx].tid = tid;
     ns_ctx_data[idx].nsid = nsid;
-    active_ns_ctx_index = idx;
+
+    /* Keep the client ID of the thread until the thread is released */
+    thread = find_ns_thread(idx, tid, &prev);
+    if (thread != TFM_NS_THREAD_NULL) {
+        ns_thread_data[thread].tid = tid;
+        ns_thread_data[thread].nsid = nsid;
+        ns_thread_data[thread].is_loaded = true;
+    }
+
+    set_active_ns_ctx(idx, nsid);
     __enable_irq();
     return true;
 }
@@ -175,21 +316,50 @@ bool save_ns_ctx(uint8_t gid, uint8_t tid, uint8_t idx)
     }
 
     /* Set active context index to invalid */
-    active_ns_ctx_index = TFM_NS_CONTEXT_MAX;
+    set_active_ns_ctx(TFM_NS_CONTEXT_MAX, TFM_NS_CLIENT_INVALID_ID);
     __enable_irq();
     return true;
 }
 
 int32_t get_nsid_from_active_ns_ctx(void)
 {
-    int32_t ret = TFM_NS_CLIENT_INVALID_ID;
+    return active_nsid;
+}
+
+int32_t get_ns_client_release(uint32_t *seq, int32_t *nsid)
+{
+    uint32_t nr_records;
 
     __disable_irq();
 
-    if (active_ns_ctx_index < TFM_NS_CONTEXT_MAX) {
-        ret = ns_ctx_data[active_ns_ctx_index].nsid;
+    nr_records = ns_release_seq - *seq;
+    if (nr_records == 0) {
+        __enable_irq();
+        return PSA_ERROR_DOES_NOT_EXIST;
     }
 
+    /* The records not read in time have been overwritten */
+    if (nr_records > TFM_NS_RELEASE_RECORD_NUM) {
+        *seq = ns_release_seq;
+        __enable_irq();
+        return PSA_ERROR_INSUFFICIENT_MEMORY;
+    }
+
+    *nsid = ns_release_records[*seq & TFM_NS_RELEASE_RECORD_MASK];
+    (*seq)++;
     __enable_irq();
-    return ret;
+    return PSA_SUCCESS;
+}
+
+bool is_ns_client_active(int32_t nsid)
+{
+    uint32_t i;
+
+    for (i = 0; i < TFM_NS_THREAD_MAX; i++) {
+        if (ns_thread_data[i].is_loaded && (ns_thread_data[i].nsid == nsid)) {
+            return true;
+        }
+    }
+
+    return false;
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
@@ -9,25 +9,56 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "config_spm.h"
 
-/* Supported maximum context for NS. Only support single context for now. */
-#define TFM_NS_CONTEXT_MAX                  1
+/* Supported maximum context for NS. Also used as the invalid context index. */
+#define TFM_NS_CONTEXT_MAX                  CONFIG_TFM_NS_CTX_NUM
+
+/* Number of group IDs, as carried by the 8-bit gid field in the token */
+#define TFM_NS_CONTEXT_GID_NUM              0x100
 
 #define TFM_NS_CONTEXT_MAX_TID              0xFF
 
-/* Non-secure context structure */
+/* Number of NS client threads whose client ID is tracked */
+#define TFM_NS_THREAD_MAX                   CONFIG_TFM_NS_THREAD_NUM
+
+/* Marks the end of a list of thread entries */
+#define TFM_NS_THREAD_NULL                  0xFF
+
+/* Number of NS client release records kept for the partitions. Power of 2. */
+#define TFM_NS_RELEASE_RECORD_NUM           8
+#define TFM_NS_RELEASE_RECORD_MASK          (TFM_NS_RELEASE_RECORD_NUM - 1)
+
+/*
+ * Non-secure context structure. It only holds the client identity of a thread
+ * group. The secure calls of all the contexts run on the single stack of the
+ * NS agent.
+ */
 struct tfm_ns_ctx_t {
     int32_t nsid;       /* Non-secure Client ID, must be < 0 */
     uint8_t gid;        /* Group ID. Threads in same group share one context */
     uint8_t tid;        /* Thread ID. Used to identify threads in same group */
     uint8_t ref_cnt;    /* The number of threads sharing this context */
+    uint8_t threads;    /* First entry of the threads in the group */
+};
+
+/*
+ * A non-secure client thread which acquired a context. The client ID is known
+ * once the thread is loaded.
+ */
+struct tfm_ns_thread_t {
+    int32_t nsid;       /* Non-secure Client ID of the thread when loaded */
+    uint8_t tid;        /* Thread ID, valid if is_loaded */
+    uint8_t next;       /* Next entry in the group, or in the free list */
+    bool    is_loaded;  /* The thread has been loaded at least once */
 };
 
 /* Initialize the non-secure context */
 bool init_ns_ctx(void);
 
 /*
- * Acquire the non-secure context for a non-secure client thread
+ * Acquire the non-secure context for a non-secure client thread. It fails if
+ * TFM_NS_THREAD_MAX threads have acquired a context already.
  * gid: The group ID of the thread. The threads in one group share one context.
  * idx: Output buffer to retrieve the index of the allocated context.
  * Return: bool type to indicate success of the context allocation.
@@ -35,7 +66,8 @@ bool init_ns_ctx(void);
 bool acquire_ns_ctx(uint8_t gid, uint8_t *idx);
 
 /*
- * Release the non-secure context for a non-secure client thread
+ * Release the non-secure context for a non-secure client thread. The client ID
+ * of the thread is recorded as released, unless another thread still uses it.
  * gid: The group ID of the thread. The threads in one group share one context.
  * tid: The thread ID.
  * idx: The context index for that thread.
@@ -68,4 +100,22 @@ bool save_ns_ctx(uint8_t gid, uint8_t tid, uint8_t idx);
  */
 int32_t get_nsid_from_active_ns_ctx(void);
 
+/*
+ * Get the next released non-secure client ID for a partition.
+ * seq: The sequence number of the next record the partition reads. It is
+ *      advanced past the record read, or past the records dropped.
+ * nsid: Output buffer to retrieve the released non-secure client ID.
+ * Return: PSA_SUCCESS if a record is read, PSA_ERROR_DOES_NOT_EXIST if there
+ *         is no new record, PSA_ERROR_INSUFFICIENT_MEMORY if records were
+ *         dropped before they were read. The partition should then check its
+ *         non-secure clients with is_ns_client_active().
+ */
+int32_t get_ns_client_release(uint32_t *seq, int32_t *nsid);
+
+/*
+ * Check if a non-secure client ID is used by a thread holding a context.
+ * Return: true if a loaded thread has the client ID.
+ */
+bool is_ns_client_active(int32_t nsid);
+
 #endif  /* __TFM_NS_CTX_H__ */
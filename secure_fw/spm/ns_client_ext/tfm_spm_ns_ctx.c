@@ -1,13 +1,20 @@
 /*
- * Copyright (c) 2021, Arm Limited. All rights reserved.
+ * Copyright (c) 2021-2023, Arm Limited. All rights reserved.
  *
  * SPDX-License-Identifier: BSD-3-Clause
  *
  */
 
+#include "cmsis.h"
+#include "current.h"
+#include "fih.h"
+#include "spm_ipc.h"
+#include "tfm_hal_isolation.h"
 #include "tfm_nspm.h"
 #include "tfm_ns_ctx.h"
 #include "tfm_ns_client_ext.h"
+#include "utilities.h"
+#include "psa/error.h"
 
 #define DEFAULT_NS_CLIENT_ID ((int32_t)-1)
 
@@ -30,3 +37,42 @@ void tfm_nspm_ctx_init(void)
     }
 #endif
 }
+
+#ifdef TFM_NS_MANAGE_NSID
+void tfm_nspm_get_ns_client_release_handler(uint32_t args[])
+{
+    uint32_t *seq = (uint32_t *)args[0];
+    int32_t *nsid = (int32_t *)args[1];
+    struct partition_t *curr_partition = GET_CURRENT_COMPONENT();
+    fih_int fih_rc = FIH_FAILURE;
+
+    FIH_CALL(tfm_hal_memory_check, fih_rc,
+             curr_partition->boundary, (uintptr_t)seq,
+             sizeof(*seq), TFM_HAL_ACCESS_READWRITE);
+    if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+        args[0] = (uint32_t)PSA_ERROR_PROGRAMMER_ERROR;
+        return;
+    }
+
+    FIH_CALL(tfm_hal_memory_check, fih_rc,
+             curr_partition->boundary, (uintptr_t)nsid,
+             sizeof(*nsid), TFM_HAL_ACCESS_READWRITE);
+    if (fih_not_eq(fih_rc, fih_int_encode(PSA_SUCCESS))) {
+        args[0] = (uint32_t)PSA_ERROR_PROGRAMMER_ERROR;
+        return;
+    }
+
+    args[0] = (uint32_t)get_ns_client_release(seq, nsid);
+}
+
+void tfm_nspm_is_ns_client_active_handler(uint32_t args[])
+{
+    bool is_active;
+
+    __disable_irq();
+    is_active = is_ns_client_active((int32_t)args[0]);
+    __enable_irq();
+
+    args[0] = is_active ? 1U : 0U;
+}
+#endif /* TFM_NS_MANAGE_NSID */
@@ -1,5 +1,5 @@
 #-------------------------------------------------------------------------------
-# Copyright (c) 2018-2022, Arm Limited. All rights reserved.
+# Copyright (c) 2018-2023, Arm Limited. All rights reserved.
 # Copyright (c) 2022 Cypress Semiconductor Corporation (an Infineon company)
 # or an affiliate of Cypress Semiconductor Corporation. All rights reserved.
 #
@@ -150,6 +150,11 @@ def manifest_validation(manifest, pid):
         elif 'connection_based' not in service:
             raise Exception("'connection_based' is mandatory in FF-M 1.1 service!")
 
+        # TF-M specific: accept TFM_IPC_RESET messages on connections
+        if service.get('connection_reset', 'disable') == 'enable' and \
+           not service['connection_based']:
+            raise Exception("'connection_reset' of {} requires 'connection_based'!".format(service['name']))
+
         if 'version' not in service.keys():
             service['version'] = 1
         if 'version_policy' not in service.keys():